@@ -0,0 +1,982 @@
+/*
+ * Nerve — Benchmark suite
+ * Copyright 2022-2026 Fatih Kucukkarakurt <fatihkucukkarakurt@gmail.com>
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Times the hot paths of nerve.h and of the headers under studies/ over a
+ * fixed matrix of sizes, and prints one JSON document to stdout so two
+ * releases can be diffed:
+ *
+ *   net_compute                     one sample through an MLP
+ *   net_compute_batch               a batch through the tiled kernels
+ *   net_qcompute / net_hcompute     one sample, int8 / fp16 and bf16 weights
+ *   net_scompute                    one sample, 80% of the weights pruned
+ *   net_train_epoch                 one epoch, per optimizer and batch size
+ *   net_train_dataset               one pass over a raw float file
+ *   net_load / net_bload            a text / binary file back into memory
+ *   nerve_infer_forward             one token, float and int8 weights
+ *   nerve_embed_text                one sentence to one vector
+ *   ng_backward                     the backward pass of an autograd MLP
+ *   nd_fit                          a short equation search
+ *
+ * Every network, dataset and model file is drawn from fixed seeds, so the
+ * work done is identical from run to run and from machine to machine; only
+ * the clock differs. The model files are written next to the binary and
+ * removed again at exit.
+ *
+ * Each case runs once to warm up, then its operation is repeated until one
+ * sample lasts at least --min-sample seconds, so even a 50 ns call is timed
+ * well above the clock's resolution. Samples are then taken until --reps of
+ * them exist or --budget seconds have passed (but never fewer than five).
+ * A sample is the mean time per operation over its `iters` calls, so the
+ * report gives the median of the samples ("median_us") and their 99th
+ * percentile ("p99_sample_us"): the slowest samples' per-call mean, which
+ * is one call's tail latency only when "iters" is 1. Next to them comes
+ * throughput: samples/s or tokens/s, GFLOP/s from the multiply-adds the
+ * shapes imply, and GB/s of weights or file read.
+ *
+ * Build:  gcc -O2 -std=c99 nerve_bench.c -o nerve_bench -lm -pthread
+ * Run:    ./nerve_bench > bench.json
+ *         ./nerve_bench --quick --filter net_compute
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#define NERVE_IMPLEMENTATION
+#include "../nerve.h"
+#define NERVE_INFER_IMPLEMENTATION
+#include "../studies/infer/nerve_infer.h"
+#define NERVE_EMBED_IMPLEMENTATION
+#include "../studies/embed/nerve_embed.h"
+#define NERVE_GRAD_IMPLEMENTATION
+#include "../studies/autograd/nerve_grad.h"
+#define NERVE_DISCOVER_IMPLEMENTATION
+#include "../nerve_discover.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_SAMPLES 1000
+#define MIN_SAMPLES 5
+
+/* ── Clock ──────────────────────────────────────────────────────────────── */
+#if defined(CLOCK_MONOTONIC)
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+}
+#else
+static double now(void) { return (double)clock() / CLOCKS_PER_SEC; }
+#endif
+
+/* ── Options ────────────────────────────────────────────────────────────── */
+static int         g_quick      = 0;
+static int         g_reps       = 100;
+static double      g_budget     = 1.0;
+static double      g_min_sample = 0.002;
+static const char *g_filter     = NULL;
+
+/* ── Cases ──────────────────────────────────────────────────────────────── */
+/* One operation of a case is one call of `run`. When `prep` is set it runs
+ * before every operation outside the timed region, at the cost of two clock
+ * reads per operation instead of two per sample. `items`, `flops` and
+ * `bytes` are per operation; zero leaves the matching rate out. */
+typedef struct {
+    char        name[32];
+    char        params[160];
+    void      (*prep)(void *ctx);
+    void      (*run)(void *ctx);
+    void       *ctx;
+    double      items;
+    const char *unit;               /* "samples" or "tokens"             */
+    double      flops, bytes;
+} bench_case;
+
+static int g_first = 1;
+
+static double time_ops(const bench_case *c, long iters)
+{
+    double t0, t = 0.0;
+    long   i;
+    if (!c->prep) {
+        t0 = now();
+        for (i = 0; i < iters; i++) c->run(c->ctx);
+        return now() - t0;
+    }
+    for (i = 0; i < iters; i++) {
+        c->prep(c->ctx);
+        t0 = now();
+        c->run(c->ctx);
+        t += now() - t0;
+    }
+    return t;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void run_case(const bench_case *c)
+{
+    static double s[MAX_SAMPLES];
+    double start, med, p99;
+    long   iters = 1;
+    int    n = 0;
+
+    if (g_filter && !strstr(c->name, g_filter)) return;
+    fprintf(stderr, "%-20s %s\n", c->name, c->params);
+
+    if (c->prep) c->prep(c->ctx);
+    c->run(c->ctx);                         /* warm caches and allocators */
+    while (time_ops(c, iters) < g_min_sample && iters < (1L << 24))
+        iters *= 2;
+
+    start = now();
+    while (n < g_reps && (n < MIN_SAMPLES || now() - start < g_budget))
+        s[n++] = time_ops(c, iters) / (double)iters;
+    qsort(s, (size_t)n, sizeof(double), cmp_double);
+    med = (n & 1) ? s[n / 2] : 0.5 * (s[n / 2 - 1] + s[n / 2]);
+    p99 = s[(int)((0.99 * n) + 0.999999) - 1];
+
+    printf("%s    {\"name\": \"%s\", \"params\": {%s},\n",
+           g_first ? "" : ",\n", c->name, c->params);
+    printf("     \"samples\": %d, \"iters\": %ld, "
+           "\"median_us\": %.4f, \"p99_sample_us\": %.4f",
+           n, iters, med * 1e6, p99 * 1e6);
+    if (c->items > 0.0)
+        printf(", \"%s_per_s\": %.1f", c->unit, c->items / med);
+    if (c->flops > 0.0)
+        printf(", \"gflops\": %.3f", c->flops / med * 1e-9);
+    if (c->bytes > 0.0)
+        printf(", \"gbps\": %.3f", c->bytes / med * 1e-9);
+    printf("}");
+    fflush(stdout);
+    g_first = 0;
+}
+
+/* ── Data ───────────────────────────────────────────────────────────────── */
+static float uniform(float amp) { return amp * (2.0f * nerve_rand_float() - 1.0f); }
+
+static float *random_floats(long n, float amp)
+{
+    float *p = (float *)malloc((size_t)n * sizeof(float));
+    long   i;
+    if (!p) { fprintf(stderr, "nerve_bench: out of memory\n"); exit(1); }
+    for (i = 0; i < n; i++) p[i] = uniform(amp);
+    return p;
+}
+
+/* Parses "784-512-256-10" into sizes[], returns the layer count. */
+static int parse_shape(const char *shape, int *sizes)
+{
+    int n = 0;
+    while (*shape && n < 8) {
+        sizes[n++] = (int)strtol(shape, (char **)&shape, 10);
+        if (*shape == '-') shape++;
+    }
+    return n;
+}
+
+static network_t *make_net(const char *shape, int optimizer)
+{
+    int        sizes[8], layers = parse_shape(shape, sizes);
+    network_t *net;
+    nerve_seed(1);
+    net = net_allocate_l(layers, sizes);
+    if (!net) { fprintf(stderr, "nerve_bench: net_allocate %s\n", shape); exit(1); }
+    net_set_activation(net, NERVENET_ACTIVATION_RELU);
+    net_initialize_he(net);
+    net_set_optimizer(net, optimizer);
+    net_set_learning_rate(net, optimizer == NERVENET_OPTIMIZER_SGD ? 0.01f : 0.001f);
+    return net;
+}
+
+/* Temporary files, removed at exit. */
+static char g_files[16][64];
+static int  g_no_of_files = 0;
+
+static const char *temp_file(const char *name)
+{
+    char *p = g_files[g_no_of_files++];
+    sprintf(p, "nerve_bench_%s.tmp", name);
+    return p;
+}
+
+static void remove_files(void)
+{
+    int i;
+    for (i = 0; i < g_no_of_files; i++) remove(g_files[i]);
+}
+
+static long file_size(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    long  n;
+    if (!f) return 0;
+    fseek(f, 0, SEEK_END);
+    n = ftell(f);
+    fclose(f);
+    return n;
+}
+
+static void put_i32(FILE *f, int v) { fwrite(&v, sizeof(int), 1, f); }
+
+static void put_floats(FILE *f, long n, float amp)
+{
+    long i;
+    for (i = 0; i < n; i++) {
+        float v = amp > 0.0f ? uniform(amp) : 1.0f;
+        fwrite(&v, sizeof(float), 1, f);
+    }
+}
+
+static void put_zeros(FILE *f, long n)
+{
+    float z = 0.0f;
+    long  i;
+    for (i = 0; i < n; i++) fwrite(&z, sizeof(float), 1, f);
+}
+
+/* An int8 tensor as nerve_i__map_weights_q reads it: rows scales, then
+ * rows*cols signed bytes. */
+static void put_int8(FILE *f, long rows, long cols, float amp)
+{
+    float s = amp / 127.0f;
+    long  i;
+    for (i = 0; i < rows; i++) fwrite(&s, sizeof(float), 1, f);
+    for (i = 0; i < rows * cols; i++) {
+        signed char q = (signed char)(int)uniform(127.0f);
+        fwrite(&q, 1, 1, f);
+    }
+}
+
+/* ── net_compute ────────────────────────────────────────────────────────── */
+typedef struct {
+    network_t *net;
+    float     *in, out[16];
+    int        n_in, next;
+} compute_ctx;
+
+#define COMPUTE_ROWS 64
+
+static void run_compute(void *p)
+{
+    compute_ctx *c = (compute_ctx *)p;
+    net_compute(c->net, c->in + (long)c->next * c->n_in, c->out);
+    c->next = (c->next + 1) % COMPUTE_ROWS;
+}
+
+static void bench_compute(const char *shape)
+{
+    compute_ctx c;
+    bench_case  b;
+    double      w;
+    int         sizes[8];
+    parse_shape(shape, sizes);
+    c.net  = make_net(shape, NERVENET_OPTIMIZER_SGD);
+    c.n_in = sizes[0];
+    c.in   = random_floats((long)COMPUTE_ROWS * c.n_in, 1.0f);
+    c.next = 0;
+    w = (double)net_get_no_of_weights(c.net);
+
+    memset(&b, 0, sizeof b);
+    strcpy(b.name, "net_compute");
+    sprintf(b.params, "\"shape\": \"%s\"", shape);
+    b.run = run_compute; b.ctx = &c;
+    b.items = 1.0; b.unit = "samples";
+    b.flops = 2.0 * w; b.bytes = 4.0 * w;
+    run_case(&b);
+
+    free(c.in);
+    net_free(c.net);
+}
+
+/* ── net_compute_batch ──────────────────────────────────────────────────── */
+typedef struct {
+    network_t *net;
+    float     *in, *out;
+    int        n;
+} batch_ctx;
+
+static void run_compute_batch(void *p)
+{
+    batch_ctx *c = (batch_ctx *)p;
+    net_compute_batch(c->net, c->in, c->n, c->out);
+}
+
+static void bench_compute_batch(const char *shape, int n)
+{
+    batch_ctx  c;
+    bench_case b;
+    double     w;
+    int        sizes[8], layers = parse_shape(shape, sizes);
+    c.net = make_net(shape, NERVENET_OPTIMIZER_SGD);
+    c.n   = n;
+    c.in  = random_floats((long)n * sizes[0], 1.0f);
+    c.out = random_floats((long)n * sizes[layers - 1], 0.0f);
+    w = (double)net_get_no_of_weights(c.net);
+
+    /* Each tile of NERVENET_BATCH_TILE samples reads the weights once. */
+    memset(&b, 0, sizeof b);
+    strcpy(b.name, "net_compute_batch");
+    sprintf(b.params, "\"shape\": \"%s\", \"n\": %d", shape, n);
+    b.run = run_compute_batch; b.ctx = &c;
+    b.items = (double)n; b.unit = "samples";
+    b.flops = 2.0 * w * n;
+    b.bytes = 4.0 * w * ((n + NERVENET_BATCH_TILE - 1) / NERVENET_BATCH_TILE);
+    run_case(&b);
+
+    free(c.in); free(c.out);
+    net_free(c.net);
+}
+
+/* ── net_qcompute / net_hcompute / net_scompute ─────────────────────────── */
+/* The inference-only copies of one network, each run one sample at a time
+ * like net_compute. */
+typedef struct {
+    qnetwork_t *q;
+    hnetwork_t *h;
+    snetwork_t *s;
+    float      *in, out[16];
+    int         n_in, next;
+} copy_ctx;
+
+static void run_qcompute(void *p)
+{
+    copy_ctx *c = (copy_ctx *)p;
+    net_qcompute(c->q, c->in + (long)c->next * c->n_in, c->out);
+    c->next = (c->next + 1) % COMPUTE_ROWS;
+}
+
+static void run_hcompute(void *p)
+{
+    copy_ctx *c = (copy_ctx *)p;
+    net_hcompute(c->h, c->in + (long)c->next * c->n_in, c->out);
+    c->next = (c->next + 1) % COMPUTE_ROWS;
+}
+
+static void run_scompute(void *p)
+{
+    copy_ctx *c = (copy_ctx *)p;
+    net_scompute(c->s, c->in + (long)c->next * c->n_in, c->out);
+    c->next = (c->next + 1) % COMPUTE_ROWS;
+}
+
+static void bench_copies(const char *shape)
+{
+    static const char *half_names[] = { "fp16", "bf16" };
+    network_t *net;
+    copy_ctx   c;
+    bench_case b;
+    double     w, nnz;
+    int        i, sizes[8];
+    parse_shape(shape, sizes);
+    net = make_net(shape, NERVENET_OPTIMIZER_SGD);
+    memset(&c, 0, sizeof c);
+    c.n_in = sizes[0];
+    c.in   = random_floats((long)COMPUTE_ROWS * c.n_in, 1.0f);
+    w = (double)net_get_no_of_weights(net);
+
+    c.q = net_quantize(net);
+    if (!c.q) { fprintf(stderr, "nerve_bench: net_quantize %s\n", shape); exit(1); }
+    memset(&b, 0, sizeof b);
+    strcpy(b.name, "net_qcompute");
+    sprintf(b.params, "\"shape\": \"%s\"", shape);
+    b.run = run_qcompute; b.ctx = &c;
+    b.items = 1.0; b.unit = "samples";
+    b.flops = 2.0 * w; b.bytes = w;
+    run_case(&b);
+    net_qfree(c.q);
+
+    for (i = 0; i < 2; i++) {
+        c.h = net_half(net, i ? NERVENET_HALF_BF16 : NERVENET_HALF_FP16);
+        if (!c.h) { fprintf(stderr, "nerve_bench: net_half %s\n", shape); exit(1); }
+        memset(&b, 0, sizeof b);
+        strcpy(b.name, "net_hcompute");
+        sprintf(b.params, "\"shape\": \"%s\", \"format\": \"%s\"",
+                shape, half_names[i]);
+        b.run = run_hcompute; b.ctx = &c;
+        b.items = 1.0; b.unit = "samples";
+        b.flops = 2.0 * w; b.bytes = 2.0 * w;
+        run_case(&b);
+        net_hfree(c.h);
+    }
+
+    /* Each kept weight is a float value and an int column. */
+    nnz = w - (double)net_prune(net, 0.8f);
+    if (nnz > w || !(c.s = net_sparsify(net))) {
+        fprintf(stderr, "nerve_bench: net_sparsify %s\n", shape);
+        exit(1);
+    }
+    memset(&b, 0, sizeof b);
+    strcpy(b.name, "net_scompute");
+    sprintf(b.params, "\"shape\": \"%s\", \"sparsity\": 0.8", shape);
+    b.run = run_scompute; b.ctx = &c;
+    b.items = 1.0; b.unit = "samples";
+    b.flops = 2.0 * nnz; b.bytes = 8.0 * nnz;
+    run_case(&b);
+    net_sfree(c.s);
+
+    free(c.in);
+    net_free(net);
+}
+
+/* ── net_train_epoch ────────────────────────────────────────────────────── */
+typedef struct {
+    network_t *net;
+    float     *x, *y;
+    int        n, n_in, n_out, batch;
+} train_ctx;
+
+static void run_train(void *p)
+{
+    train_ctx *c = (train_ctx *)p;
+    net_train_epoch(c->net, c->x, c->y, c->n, c->n_in, c->n_out, c->batch);
+}
+
+static const char *optimizer_name(int opt)
+{
+    return opt == NERVENET_OPTIMIZER_SGD  ? "sgd"  :
+           opt == NERVENET_OPTIMIZER_ADAM ? "adam" : "adamw";
+}
+
+static void bench_train(const char *shape, int n, int optimizer, int batch)
+{
+    train_ctx  c;
+    bench_case b;
+    double     w, steps;
+    int        sizes[8], layers = parse_shape(shape, sizes);
+    c.net   = make_net(shape, optimizer);
+    c.n     = n;
+    c.n_in  = sizes[0];
+    c.n_out = sizes[layers - 1];
+    c.batch = batch;
+    c.x     = random_floats((long)n * c.n_in, 1.0f);
+    c.y     = random_floats((long)n * c.n_out, 1.0f);
+    w       = (double)net_get_no_of_weights(c.net);
+    steps   = (double)((n + batch - 1) / batch);
+
+    /* A multiply-add per weight forward, two backward (the deltas and the
+     * gradient), and the optimizer's per-weight step once per batch. */
+    memset(&b, 0, sizeof b);
+    strcpy(b.name, "net_train_epoch");
+    sprintf(b.params, "\"shape\": \"%s\", \"optimizer\": \"%s\", "
+            "\"batch\": %d, \"n\": %d", shape, optimizer_name(optimizer), batch, n);
+    b.run = run_train; b.ctx = &c;
+    b.items = (double)n; b.unit = "samples";
+    b.flops = 6.0 * w * n +
+              (optimizer == NERVENET_OPTIMIZER_SGD ? 3.0 : 16.0) * w * steps;
+    run_case(&b);
+
+    free(c.x); free(c.y);
+    net_free(c.net);
+}
+
+/* ── net_train_dataset ──────────────────────────────────────────────────── */
+typedef struct {
+    network_t       *net;
+    nerve_dataset_t *ds;
+    int              batch;
+} dataset_ctx;
+
+static void run_train_dataset(void *p)
+{
+    dataset_ctx *c = (dataset_ctx *)p;
+    if (net_train_dataset(c->net, c->ds, c->batch) < 0.0f) {
+        fprintf(stderr, "nerve_bench: net_train_dataset failed\n");
+        exit(1);
+    }
+}
+
+static void bench_train_dataset(const char *shape, int n, int batch)
+{
+    dataset_ctx c;
+    bench_case  b;
+    const char *path;
+    FILE       *f;
+    double      w, steps;
+    int         i, sizes[8], layers = parse_shape(shape, sizes);
+    char        name[48];
+
+    /* The same pass as net_train_epoch, but read back from a raw float
+     * file through the dataset's decode thread. */
+    sprintf(name, "dataset_%s", shape);
+    path = temp_file(name);
+    f = fopen(path, "wb");
+    if (!f) { fprintf(stderr, "nerve_bench: cannot write %s\n", path); exit(1); }
+    for (i = 0; i < n; i++) {
+        put_floats(f, sizes[0], 1.0f);
+        put_floats(f, sizes[layers - 1], 1.0f);
+    }
+    fclose(f);
+
+    c.net   = make_net(shape, NERVENET_OPTIMIZER_SGD);
+    c.batch = batch;
+    c.ds    = nerve_dataset_raw(path, sizes[0], sizes[layers - 1],
+                                NERVENET_DATA_F32);
+    if (!c.ds) { fprintf(stderr, "nerve_bench: cannot open %s\n", path); exit(1); }
+    w     = (double)net_get_no_of_weights(c.net);
+    steps = (double)((n + batch - 1) / batch);
+
+    memset(&b, 0, sizeof b);
+    strcpy(b.name, "net_train_dataset");
+    sprintf(b.params, "\"shape\": \"%s\", \"batch\": %d, \"n\": %d",
+            shape, batch, n);
+    b.run = run_train_dataset; b.ctx = &c;
+    b.items = (double)n; b.unit = "samples";
+    b.flops = 6.0 * w * n + 3.0 * w * steps;
+    b.bytes = (double)file_size(path);
+    run_case(&b);
+
+    nerve_dataset_free(c.ds);
+    net_free(c.net);
+}
+
+/* ── net_load / net_bload ───────────────────────────────────────────────── */
+typedef struct {
+    const char *path;
+    int         binary;
+} load_ctx;
+
+static void run_load(void *p)
+{
+    load_ctx  *c = (load_ctx *)p;
+    network_t *net = c->binary ? net_bload(c->path) : net_load(c->path);
+    if (!net) { fprintf(stderr, "nerve_bench: cannot load %s\n", c->path); exit(1); }
+    net_free(net);
+}
+
+static void bench_load(const char *shape, const char *tag)
+{
+    network_t *net = make_net(shape, NERVENET_OPTIMIZER_SGD);
+    load_ctx   c[2];
+    bench_case b;
+    char       name[48];
+    int        i;
+
+    sprintf(name, "%s.net", tag); c[0].path = temp_file(name); c[0].binary = 0;
+    sprintf(name, "%s.bin", tag); c[1].path = temp_file(name); c[1].binary = 1;
+    if (net_save(c[0].path, net) < 0 || net_bsave(c[1].path, net) < 0) {
+        fprintf(stderr, "nerve_bench: cannot write %s\n", c[0].path);
+        exit(1);
+    }
+    net_free(net);
+
+    for (i = 0; i < 2; i++) {
+        memset(&b, 0, sizeof b);
+        strcpy(b.name, c[i].binary ? "net_bload" : "net_load");
+        sprintf(b.params, "\"shape\": \"%s\", \"file_bytes\": %ld",
+                shape, file_size(c[i].path));
+        b.run = run_load; b.ctx = &c[i];
+        b.bytes = (double)file_size(c[i].path);
+        run_case(&b);
+    }
+}
+
+/* ── nerve_infer_forward ────────────────────────────────────────────────── */
+typedef struct {
+    nerve_transformer t;
+    int               pos, token;
+} infer_ctx;
+
+/* Feeds its own argmax back in, walking every position of the context so
+ * the attention cost is the average over it. */
+static void run_infer(void *p)
+{
+    infer_ctx *c = (infer_ctx *)p;
+    float     *logits = nerve_infer_forward(&c->t, c->token, c->pos);
+    int        i, best = 0;
+    for (i = 1; i < c->t.config.vocab_size; i++)
+        if (logits[i] > logits[best]) best = i;
+    c->token = best;
+    c->pos   = (c->pos + 1) % c->t.config.seq_len;
+}
+
+static void write_nrv(const char *path, int dim, int hid, int L, int heads,
+                      int vocab, int seq, int quantized)
+{
+    FILE *f = fopen(path, "wb");
+    long  d = dim, h = hid, l = L, v = vocab;
+    float rope = 10000.0f, amp = 0.05f;
+    char  pad[NERVE_NRV_HEADER];
+    if (!f) { fprintf(stderr, "nerve_bench: cannot write %s\n", path); exit(1); }
+    memset(pad, 0, sizeof pad);
+    fwrite(NERVE_NRV_MAGIC, 1, 4, f);
+    put_i32(f, 1);
+    put_i32(f, dim); put_i32(f, hid); put_i32(f, L);
+    put_i32(f, heads); put_i32(f, heads); put_i32(f, vocab); put_i32(f, seq);
+    put_i32(f, 1 | (quantized << 1));                  /* shared classifier */
+    fwrite(&rope, sizeof(float), 1, f);
+    fwrite(pad, 1, NERVE_NRV_HEADER - 44, f);
+
+    if (!quantized) {
+        put_floats(f, v * d, amp);
+        put_floats(f, l * d, 0.0f);
+        put_floats(f, 4 * l * d * d, amp);              /* wq wk wv wo      */
+        put_floats(f, l * d, 0.0f);
+        put_floats(f, 3 * l * d * h, amp);              /* w1 w2 w3         */
+        put_floats(f, d, 0.0f);
+    } else {
+        put_int8(f, v, d, amp);
+        put_floats(f, l * d, 0.0f);
+        put_int8(f, l * d, d, amp); put_int8(f, l * d, d, amp);
+        put_int8(f, l * d, d, amp); put_int8(f, l * d, d, amp);
+        put_floats(f, l * d, 0.0f);
+        put_int8(f, l * h, d, amp); put_int8(f, l * d, h, amp);
+        put_int8(f, l * h, d, amp);
+        put_floats(f, d, 0.0f);
+    }
+    fclose(f);
+}
+
+static void bench_infer(int dim, int hid, int L, int heads, int vocab,
+                        int seq, int quantized)
+{
+    infer_ctx   c;
+    bench_case  b;
+    const char *path;
+    char        name[48];
+    double      d = dim, h = hid, l = L, v = vocab;
+
+    sprintf(name, "d%d_%s.nrv", dim, quantized ? "int8" : "f32");
+    path = temp_file(name);
+    nerve_seed(1);
+    write_nrv(path, dim, hid, L, heads, vocab, seq, quantized);
+    memset(&c, 0, sizeof c);
+    if (nerve_infer_load(&c.t, path) != 0) {
+        fprintf(stderr, "nerve_bench: cannot load %s\n", path);
+        exit(1);
+    }
+
+    memset(&b, 0, sizeof b);
+    strcpy(b.name, "nerve_infer_forward");
+    sprintf(b.params, "\"weights\": \"%s\", \"dim\": %d, \"hidden\": %d, "
+            "\"layers\": %d, \"heads\": %d, \"vocab\": %d, \"seq_len\": %d",
+            quantized ? "int8" : "f32", dim, hid, L, heads, vocab, seq);
+    b.run = run_infer; b.ctx = &c;
+    b.items = 1.0; b.unit = "tokens";
+    b.flops = 2.0 * (l * (4.0 * d * d + 3.0 * d * h) + v * d);
+    b.bytes = (double)c.t.data_size;
+    run_case(&b);
+
+    nerve_infer_free(&c.t);
+}
+
+/* ── nerve_embed_text ───────────────────────────────────────────────────── */
+typedef struct {
+    nerve_embed_t m;
+    char         *text;
+    float        *out;
+} embed_ctx;
+
+static void run_embed(void *p)
+{
+    embed_ctx *c = (embed_ctx *)p;
+    nerve_embed_text(&c->m, c->text, c->out);
+}
+
+/* Token 0 is [PAD], 100-102 are [UNK] [CLS] [SEP]; every other id i is the
+ * one-piece word "w<i>", so a sentence of n words is exactly n+2 tokens. */
+static void write_nemb(const char *path, const char *vocab_path, int H,
+                       int L, int heads, int I, int vocab, int max_pos)
+{
+    FILE *f = fopen(path, "wb");
+    long  h = H, i_ = I, l;
+    int   i;
+    char  pad[64];
+    if (!f) { fprintf(stderr, "nerve_bench: cannot write %s\n", path); exit(1); }
+    memset(pad, 0, sizeof pad);
+    fwrite("NEMB", 1, 4, f);
+    put_i32(f, 1);
+    put_i32(f, H); put_i32(f, L); put_i32(f, heads); put_i32(f, I);
+    put_i32(f, vocab); put_i32(f, max_pos); put_i32(f, 0);
+    fwrite(pad, 1, 64 - 36, f);
+
+    put_floats(f, (long)vocab * h + (long)max_pos * h + 2 * h, 0.05f);
+    put_floats(f, h, 0.0f); put_zeros(f, h);
+    for (l = 0; l < L; l++) {
+        for (i = 0; i < 4; i++) { put_floats(f, h * h, 0.05f); put_zeros(f, h); }
+        put_floats(f, h, 0.0f); put_zeros(f, h);
+        put_floats(f, i_ * h, 0.05f); put_zeros(f, i_);
+        put_floats(f, h * i_, 0.05f); put_zeros(f, h);
+        put_floats(f, h, 0.0f); put_zeros(f, h);
+    }
+    fclose(f);
+
+    f = fopen(vocab_path, "wb");
+    if (!f) { fprintf(stderr, "nerve_bench: cannot write %s\n", vocab_path); exit(1); }
+    for (i = 0; i < vocab; i++) {
+        if      (i == 0)   fputs("[PAD]\n", f);
+        else if (i == 100) fputs("[UNK]\n", f);
+        else if (i == 101) fputs("[CLS]\n", f);
+        else if (i == 102) fputs("[SEP]\n", f);
+        else               fprintf(f, "w%d\n", i);
+    }
+    fclose(f);
+}
+
+static void bench_embed(int H, int L, int heads, int I, int vocab, int words)
+{
+    embed_ctx   c;
+    bench_case  b;
+    const char *path, *vocab_path;
+    char        name[48];
+    double      n = words + 2, h = H, i_ = I;
+    int         i, len = 0;
+
+    sprintf(name, "h%d.nemb", H);      path = temp_file(name);
+    sprintf(name, "h%d.vocab", H);     vocab_path = temp_file(name);
+    nerve_seed(1);
+    write_nemb(path, vocab_path, H, L, heads, I, vocab, NERVE_EMB_MAXT);
+    memset(&c, 0, sizeof c);
+    if (nerve_embed_load(&c.m, path, vocab_path) != 0) {
+        fprintf(stderr, "nerve_bench: cannot load %s\n", path);
+        exit(1);
+    }
+    c.text = (char *)malloc((size_t)words * 8 + 1);
+    c.out  = (float *)malloc((size_t)H * sizeof(float));
+    c.text[0] = '\0';
+    for (i = 0; i < words; i++)
+        len += sprintf(c.text + len, "%sw%d", i ? " " : "",
+                       103 + (int)(nerve_rand_float() * (vocab - 103)));
+
+    /* The six projections per token, plus the scores and the weighted sum of
+     * the values, each a multiply-add over every pair of tokens. */
+    memset(&b, 0, sizeof b);
+    strcpy(b.name, "nerve_embed_text");
+    sprintf(b.params, "\"hidden\": %d, \"layers\": %d, \"heads\": %d, "
+            "\"intermediate\": %d, \"tokens\": %d", H, L, heads, I, words + 2);
+    b.run = run_embed; b.ctx = &c;
+    b.items = n; b.unit = "tokens";
+    b.flops = 2.0 * L * (n * (4.0 * h * h + 2.0 * h * i_) + 2.0 * n * n * h);
+    run_case(&b);
+
+    free(c.text); free(c.out);
+    nerve_embed_free(&c.m);
+}
+
+/* ── ng_backward ────────────────────────────────────────────────────────── */
+typedef struct {
+    tensor *params[4], *x, *loss;
+    int    *y;
+} grad_ctx;
+
+/* Records a fresh forward tape; only the backward pass over it is timed. */
+static void prep_grad(void *p)
+{
+    grad_ctx *c = (grad_ctx *)p;
+    tensor   *h;
+    ng_end_step();
+    ng_zero_grad(c->params, 4);
+    h = t_relu(t_add_bias(t_matmul(c->x, c->params[0]), c->params[1]));
+    c->loss = t_softmax_cross_entropy(
+        t_add_bias(t_matmul(h, c->params[2]), c->params[3]), c->y);
+}
+
+static void run_grad(void *p)
+{
+    grad_ctx *c = (grad_ctx *)p;
+    ng_backward(c->loss);
+}
+
+static void free_tensor(tensor *t) { free(t->data); free(t->grad); free(t); }
+
+static void bench_grad(int batch, int n_in, int hidden, int n_out)
+{
+    grad_ctx   c;
+    bench_case b;
+    int        i, j, rows[4] = { 0, 1, 0, 1 };
+    int        cols[4];
+    double     macs = (double)batch * ((double)n_in * hidden + (double)hidden * n_out);
+
+    cols[0] = cols[1] = hidden;
+    cols[2] = cols[3] = n_out;
+    rows[0] = n_in; rows[2] = hidden;
+    nerve_seed(1);
+    for (i = 0; i < 4; i++) {
+        c.params[i] = t_param(rows[i], cols[i]);
+        for (j = 0; j < rows[i] * cols[i]; j++)
+            c.params[i]->data[j] = uniform(0.1f);
+    }
+    c.x = t_param(batch, n_in);
+    for (j = 0; j < batch * n_in; j++) c.x->data[j] = uniform(1.0f);
+    c.y = (int *)malloc((size_t)batch * sizeof(int));
+    for (j = 0; j < batch; j++) c.y[j] = (int)(nerve_rand_float() * n_out);
+
+    /* Each matmul backward is two matmuls the size of its forward one. */
+    memset(&b, 0, sizeof b);
+    strcpy(b.name, "ng_backward");
+    sprintf(b.params, "\"shape\": \"%d-%d-%d\", \"batch\": %d",
+            n_in, hidden, n_out, batch);
+    b.prep = prep_grad; b.run = run_grad; b.ctx = &c;
+    b.items = (double)batch; b.unit = "samples";
+    b.flops = 4.0 * macs;
+    run_case(&b);
+
+    ng_end_step();
+    for (i = 0; i < 4; i++) free_tensor(c.params[i]);
+    free_tensor(c.x);
+    free(c.y);
+}
+
+/* ── nd_fit ─────────────────────────────────────────────────────────────── */
+typedef struct {
+    double    *X, *y;
+    int        n, nvars;
+    nd_options opt;
+} discover_ctx;
+
+static void run_discover(void *p)
+{
+    discover_ctx *c = (discover_ctx *)p;
+    nd_expr      *e = nd_fit(c->X, c->y, c->n, c->nvars, c->opt);
+    if (!e) { fprintf(stderr, "nerve_bench: nd_fit failed\n"); exit(1); }
+    nd_free(e);
+}
+
+static void bench_discover(int n, int population, int generations)
+{
+    discover_ctx c;
+    bench_case   b;
+    int          i;
+
+    /* y = x0^3 - x0 + 0.5 x1, the kind of law studies/discover looks for. */
+    nerve_seed(1);
+    c.n = n; c.nvars = 2;
+    c.X = (double *)malloc((size_t)n * 2 * sizeof(double));
+    c.y = (double *)malloc((size_t)n * sizeof(double));
+    for (i = 0; i < n; i++) {
+        double a = uniform(2.0f), s = uniform(2.0f);
+        c.X[2 * i] = a; c.X[2 * i + 1] = s;
+        c.y[i] = a * a * a - a + 0.5 * s;
+    }
+    c.opt = nd_defaults();
+    c.opt.population  = population;
+    c.opt.generations = generations;
+    c.opt.seed        = 1;
+
+    memset(&b, 0, sizeof b);
+    strcpy(b.name, "nd_fit");
+    sprintf(b.params, "\"n\": %d, \"population\": %d, \"generations\": %d",
+            n, population, generations);
+    b.run = run_discover; b.ctx = &c;
+    run_case(&b);
+
+    free(c.X); free(c.y);
+}
+
+/* ── Main ───────────────────────────────────────────────────────────────── */
+static void usage(void)
+{
+    fprintf(stderr,
+        "usage: nerve_bench [--quick] [--filter NAME] [--reps N]\n"
+        "                   [--budget SECONDS] [--min-sample SECONDS]\n"
+        "  --quick       the smaller sizes only, a quarter of the budget\n"
+        "  --filter      only cases whose name contains NAME\n"
+        "  --reps        most samples per case            (default 100)\n"
+        "  --budget      seconds per case once five exist (default 1)\n"
+        "  --min-sample  shortest timed sample in seconds (default 0.002)\n");
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    static const char *compute_shapes[] = { "2-16-1", "64-256-10", "784-512-256-10" };
+    static const char *train_shapes[]   = { "64-256-10", "784-512-256-10" };
+    static const int   optimizers[]     = { NERVENET_OPTIMIZER_SGD,
+                                            NERVENET_OPTIMIZER_ADAM,
+                                            NERVENET_OPTIMIZER_ADAMW };
+    static const int   batches[]        = { 1, 32, 256 };
+    int i, j, k, big;
+
+    for (i = 1; i < argc; i++) {
+        if      (!strcmp(argv[i], "--quick"))                    g_quick = 1;
+        else if (!strcmp(argv[i], "--filter") && i + 1 < argc)   g_filter = argv[++i];
+        else if (!strcmp(argv[i], "--reps") && i + 1 < argc)     g_reps = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--budget") && i + 1 < argc)   g_budget = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--min-sample") && i + 1 < argc)
+            g_min_sample = atof(argv[++i]);
+        else usage();
+    }
+    if (g_reps < MIN_SAMPLES) g_reps = MIN_SAMPLES;
+    if (g_reps > MAX_SAMPLES) g_reps = MAX_SAMPLES;
+    if (g_quick) g_budget *= 0.25;
+    big = !g_quick;
+    atexit(remove_files);
+
+    printf("{\n  \"nerve\": \"%s\",\n  \"quick\": %s,\n", net_get_version(),
+           g_quick ? "true" : "false");
+    printf("  \"build\": {\"simd\": %s, \"openmp\": %s, \"fast_math\": %s, "
+           "\"profile\": %s},\n",
+#ifdef NERVENET_SIMD
+           "true",
+#else
+           "false",
+#endif
+#ifdef _OPENMP
+           "true",
+#else
+           "false",
+#endif
+#ifdef NERVENET_FAST_MATH
+           "true",
+#else
+           "false",
+#endif
+#ifdef NERVENET_PROFILE
+           "true"
+#else
+           "false"
+#endif
+           );
+    printf("  \"results\": [\n");
+
+    for (i = 0; i < 2 + big; i++)
+        bench_compute(compute_shapes[i]);
+    for (i = 0; i < 1 + big; i++)
+        bench_compute_batch(train_shapes[i], 256);
+    for (i = 0; i < 1 + big; i++)
+        bench_copies(train_shapes[i]);
+    for (i = 0; i < 1 + big; i++)
+        for (j = 0; j < 3; j++)
+            for (k = 0; k < 3; k++)
+                bench_train(train_shapes[i], 256, optimizers[j], batches[k]);
+    for (i = 0; i < 1 + big; i++)
+        bench_train_dataset(train_shapes[i], 256, 32);
+    bench_load("64-256-10", "small");
+    if (big) bench_load("784-512-256-10", "mnist");
+    for (k = 0; k < 2; k++) {
+        bench_infer(128, 384, 4, 4, 4096, 128, k);
+        if (big) bench_infer(288, 768, 6, 6, 32000, 256, k);
+    }
+    bench_embed(128, 2, 4, 512, 4096, 16);
+    if (big) {
+        bench_embed(384, 6, 12, 1536, 8192, 16);
+        bench_embed(384, 6, 12, 1536, 8192, 126);
+    }
+    bench_grad(32, 64, 128, 10);
+    if (big) bench_grad(256, 784, 256, 10);
+    bench_discover(64, 200, 5);
+    if (big) bench_discover(256, 500, 10);
+
+    printf("\n  ]\n}\n");
+    return 0;
+}
@@ -18,7 +18,7 @@
  * The simplest possible neural network example.
  * Trains a 2-4-1 MLP to learn the XOR function using Adam + Xavier init.
  *
- * Build:  gcc -O2 01_xor.c -o xor -lm
+ * Build:  gcc -O2 01_xor.c -o xor -lm -pthread
  * Run:    ./xor
  */
 
@@ -21,7 +21,7 @@
  * After training, renders a side-by-side ASCII plot of
  * the true function vs the learned approximation.
  *
- * Build:  gcc -O2 02_sine.c -o sine -lm
+ * Build:  gcc -O2 02_sine.c -o sine -lm -pthread
  * Run:    ./sine
  */
 
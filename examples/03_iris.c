@@ -26,7 +26,7 @@
  *   1 = Iris versicolor
  *   2 = Iris virginica
  *
- * Build:  gcc -O2 03_iris.c -o iris -lm
+ * Build:  gcc -O2 03_iris.c -o iris -lm -pthread
  * Run:    ./iris
  */
 
@@ -22,7 +22,7 @@
  * Dataset: UCI Auto MPG (40-sample subset, Quinlan 1993)
  * Architecture: 4-8-8-1 | Adam + Tanh | Xavier Init
  *
- * Build:  gcc -O2 05_regression.c -o regression -lm
+ * Build:  gcc -O2 05_regression.c -o regression -lm -pthread
  * Run:    ./regression
  */
 
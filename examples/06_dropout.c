@@ -26,7 +26,7 @@
  * With dropout=0.5 the network cannot memorise 10 outliers and instead
  * learns the true circular boundary.
  *
- * Build:  gcc -O2 06_dropout.c -o dropout -lm
+ * Build:  gcc -O2 06_dropout.c -o dropout -lm -pthread
  * Run:    ./dropout
  */
 
@@ -22,7 +22,7 @@
  *
  * Architecture: 2-32-32-3 | Adam + ReLU | He Init
  *
- * Build:  gcc -O2 07_spiral.c -o spiral -lm
+ * Build:  gcc -O2 07_spiral.c -o spiral -lm -pthread
  * Run:    ./spiral
  */
 
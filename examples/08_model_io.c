@@ -25,7 +25,7 @@
  * This pattern enables cold-start deployment: ship the .net file,
  * load on start-up, run inference with zero training cost.
  *
- * Build:  gcc -O2 08_model_io.c -o model_io -lm
+ * Build:  gcc -O2 08_model_io.c -o model_io -lm -pthread
  * Run:    ./model_io
  */
 
@@ -160,7 +160,7 @@ int main(void)
     printf("Phase 1: early training (100 epochs, lr=0.0008)...\n");
     for (i = 1; i <= 100; i++) {
         mse = net_train_epoch(net, train_in, train_tgt,
-                              N_TRAIN, N_IN, N_OUT, N_TRAIN);
+                              N_TRAIN, N_IN, N_OUT, 1);
         if (i % 25 == 0) {
             acc1 = net_compute_accuracy(net, test_in, test_tgt,
                                         N_TEST, N_IN, N_OUT);
@@ -203,7 +203,7 @@ int main(void)
     printf("\nPhase 2: fine-tuning (600 epochs, lr=0.006)...\n");
     for (i = 1; i <= 600; i++) {
         mse = net_train_epoch(loaded, train_in, train_tgt,
-                              N_TRAIN, N_IN, N_OUT, N_TRAIN);
+                              N_TRAIN, N_IN, N_OUT, 1);
         if (i % 150 == 0) {
             acc3 = net_compute_accuracy(loaded, test_in, test_tgt,
                                         N_TEST, N_IN, N_OUT);
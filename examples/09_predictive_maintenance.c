@@ -29,7 +29,7 @@
  *
  * Architecture: 4-16-8-4 | Adam + ReLU | He Init
  *
- * Build:  gcc -O2 09_predictive_maintenance.c -o maintenance -lm
+ * Build:  gcc -O2 09_predictive_maintenance.c -o maintenance -lm -pthread
  * Run:    ./maintenance
  */
 
@@ -223,7 +223,7 @@ int main(void)
     printf("Training...\n");
     for (i = 1; i <= 1000; i++) {
         mse = net_train_epoch(net, train_in, train_tgt,
-                              N_TRAIN, N_IN, N_OUT, N_TRAIN);
+                              N_TRAIN, N_IN, N_OUT, 1);
         if (i % 200 == 0) {
             acc = net_compute_accuracy(net, test_in, test_tgt,
                                        N_TEST, N_IN, N_OUT);
@@ -19,12 +19,24 @@
  * neuroevolution (tournament selection + Gaussian mutation).
  * After each generation the best brain is showcased live in the terminal.
  *
+ * The brains form one net_population_t: while most snakes are alive, every
+ * tick evaluates all 100 in a single net_population_compute call, and each
+ * generation is bred in one net_population_breed sweep.
+ *
  * Architecture : 11 inputs -> 16 hidden -> 3 outputs
  * Inputs       : danger (3) | direction one-hot (4) | food direction (4)
  * Outputs      : turn-left / straight / turn-right  (argmax)
  *
- * Build : gcc -O2 10_snake_ai.c -o snake_ai -lm
+ * Build : gcc -O2 10_snake_ai.c -o snake_ai -lm -pthread
  * Run   : ./snake_ai
+ *
+ * Headless : ./snake_ai --headless [generations [seed]]   (default 100)
+ *            No drawing and no sleeps: each generation is played as fast as
+ *            the CPU allows and reported as one line with its throughput.
+ *            Build with -fopenmp to spread the long-lived snakes over
+ *            OMP_NUM_THREADS threads; every snake draws food from its own
+ *            nerve_rng_t, seeded in order, so a run's results do not depend
+ *            on the thread count.
  */
 
 /* Ask the C library for the POSIX declarations this example needs (nanosleep,
@@ -44,6 +56,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#if defined(_OPENMP)
+#  include <omp.h>
+#endif
 
 #ifdef _WIN32
 #  include <windows.h>
@@ -53,6 +68,8 @@ static void enable_vt100(void) {
     DWORD  m; GetConsoleMode(h, &m);
     SetConsoleMode(h, m | 0x0004);
 }
+/* wall-clock seconds, for the headless throughput counters */
+static double wall_seconds(void) { return (double)GetTickCount() / 1000.0; }
 #else
 #  include <unistd.h>
 /* usleep() was removed from POSIX.1-2008; nanosleep() is its replacement. */
@@ -64,6 +81,12 @@ static void SLEEP_MS(long ms)
     nanosleep(&ts, NULL);
 }
 static void enable_vt100(void) {}
+static double wall_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
 #endif
 
 /* ---- constants -------------------------------------------------------- */
@@ -109,11 +132,17 @@ typedef struct {
     int  score;
     int  steps;
     int  starve;
+    int  evals;          /* brain evaluations this game */
+    nerve_rng_t rng;     /* this snake's food generator */
     float fitness;
-    network_t *brain;
 } Snake;
 
-static Snake pop[POP];
+static Snake pop[POP];               /* snake i is played by member i */
+static int   rank[POP];              /* members, fittest first        */
+static net_population_t *brains;
+static network_t *scratch;           /* template, showcase, fresh brains */
+static network_t **unpacked;         /* one per thread, for lone games */
+static int n_unpacked;
 
 /* ---- board helpers ----------------------------------------------------- */
 static int is_body(const Snake *s, int x, int y)
@@ -124,10 +153,16 @@ static int is_body(const Snake *s, int x, int y)
     return 0;
 }
 
+/* A private stream per snake, so snakes can play in parallel */
+static int snake_rand_below(Snake *s, int bound)
+{
+    return (int)nerve_rng_below(&s->rng, (unsigned long)bound);
+}
+
 static void place_food(Snake *s)
 {
     int x, y;
-    do { x = (int)nerve_rand_below(BW); y = (int)nerve_rand_below(BH); }
+    do { x = snake_rand_below(s, BW); y = snake_rand_below(s, BH); }
     while ((x == s->bx[0] && y == s->by[0]) || is_body(s,x,y));
     s->fx = x; s->fy = y;
 }
@@ -140,6 +175,8 @@ static void reset_snake(Snake *s)
     s->len   = 3; s->dir = UP;
     s->alive = 1; s->score = 0;
     s->steps = 0; s->starve = 0;
+    s->evals = 0;
+    nerve_rng_seed(&s->rng, nerve_rand_u32());
     s->fitness = 0.0f;
     place_food(s);
 }
@@ -172,15 +209,13 @@ static void get_inputs(const Snake *s, float *inp)
     inp[10] = (s->fx < hx) ? 1.0f : 0.0f;
 }
 
-/* ---- one game step ---------------------------------------------------- */
-static void step_snake(Snake *s)
+/* ---- one game step, given the brain's outputs ------------------------- */
+static void step_snake(Snake *s, const float *out)
 {
-    float inp[N_IN], out[N_OUT];
     int dec, nd, nx, ny, i;
 
     if (!s->alive) return;
-    get_inputs(s, inp);
-    net_compute(s->brain, inp, out);
+    s->evals++;
 
     dec = 1;
     if (out[0] > out[dec]) dec = 0;
@@ -267,99 +302,184 @@ static void draw(const Snake *s, int gen, int best_all, float best_fit)
 }
 
 /* ---- neuroevolution --------------------------------------------------- */
-static int cmp_desc(const void *a, const void *b)
+static int cmp_rank(const void *a, const void *b)
 {
-    const Snake *sa = (const Snake *)a;
-    const Snake *sb = (const Snake *)b;
-    if (sb->fitness > sa->fitness) return  1;
-    if (sb->fitness < sa->fitness) return -1;
+    float fa = pop[*(const int *)a].fitness;
+    float fb = pop[*(const int *)b].fitness;
+    if (fb > fa) return  1;
+    if (fb < fa) return -1;
     return 0;
 }
 
-static void mutate(network_t *net, float rate, float strength)
+/* The ELITE best survive unchanged, the rest are children of two distinct
+ * elites, and the last three are fresh random brains. */
+static void evolve_brains(void)
 {
-    int l, nu, nl;
-    for (l = 1; l < net->no_of_layers; l++)
-        for (nu = 0; nu < net->layer[l].no_of_neurons; nu++)
-            for (nl = 0; nl <= net->layer[l-1].no_of_neurons; nl++)
-                if (nerve_rand_float() < rate) {
-                    float u1 = nerve_rand_float() + 1e-7f;
-                    float u2 = nerve_rand_float();
-                    float z  = (float)sqrt(-2.0*log((double)u1))
-                             * (float)cos(6.28318530718*(double)u2);
-                    net->layer[l].neuron[nu].weight[nl] += strength * z;
-                }
+    int pa[POP], pb[POP], i, p1, p2;
+
+    for (i = 0; i < ELITE; i++) pa[i] = pb[i] = rank[i];
+    for (i = ELITE; i < POP; i++) {
+        p1 = (int)nerve_rand_below(ELITE);
+        p2 = ((int)nerve_rand_below(ELITE - 1) + p1 + 1) % ELITE;
+        pa[i] = rank[p1];
+        pb[i] = rank[p2];
+    }
+    net_population_breed(brains, pa, pb, ELITE, 0.12f, 0.25f);
+
+    for (i = POP - 3; i < POP; i++) {
+        net_randomize(scratch, 1.0f);
+        net_population_set(brains, i, scratch);
+    }
 }
 
-static void crossover(network_t *c, const network_t *p1, const network_t *p2)
+/* ---- evaluate entire population -------------------------------------- */
+/* Play one snake to the end on this thread's unpacked copy of its brain */
+static void finish_game(Snake *s, int member)
 {
-    int l, nu, nl;
-    for (l = 1; l < c->no_of_layers; l++)
-        for (nu = 0; nu < c->layer[l].no_of_neurons; nu++)
-            for (nl = 0; nl <= c->layer[l-1].no_of_neurons; nl++)
-                c->layer[l].neuron[nu].weight[nl] =
-                    (nerve_rand_float() < 0.5f)
-                    ? p1->layer[l].neuron[nu].weight[nl]
-                    : p2->layer[l].neuron[nu].weight[nl];
+    float inp[N_IN], out[N_OUT];
+    network_t *brain;
+#if defined(_OPENMP)
+    brain = unpacked[omp_get_thread_num()];
+#else
+    brain = unpacked[0];
+#endif
+    net_population_get(brains, member, brain);
+    while (s->alive) {
+        get_inputs(s, inp);
+        net_compute(brain, inp, out);
+        step_snake(s, out);
+    }
 }
 
-static void evolve_brains(void)
+/* Reset serially (each reset draws a food seed from Nerve's generator), then
+ * play all games in lockstep, every brain in one pass per tick, with dead
+ * snakes' outputs ignored. Game lengths vary widely, and once fewer than
+ * two thirds are alive the pass costs more than evaluating the survivors
+ * one by one, so each is unpacked and finishes its game alone; those games
+ * share nothing, so they run in parallel. Ends with rank[] sorted by
+ * fitness. */
+static void play_generation(void)
 {
-    int i, p1, p2;
-    for (i = ELITE; i < POP; i++) {
-        p1 = (int)nerve_rand_below(ELITE);
-        p2 = ((int)nerve_rand_below(ELITE - 1) + p1 + 1) % ELITE;
-        crossover(pop[i].brain, pop[p1].brain, pop[p2].brain);
-        mutate(pop[i].brain, 0.12f, 0.25f);
+    static float inp[POP * N_IN], out[POP * N_OUT];
+    int i, alive;
+
+    for (i = 0; i < POP; i++) reset_snake(&pop[i]);
+    do {
+        for (i = 0; i < POP; i++) get_inputs(&pop[i], inp + i * N_IN);
+        net_population_compute(brains, inp, out);
+        for (alive = 0, i = 0; i < POP; i++) {
+            step_snake(&pop[i], out + i * N_OUT);
+            alive += pop[i].alive;
+        }
+    } while (3 * alive >= 2 * POP);
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+    for (i = 0; i < POP; i++)
+        if (pop[i].alive) finish_game(&pop[i], i);
+    for (i = 0; i < POP; i++) {
+        compute_fitness(&pop[i]);
+        rank[i] = i;
     }
-    for (i = POP - 3; i < POP; i++)
-        net_randomize(pop[i].brain, 1.0f);
+    qsort(rank, POP, sizeof(int), cmp_rank);
+}
+
+static void run_headless(int generations)
+{
+    int i, gen, best_all = 0;
+    const Snake *best;
+    double t0, t, steps, evals, total_t = 0.0, total_steps = 0.0;
+
+    printf("Nerve %s -- Snake AI, headless: %d generations of %d snakes\n\n",
+           net_get_version(), generations, POP);
+    printf("   gen | best score |   fitness |   steps/s |   evals/s\n");
+    printf("  ------------------------------------------------------\n");
+    for (gen = 1; gen <= generations; gen++) {
+        t0 = wall_seconds();
+        play_generation();
+        t  = wall_seconds() - t0;
+        steps = evals = 0.0;
+        for (i = 0; i < POP; i++) {
+            steps += (double)pop[i].steps;
+            evals += (double)pop[i].evals;
+        }
+        best = &pop[rank[0]];
+        if (best->score > best_all) best_all = best->score;
+        if (t < 1e-9) t = 1e-9;
+        printf("  %4d | %10d | %9.0f | %9.0f | %9.0f\n",
+               gen, best->score, (double)best->fitness, steps / t, evals / t);
+        total_t += t; total_steps += steps;
+        evolve_brains();
+    }
+    printf("\n  best score %d  |  %.0f env steps in %.2f s (%.0f steps/s)\n",
+           best_all, total_steps, total_t, total_steps / total_t);
 }
 
 /* ---- main ------------------------------------------------------------- */
-int main(void)
+static void free_brains(void)
 {
-    int i, alive, gen, best_all;
+    int i;
+    for (i = 0; i < n_unpacked; i++) net_free(unpacked[i]);
+    free(unpacked);
+    net_population_free(brains);
+    net_free(scratch);
+}
+
+int main(int argc, char **argv)
+{
+    static Snake show;
+    float inp[N_IN], out[N_OUT];
+    int i, gen, best_all, headless;
     float best_fit;
     int sizes[3];
 
     sizes[0] = N_IN; sizes[1] = N_HID; sizes[2] = N_OUT;
 
-    nerve_seed((unsigned long)time(NULL));
-    enable_vt100();
-    HIDE();
-
-    for (i = 0; i < POP; i++) {
-        pop[i].brain = net_allocate_l(3, sizes);
-        net_set_activation(pop[i].brain, NERVENET_ACTIVATION_TANH);
-        net_initialize_xavier(pop[i].brain);
-        reset_snake(&pop[i]);
+    /* made before nerve_seed, so their random initial weights (one network
+     * per thread) cannot shift a seeded run */
+#if defined(_OPENMP)
+    n_unpacked = omp_get_max_threads();
+#else
+    n_unpacked = 1;
+#endif
+    unpacked = (network_t **)malloc((size_t)n_unpacked * sizeof(network_t *));
+    for (i = 0; i < n_unpacked; i++) unpacked[i] = net_allocate_l(3, sizes);
+
+    headless = (argc > 1 && strcmp(argv[1], "--headless") == 0);
+    nerve_seed(headless && argc > 3 ? strtoul(argv[3], NULL, 10)
+                                    : (unsigned long)time(NULL));
+
+    /* the template supplies topology and activations, then carries the
+     * showcase brain and the fresh random ones */
+    scratch = net_allocate_l(3, sizes);
+    net_set_activation(scratch, NERVENET_ACTIVATION_TANH);
+    brains = net_population_allocate(scratch, POP);
+
+    if (headless) {
+        run_headless(argc > 2 ? atoi(argv[2]) : 100);
+        free_brains();
+        return 0;
     }
 
+    enable_vt100();
+    HIDE();
     best_all = 0;
     best_fit = 0.0f;
 
     for (gen = 1; ; gen++) {
-        /* evaluate entire population */
-        for (i = 0; i < POP; i++) reset_snake(&pop[i]);
-        do {
-            alive = 0;
-            for (i = 0; i < POP; i++) {
-                if (pop[i].alive) { step_snake(&pop[i]); alive += pop[i].alive; }
-            }
-        } while (alive > 0);
-
-        for (i = 0; i < POP; i++) compute_fitness(&pop[i]);
-        qsort(pop, POP, sizeof(Snake), cmp_desc);
+        play_generation();
 
-        best_fit = pop[0].fitness;
-        if (pop[0].score > best_all) best_all = pop[0].score;
+        best_fit = pop[rank[0]].fitness;
+        if (pop[rank[0]].score > best_all) best_all = pop[rank[0]].score;
 
         /* showcase best brain */
-        reset_snake(&pop[0]);
-        while (pop[0].alive) {
-            step_snake(&pop[0]);
-            draw(&pop[0], gen, best_all, best_fit);
+        net_population_get(brains, rank[0], scratch);
+        reset_snake(&show);
+        while (show.alive) {
+            get_inputs(&show, inp);
+            net_compute(scratch, inp, out);
+            step_snake(&show, out);
+            draw(&show, gen, best_all, best_fit);
             SLEEP_MS(FRAME_MS);
         }
 
@@ -367,7 +487,7 @@ int main(void)
     }
 
     /* never reached during normal operation */
-    for (i = 0; i < POP; i++) net_free(pop[i].brain);
+    free_brains();
     SHOW();
     return 0;
 }
@@ -20,12 +20,22 @@
  * Population members each play N_MATCHES against the bot; the best are
  * selected and mutated to form the next generation.
  *
+ * The brains form one net_population_t: all agents' games advance in
+ * lockstep, every tick evaluates all 30 in a single net_population_compute
+ * call, and each generation is bred in one net_population_breed sweep.
+ *
  * Architecture : 5 inputs -> 8 hidden -> 1 output
  * Inputs       : ball_x, ball_y, ball_vx, ball_vy, paddle_y (normalised)
  * Output       : > 0.5 = move up, <= 0.5 = move down
  *
- * Build : gcc -O2 11_pong_ai.c -o pong_ai -lm
+ * Build : gcc -O2 11_pong_ai.c -o pong_ai -lm -pthread
  * Run   : ./pong_ai
+ *
+ * Headless : ./pong_ai --headless [generations [seed]]   (default 100)
+ *            No drawing and no sleeps: each generation is played as fast as
+ *            the CPU allows and reported as one line with its throughput.
+ *            Every agent serves from its own nerve_rng_t, seeded in order,
+ *            so a run is reproducible from its seed.
  */
 
 /* Ask the C library for the POSIX declarations this example needs (nanosleep,
@@ -54,6 +64,8 @@ static void enable_vt100(void) {
     DWORD  m; GetConsoleMode(h, &m);
     SetConsoleMode(h, m | 0x0004);
 }
+/* wall-clock seconds, for the headless throughput counters */
+static double wall_seconds(void) { return (double)GetTickCount() / 1000.0; }
 #else
 #  include <unistd.h>
 /* usleep() was removed from POSIX.1-2008; nanosleep() is its replacement. */
@@ -65,6 +77,12 @@ static void SLEEP_MS(long ms)
     nanosleep(&ts, NULL);
 }
 static void enable_vt100(void) {}
+static double wall_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
 #endif
 
 /* ---- court dimensions ------------------------------------------------- */
@@ -105,14 +123,22 @@ typedef struct {
     float vx, vy;      /* ball velocity */
     float ly, ry;      /* paddle top-edge y (float) */
     int   ai_pts, bot_pts;
+    nerve_rng_t rng;     /* this game's serve generator */
 } Pong;
 
+/* Uniform in [0, 1) from a private stream per game, so its serves do not
+ * depend on the other games */
+static float pong_rand(Pong *g)
+{
+    return nerve_rng_float(&g->rng);
+}
+
 static void pong_reset(Pong *g)
 {
     g->bx = CW * 0.5f;
     g->by = CH * 0.5f;
-    g->vx = ((int)nerve_rand_below(2) == 0 ? 1.0f : -1.0f) * BALL_SPD;
-    g->vy = (nerve_rand_float() - 0.5f) * BALL_SPD * 1.4f;
+    g->vx = (pong_rand(g) < 0.5f ? 1.0f : -1.0f) * BALL_SPD;
+    g->vy = (pong_rand(g) - 0.5f) * BALL_SPD * 1.4f;
     g->ly = (CH - PAD_H) * 0.5f;
     g->ry = (CH - PAD_H) * 0.5f;
 }
@@ -232,130 +258,171 @@ static void draw(const Pong *g, int gen, int best_ai, float best_fit, int live)
     fflush(stdout);
 }
 
-/* ---- evaluate one brain ----------------------------------------------- */
-static float evaluate(network_t *brain)
+/* ---- neuroevolution --------------------------------------------------- */
+typedef struct { Pong game; float fitness; int wins; } Agent;
+static Agent agents[POP];            /* agent i is played by member i */
+static int   rank[POP];              /* members, fittest first        */
+static net_population_t *brains;
+
+static int cmp_rank(const void *a, const void *b)
 {
-    Pong g;
-    float inp[N_IN], out;
-    int match, tick, res, wins = 0;
-    float score = 0.0f;
+    float fa = agents[*(const int *)a].fitness;
+    float fb = agents[*(const int *)b].fitness;
+    if (fb > fa) return  1;
+    if (fb < fa) return -1;
+    return 0;
+}
+
+/* Draw the serve seeds serially from Nerve's generator, then play every
+ * agent's matches in lockstep, every brain in one pass per tick. Ends with
+ * rank[] sorted by fitness. */
+static void play_generation(void)
+{
+    static float inp[POP * N_IN], out[POP * N_OUT];
+    int i, match, tick, res;
+    Pong *g;
 
+    for (i = 0; i < POP; i++) {
+        nerve_rng_seed(&agents[i].game.rng, nerve_rand_u32());
+        agents[i].fitness = 0.0f;
+        agents[i].wins    = 0;
+    }
     for (match = 0; match < MATCHES; match++) {
-        pong_reset(&g);
-        g.ai_pts = 0; g.bot_pts = 0;
+        for (i = 0; i < POP; i++) {
+            g = &agents[i].game;
+            pong_reset(g);
+            g->ai_pts = 0; g->bot_pts = 0;
+        }
         for (tick = 0; tick < MAX_TICKS; tick++) {
-            get_inputs(&g, inp);
-            net_compute(brain, inp, &out);
-            res = pong_tick(&g, out, 0.0f);
-            if (res != 0) {
-                if (res == 1) wins++;
-                pong_reset(&g);
+            for (i = 0; i < POP; i++) get_inputs(&agents[i].game, inp + i * N_IN);
+            net_population_compute(brains, inp, out);
+            for (i = 0; i < POP; i++) {
+                g   = &agents[i].game;
+                res = pong_tick(g, out[i * N_OUT], 0.0f);
+                if (res != 0) {
+                    if (res == 1) agents[i].wins++;
+                    pong_reset(g);
+                }
             }
         }
-        score += (float)g.ai_pts - (float)g.bot_pts * 0.5f;
+        for (i = 0; i < POP; i++)
+            agents[i].fitness += (float)agents[i].game.ai_pts -
+                                 (float)agents[i].game.bot_pts * 0.5f;
     }
-    return score + (float)wins * 2.0f;
+    for (i = 0; i < POP; i++) {
+        agents[i].fitness += (float)agents[i].wins * 2.0f;
+        rank[i] = i;
+    }
+    qsort(rank, POP, sizeof(int), cmp_rank);
 }
 
-/* ---- neuroevolution --------------------------------------------------- */
-typedef struct { network_t *brain; float fitness; } Agent;
-static Agent agents[POP];
-
-static int cmp_agent(const void *a, const void *b)
+/* The ELITE best survive unchanged, the rest are children of two distinct
+ * elites, and the last three are fresh random brains. */
+static void evolve(network_t *scratch)
 {
-    const Agent *aa = (const Agent *)a;
-    const Agent *ab = (const Agent *)b;
-    if (ab->fitness > aa->fitness) return  1;
-    if (ab->fitness < aa->fitness) return -1;
-    return 0;
-}
+    int pa[POP], pb[POP], i, p1, p2;
+
+    for (i = 0; i < ELITE; i++) pa[i] = pb[i] = rank[i];
+    for (i = ELITE; i < POP; i++) {
+        p1 = (int)nerve_rand_below(ELITE);
+        p2 = ((int)nerve_rand_below(ELITE - 1) + p1 + 1) % ELITE;
+        pa[i] = rank[p1];
+        pb[i] = rank[p2];
+    }
+    net_population_breed(brains, pa, pb, ELITE, 0.15f, 0.2f);
 
-static void mutate(network_t *net, float rate, float str)
-{
-    int l, nu, nl;
-    for (l = 1; l < net->no_of_layers; l++)
-        for (nu = 0; nu < net->layer[l].no_of_neurons; nu++)
-            for (nl = 0; nl <= net->layer[l-1].no_of_neurons; nl++)
-                if (nerve_rand_float() < rate) {
-                    float u = nerve_rand_float() + 1e-7f;
-                    float v = nerve_rand_float();
-                    float z = (float)sqrt(-2.0*log((double)u))
-                            * (float)cos(6.28318530718*(double)v);
-                    net->layer[l].neuron[nu].weight[nl] += str * z;
-                }
+    for (i = POP - 3; i < POP; i++) {
+        net_randomize(scratch, 1.0f);
+        net_population_set(brains, i, scratch);
+    }
 }
 
-static void crossover(network_t *c, const network_t *p1, const network_t *p2)
+static void run_headless(int generations, network_t *scratch)
 {
-    int l, nu, nl;
-    for (l = 1; l < c->no_of_layers; l++)
-        for (nu = 0; nu < c->layer[l].no_of_neurons; nu++)
-            for (nl = 0; nl <= c->layer[l-1].no_of_neurons; nl++)
-                c->layer[l].neuron[nu].weight[nl] =
-                    (nerve_rand_float() < 0.5f)
-                    ? p1->layer[l].neuron[nu].weight[nl]
-                    : p2->layer[l].neuron[nu].weight[nl];
+    int gen;
+    double t0, t, steps, total_t = 0.0, total_steps = 0.0;
+
+    /* every agent plays MATCHES games of MAX_TICKS ticks, one brain
+     * evaluation per tick, so env steps and net evals are the same count */
+    steps = (double)POP * MATCHES * MAX_TICKS;
+    printf("Nerve %s -- Pong AI, headless: %d generations of %d agents\n\n",
+           net_get_version(), generations, POP);
+    printf("   gen | best fitness |   steps/s |   evals/s\n");
+    printf("  -------------------------------------------\n");
+    for (gen = 1; gen <= generations; gen++) {
+        t0 = wall_seconds();
+        play_generation();
+        t  = wall_seconds() - t0;
+        if (t < 1e-9) t = 1e-9;
+        printf("  %4d | %12.2f | %9.0f | %9.0f\n",
+               gen, (double)agents[rank[0]].fitness, steps / t, steps / t);
+        total_t += t; total_steps += steps;
+        evolve(scratch);
+    }
+    printf("\n  %.0f env steps in %.2f s (%.0f steps/s)\n",
+           total_steps, total_t, total_steps / total_t);
 }
 
 /* ---- main ------------------------------------------------------------- */
-int main(void)
+int main(int argc, char **argv)
 {
     Pong g;
     float inp[N_IN], out;
-    int i, gen, p1, p2, tick, res;
+    int gen, tick, res, headless;
     int best_ai_wins;
     float best_fit;
     int sizes[3];
+    network_t *scratch;
 
     sizes[0] = N_IN; sizes[1] = N_HID; sizes[2] = N_OUT;
-    nerve_seed((unsigned long)time(NULL));
+    headless = (argc > 1 && strcmp(argv[1], "--headless") == 0);
+    nerve_seed(headless && argc > 3 ? strtoul(argv[3], NULL, 10)
+                                    : (unsigned long)time(NULL));
+
+    /* the template supplies topology and activations, then carries the
+     * showcase brain and the fresh random ones */
+    scratch = net_allocate_l(3, sizes);
+    net_set_activation(scratch, NERVENET_ACTIVATION_TANH);
+    brains = net_population_allocate(scratch, POP);
+
+    if (headless) {
+        run_headless(argc > 2 ? atoi(argv[2]) : 100, scratch);
+        net_population_free(brains);
+        net_free(scratch);
+        return 0;
+    }
+
     enable_vt100();
     HIDE();
 
-    for (i = 0; i < POP; i++) {
-        agents[i].brain = net_allocate_l(3, sizes);
-        net_set_activation(agents[i].brain, NERVENET_ACTIVATION_TANH);
-        net_initialize_xavier(agents[i].brain);
-        agents[i].fitness = 0.0f;
-    }
-
     best_ai_wins = 0;
     best_fit     = 0.0f;
 
     for (gen = 1; ; gen++) {
-        /* evaluate */
-        for (i = 0; i < POP; i++)
-            agents[i].fitness = evaluate(agents[i].brain);
+        play_generation();
 
-        qsort(agents, POP, sizeof(Agent), cmp_agent);
-
-        best_fit = agents[0].fitness;
-        if (agents[0].fitness > best_ai_wins) best_ai_wins = (int)agents[0].fitness;
+        best_fit = agents[rank[0]].fitness;
+        if (best_fit > best_ai_wins) best_ai_wins = (int)best_fit;
 
         /* showcase best agent */
+        net_population_get(brains, rank[0], scratch);
+        nerve_rng_seed(&g.rng, nerve_rand_u32());
         pong_reset(&g);
         g.ai_pts = 0; g.bot_pts = 0;
         for (tick = 0; tick < MAX_TICKS * 2; tick++) {
             get_inputs(&g, inp);
-            net_compute(agents[0].brain, inp, &out);
+            net_compute(scratch, inp, &out);
             res = pong_tick(&g, out, 0.0f);
             draw(&g, gen, best_ai_wins, best_fit, 1);
             SLEEP_MS(FRAME_MS);
             if (res != 0) pong_reset(&g);
         }
 
-        /* evolve */
-        for (i = ELITE; i < POP; i++) {
-            p1 = (int)nerve_rand_below(ELITE);
-            p2 = ((int)nerve_rand_below(ELITE - 1) + p1 + 1) % ELITE;
-            crossover(agents[i].brain, agents[p1].brain, agents[p2].brain);
-            mutate(agents[i].brain, 0.15f, 0.2f);
-        }
-        for (i = POP - 3; i < POP; i++)
-            net_randomize(agents[i].brain, 1.0f);
+        evolve(scratch);
     }
 
-    for (i = 0; i < POP; i++) net_free(agents[i].brain);
+    net_population_free(brains);
+    net_free(scratch);
     SHOW();
     return 0;
 }
@@ -20,12 +20,23 @@
  * All birds are shown live; the number still flying decreases each run until
  * only the fittest brain remains.
  *
+ * The brains form one net_population_t: every tick evaluates all 20 in a
+ * single net_population_compute call, and each generation is bred in one
+ * net_population_breed sweep.
+ *
  * Architecture : 5 inputs -> 8 hidden -> 1 output
  * Inputs       : bird_y, bird_vy, pipe_dx, gap_top, gap_bot (normalised)
  * Output       : > 0.5 = flap
  *
- * Build : gcc -O2 12_flappy_ai.c -o flappy_ai -lm
+ * Build : gcc -O2 12_flappy_ai.c -o flappy_ai -lm -pthread
  * Run   : ./flappy_ai
+ *
+ * Headless : ./flappy_ai --headless [generations [seed]]   (default 100)
+ *            No drawing and no sleeps: each generation is flown as fast as
+ *            the CPU allows — capped at MAX_TICKS, since a good flock never
+ *            dies — and reported as one line with its throughput. All birds
+ *            share one world, so the flock steps in lock-step on one thread;
+ *            its brains are already evaluated as one batch per tick.
  */
 
 /* Ask the C library for the POSIX declarations this example needs (nanosleep,
@@ -54,6 +65,8 @@ static void enable_vt100(void) {
     DWORD  m; GetConsoleMode(h, &m);
     SetConsoleMode(h, m | 0x0004);
 }
+/* wall-clock seconds, for the headless throughput counters */
+static double wall_seconds(void) { return (double)GetTickCount() / 1000.0; }
 #else
 #  include <unistd.h>
 /* usleep() was removed from POSIX.1-2008; nanosleep() is its replacement. */
@@ -65,6 +78,12 @@ static void SLEEP_MS(long ms)
     nanosleep(&ts, NULL);
 }
 static void enable_vt100(void) {}
+static double wall_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
 #endif
 
 /* ---- world dimensions ------------------------------------------------- */
@@ -84,6 +103,7 @@ static void enable_vt100(void) {}
 #define N_HID     8
 #define N_OUT     1
 #define FRAME_MS  45
+#define MAX_TICKS 20000   /* headless only: end a generation that never dies */
 
 /* ---- ANSI ------------------------------------------------------------- */
 #define CLR()  fputs("\033[H",           stdout)   /* home only — no flash */
@@ -105,7 +125,6 @@ typedef struct {
     int   pipes_cleared;
     float fitness;
     int   ticks;
-    network_t *brain;
 } Bird;
 
 typedef struct {
@@ -116,7 +135,8 @@ typedef struct {
 
 #define MAX_PIPES 8
 
-static Bird  birds[POP];
+static Bird  birds[POP];             /* bird i flies population member i */
+static net_population_t *brains;
 static Pipe  pipes[MAX_PIPES];
 static int   n_pipes;
 static int   world_tick;
@@ -174,16 +194,18 @@ static void get_inputs(const Bird *b, float *inp)
 static void world_step(void)
 {
     int i, k, j, brow, alive_any;
-    float inp[N_IN], out;
+    float inp[POP * N_IN], out[POP * N_OUT];
+
+    /* every brain in one pass; dead birds' outputs are simply ignored */
+    for (i = 0; i < POP; i++) get_inputs(&birds[i], inp + i * N_IN);
+    net_population_compute(brains, inp, out);
 
     /* update birds */
     alive_any = 0;
     for (i = 0; i < POP; i++) {
         if (!birds[i].alive) continue;
 
-        get_inputs(&birds[i], inp);
-        net_compute(birds[i].brain, inp, &out);
-        if (out > 0.5f) birds[i].vy = FLAP_VY;
+        if (out[i * N_OUT] > 0.5f) birds[i].vy = FLAP_VY;
 
         birds[i].vy += GRAVITY;
         birds[i].y  += birds[i].vy;
@@ -292,103 +314,143 @@ static void draw_world(int gen, int alive, int best_pipes)
 }
 
 /* ---- neuroevolution --------------------------------------------------- */
-static int cmp_bird(const void *a, const void *b)
+static int cmp_rank(const void *a, const void *b)
 {
-    const Bird *ba = (const Bird *)a;
-    const Bird *bb = (const Bird *)b;
-    if (bb->fitness > ba->fitness) return  1;
-    if (bb->fitness < ba->fitness) return -1;
+    float fa = birds[*(const int *)a].fitness;
+    float fb = birds[*(const int *)b].fitness;
+    if (fb > fa) return  1;
+    if (fb < fa) return -1;
     return 0;
 }
 
-static void mutate(network_t *net, float rate, float str)
+/* Rank by fitness; the ELITE best survive unchanged, the rest are children
+ * of two distinct elites, and the last two are fresh random brains. */
+static void evolve(network_t *scratch)
 {
-    int l, nu, nl;
-    for (l = 1; l < net->no_of_layers; l++)
-        for (nu = 0; nu < net->layer[l].no_of_neurons; nu++)
-            for (nl = 0; nl <= net->layer[l-1].no_of_neurons; nl++)
-                if (nerve_rand_float() < rate) {
-                    float u = nerve_rand_float() + 1e-7f;
-                    float v = nerve_rand_float();
-                    float z = (float)sqrt(-2.0*log((double)u))
-                            * (float)cos(6.28318530718*(double)v);
-                    net->layer[l].neuron[nu].weight[nl] += str * z;
-                }
+    int rank[POP], pa[POP], pb[POP], i, p1, p2;
+
+    for (i = 0; i < POP; i++) rank[i] = i;
+    qsort(rank, POP, sizeof(int), cmp_rank);
+
+    for (i = 0; i < ELITE; i++) pa[i] = pb[i] = rank[i];
+    for (i = ELITE; i < POP; i++) {
+        p1 = (int)nerve_rand_below(ELITE);
+        p2 = ((int)nerve_rand_below(ELITE - 1) + p1 + 1) % ELITE;
+        pa[i] = rank[p1];
+        pb[i] = rank[p2];
+    }
+    net_population_breed(brains, pa, pb, ELITE, 0.15f, 0.25f);
+
+    for (i = POP - 2; i < POP; i++) {
+        net_randomize(scratch, 1.0f);
+        net_population_set(brains, i, scratch);
+    }
 }
 
-static void crossover(network_t *c, const network_t *p1, const network_t *p2)
+/* ---- one generation --------------------------------------------------- */
+/* Fly until every bird is down; drawn live unless headless, where a flock
+ * that outlasts MAX_TICKS is stopped there. */
+static void fly_generation(int gen, int best_pipes, int headless)
 {
-    int l, nu, nl;
-    for (l = 1; l < c->no_of_layers; l++)
-        for (nu = 0; nu < c->layer[l].no_of_neurons; nu++)
-            for (nl = 0; nl <= c->layer[l-1].no_of_neurons; nl++)
-                c->layer[l].neuron[nu].weight[nl] =
-                    (nerve_rand_float() < 0.5f)
-                    ? p1->layer[l].neuron[nu].weight[nl]
-                    : p2->layer[l].neuron[nu].weight[nl];
+    int i, alive;
+
+    reset_world();
+    for (i = 0; i < POP; i++) reset_bird(&birds[i]);
+    do {
+        alive = 0;
+        for (i = 0; i < POP; i++) alive += birds[i].alive;
+
+        world_step();
+
+        /* update fitness for living birds */
+        for (i = 0; i < POP; i++)
+            if (birds[i].alive)
+                birds[i].fitness = (float)birds[i].pipes_cleared * 1000.0f
+                                 + (float)birds[i].ticks;
+
+        if (headless) {
+            if (world_tick >= MAX_TICKS) break;
+        } else if (gen > 1 || world_tick > 5) {
+            draw_world(gen, alive, best_pipes);
+            SLEEP_MS(FRAME_MS);
+        }
+    } while (alive > 0);
+}
+
+static int best_of_flock(int best_pipes)
+{
+    int i;
+    for (i = 0; i < POP; i++)
+        if (birds[i].pipes_cleared > best_pipes)
+            best_pipes = birds[i].pipes_cleared;
+    return best_pipes;
+}
+
+static void run_headless(int generations, network_t *scratch)
+{
+    int i, gen, best_pipes = 0;
+    double t0, t, steps, evals, total_t = 0.0, total_steps = 0.0;
+
+    printf("Nerve %s -- Flappy Bird AI, headless: %d generations of %d birds\n\n",
+           net_get_version(), generations, POP);
+    printf("   gen | best pipes |   steps/s |   evals/s\n");
+    printf("  -----------------------------------------\n");
+    for (gen = 1; gen <= generations; gen++) {
+        t0 = wall_seconds();
+        fly_generation(gen, best_pipes, 1);
+        t  = wall_seconds() - t0;
+        /* bird steps are the live birds' ticks; every tick evaluates the
+         * whole flock in one net_population_compute call */
+        steps = 0.0;
+        for (i = 0; i < POP; i++) steps += (double)birds[i].ticks;
+        evals = (double)world_tick * POP;
+        best_pipes = best_of_flock(best_pipes);
+        if (t < 1e-9) t = 1e-9;
+        printf("  %4d | %10d | %9.0f | %9.0f\n",
+               gen, best_pipes, steps / t, evals / t);
+        total_t += t; total_steps += steps;
+        evolve(scratch);
+    }
+    printf("\n  best %d pipes  |  %.0f bird steps in %.2f s (%.0f steps/s)\n",
+           best_pipes, total_steps, total_t, total_steps / total_t);
 }
 
 /* ---- main ------------------------------------------------------------- */
-int main(void)
+int main(int argc, char **argv)
 {
-    int i, gen, alive, best_pipes, p1, p2;
+    int gen, best_pipes, headless;
     int sizes[3];
+    network_t *scratch;
 
     sizes[0] = N_IN; sizes[1] = N_HID; sizes[2] = N_OUT;
-    nerve_seed((unsigned long)time(NULL));
-    enable_vt100();
-    HIDE();
-
-    for (i = 0; i < POP; i++) {
-        birds[i].brain = net_allocate_l(3, sizes);
-        net_set_activation(birds[i].brain, NERVENET_ACTIVATION_TANH);
-        net_initialize_xavier(birds[i].brain);
+    headless = (argc > 1 && strcmp(argv[1], "--headless") == 0);
+    nerve_seed(headless && argc > 3 ? strtoul(argv[3], NULL, 10)
+                                    : (unsigned long)time(NULL));
+
+    /* the template only supplies topology and activations */
+    scratch = net_allocate_l(3, sizes);
+    net_set_activation(scratch, NERVENET_ACTIVATION_TANH);
+    brains = net_population_allocate(scratch, POP);
+
+    if (headless) {
+        run_headless(argc > 2 ? atoi(argv[2]) : 100, scratch);
+        net_population_free(brains);
+        net_free(scratch);
+        return 0;
     }
 
+    enable_vt100();
+    HIDE();
     best_pipes = 0;
 
     for (gen = 1; ; gen++) {
-        reset_world();
-        for (i = 0; i < POP; i++) reset_bird(&birds[i]);
-
-        /* run until all birds dead */
-        do {
-            alive = 0;
-            for (i = 0; i < POP; i++) alive += birds[i].alive;
-
-            world_step();
-
-            /* update fitness for living birds */
-            for (i = 0; i < POP; i++)
-                if (birds[i].alive)
-                    birds[i].fitness = (float)birds[i].pipes_cleared * 1000.0f
-                                     + (float)birds[i].ticks;
-
-            if (gen > 1 || world_tick > 5) {
-                draw_world(gen, alive, best_pipes);
-                SLEEP_MS(FRAME_MS);
-            }
-        } while (alive > 0);
-
-        /* find global best pipes */
-        for (i = 0; i < POP; i++)
-            if (birds[i].pipes_cleared > best_pipes)
-                best_pipes = birds[i].pipes_cleared;
-
-        /* sort and evolve */
-        qsort(birds, POP, sizeof(Bird), cmp_bird);
-
-        for (i = ELITE; i < POP; i++) {
-            p1 = (int)nerve_rand_below(ELITE);
-            p2 = ((int)nerve_rand_below(ELITE - 1) + p1 + 1) % ELITE;
-            crossover(birds[i].brain, birds[p1].brain, birds[p2].brain);
-            mutate(birds[i].brain, 0.15f, 0.25f);
-        }
-        for (i = POP - 2; i < POP; i++)
-            net_randomize(birds[i].brain, 1.0f);
+        fly_generation(gen, best_pipes, 0);
+        best_pipes = best_of_flock(best_pipes);
+        evolve(scratch);
     }
 
-    for (i = 0; i < POP; i++) net_free(birds[i].brain);
+    net_population_free(brains);
+    net_free(scratch);
     SHOW();
     return 0;
 }
@@ -20,7 +20,7 @@
  *  NERVE  —  Zero-dependency multilayer perceptron in ANSI C
  *
  *  Features
- *    • SGD + momentum  and  Adam optimizer
+ *    • SGD + momentum, Adam and AdamW optimizers
  *    • Sigmoid, Tanh, ReLU, Leaky ReLU hidden activations
  *    • Xavier (Glorot) and He weight initialisation
  *    • L2 regularisation  •  Dropout
@@ -38,6 +38,8 @@
  *        ICLR 2015.
  *    [5] Srivastava et al. (2014). Dropout: A simple way to prevent neural
  *        networks from overfitting. JMLR 15, 1929–1958.
+ *    [6] Loshchilov & Hutter (2019). Decoupled weight decay
+ *        regularization. ICLR.
  *
  * ─────────────────────────────────────────────────────────────────────────
  *
@@ -98,10 +100,13 @@
 #define NERVENET_DEFAULT_WEIGHT_RANGE  1.0f
 #define NERVENET_MAX_LAYERS            256
 #define NERVENET_MAX_NEURONS           65536
+#define NERVENET_BATCH_TILE            64   /* samples per net_compute_batch tile */
+#define NERVENET_TRAIN_TILE            256  /* samples held at once by the trainer */
 
 #define NERVENET_ADAM_BETA1    0.9f
 #define NERVENET_ADAM_BETA2    0.999f
 #define NERVENET_ADAM_EPSILON  1e-8f
+#define NERVENET_ADAMW_DECAY   0.01f  /* decoupled weight decay for ADAMW */
 
 /* ── Enumerations ─────────────────────────────────────────────────────── */
 typedef enum
@@ -121,10 +126,38 @@ typedef enum
 
 typedef enum
 {
-    NERVENET_OPTIMIZER_SGD  = 0,
-    NERVENET_OPTIMIZER_ADAM = 1
+    NERVENET_OPTIMIZER_SGD   = 0,
+    NERVENET_OPTIMIZER_ADAM  = 1,
+    NERVENET_OPTIMIZER_ADAMW = 2   /* Adam with decoupled weight decay     */
 } nervenet_optimizer_t;
 
+typedef enum
+{
+    NERVENET_SIMD_SCALAR = 0,   /* portable C                              */
+    NERVENET_SIMD_SSE2   = 1,
+    NERVENET_SIMD_AVX2   = 2,   /* AVX2 + FMA                              */
+    NERVENET_SIMD_AVX512 = 3    /* AVX-512F                                */
+} nervenet_simd_t;
+
+typedef enum
+{
+    NERVENET_HALF_FP16 = 0,     /* IEEE 754 binary16: 10-bit mantissa      */
+    NERVENET_HALF_BF16 = 1      /* bfloat16: float's range, 7-bit mantissa */
+} nervenet_half_t;
+
+typedef enum
+{
+    NERVENET_DATA_F32 = 0,      /* 32-bit floats, native endianness        */
+    NERVENET_DATA_U8  = 1,      /* unsigned bytes                          */
+    NERVENET_DATA_I16 = 2       /* signed 16-bit ints, native endianness   */
+} nervenet_data_t;
+
+typedef enum
+{
+    NERVENET_STATS_JSON = 0,
+    NERVENET_STATS_CSV  = 1
+} nervenet_stats_format_t;
+
 typedef enum
 {
     NERVENET_INIT_UNIFORM = 0,
@@ -143,6 +176,9 @@ typedef enum
 } nervenet_error_t;
 
 /* ── Core Structures ──────────────────────────────────────────────────── */
+/* A neuron's `weight` and `delta` are row views into its layer's contiguous
+ * blocks below, not separate allocations: row nu of layer l is
+ * layer[l].weight + nu * (layer[l-1].no_of_neurons + 1), bias last. */
 typedef struct neuron_s
 {
     float  output;
@@ -155,8 +191,40 @@ typedef struct layer_s
 {
     int       no_of_neurons;
     neuron_t *neuron;
+    float    *weight;  /* (no_of_neurons, lower + 1) row-major, 64-byte aligned */
+    float    *delta;   /* same shape: momentum term / batch accumulator        */
+    float    *adam_m;  /* same shape, view into network_t.adam_m (or NULL)    */
+    float    *adam_v;  /* same shape, view into network_t.adam_v (or NULL)    */
 } layer_t;
 
+/* Profiling counters, kept when the implementation is built with
+ * NERVENET_PROFILE (see net_get_stats). Work is counted from the shapes, not
+ * measured: a multiply-add is two flops, and bytes are the distinct weights,
+ * activations and errors a pass reads or writes. */
+typedef struct
+{
+    unsigned long calls;    /* timed passes                                */
+    double        seconds;  /* summed over threads                         */
+    double        flops;    /* the RNG counts 32-bit draws here            */
+    double        bytes;
+} nerve_counter_t;
+
+typedef struct
+{
+    nerve_counter_t forward;
+    nerve_counter_t backward;  /* errors, and the mini-batch gradient      */
+    nerve_counter_t update;    /* optimizer step, or the one-sample delta  */
+} nerve_layer_stats_t;
+
+typedef struct
+{
+    int                  no_of_layers;
+    nerve_layer_stats_t *layer;      /* [no_of_layers]; layer[0] stays zero */
+    nerve_counter_t      activation; /* batched f and f' sweeps, softmax    */
+    nerve_counter_t      rng;        /* dropout masks, epoch shuffles       */
+    nerve_counter_t      optimizer;  /* whole steps, pruning hold included  */
+} nerve_stats_t;
+
 typedef struct network_s
 {
     int     no_of_layers;
@@ -174,6 +242,13 @@ typedef struct network_s
     int     optimizer;
     float   l2_lambda;
     float   dropout_rate;   /* fraction of hidden neurons dropped per step */
+    int     threads;        /* shards per mini-batch in net_train_epoch    */
+
+    /* Parallel blocks of block_floats floats each. Every layer's matrix sits
+     * at the same offset in all four, padded to a 64-byte boundary. */
+    float  *weight_block;
+    float  *delta_block;
+    int     block_floats;
 
     float  *adam_m;
     float  *adam_v;
@@ -181,8 +256,100 @@ typedef struct network_s
     float   adam_beta1;
     float   adam_beta2;
     float   adam_epsilon;
+    float   adam_beta1_t;   /* beta1^t and beta2^t, kept as running products */
+    float   adam_beta2_t;   /* so bias correction never calls pow()          */
+    float   weight_decay;   /* ADAMW only: w -= lr * weight_decay * w        */
+
+    void   *map_base;       /* net_map: weight_block lives in this mapping, */
+    size_t  map_bytes;      /* released by net_free instead of freed        */
+    size_t  arena_bytes;    /* net_allocate_in: caller's buffer; 0 = heap   */
+
+    unsigned long *prune_mask; /* net_prune: a bit per weight_block float,  */
+                               /* set = pruned and held at zero; or NULL    */
+    float   prune_target;   /* net_set_prune_schedule: sparsity to reach    */
+    int     prune_epochs;   /* over this many net_train_epoch calls         */
+    int     prune_epoch;    /* schedule epochs done so far                  */
+
+    nerve_stats_t *stats;   /* NERVENET_PROFILE counters, or NULL           */
 } network_t;
 
+/* An inference-only int8 copy of a network, made by net_quantize. Each row
+ * of each weight matrix is stored as signed bytes with one float scale,
+ * w ~ scale * q, symmetric around zero; the biases stay float. */
+typedef struct
+{
+    int          no_of_layers;
+    int         *sizes;              /* neurons per layer                   */
+    int          activation;
+    int          output_activation;
+    signed char *weight;   /* every (n_upper, n_lower) matrix, back to back */
+    float       *scale;    /* one per row, layer after layer                */
+    float       *bias;     /* one per row                                   */
+    float       *act[2];   /* scratch: net_qcompute is not re-entrant       */
+} qnetwork_t;
+
+/* An inference-only sparse copy of a pruned network, made by net_sparsify.
+ * Each weight matrix is stored in compressed sparse rows: counting rows
+ * through all layers in order, row r keeps its non-zero weights
+ * val[row_ptr[r] .. row_ptr[r + 1]) at input columns col[...]; the biases
+ * stay dense. */
+typedef struct
+{
+    int    no_of_layers;
+    int   *sizes;              /* neurons per layer                        */
+    int    activation;
+    int    output_activation;
+    int   *row_ptr;  /* rows + 1 offsets into col and val                 */
+    int   *col;      /* one per non-zero weight                           */
+    float *val;      /* one per non-zero weight                           */
+    float *bias;     /* one per row                                       */
+    float *act[2];   /* scratch: net_scompute is not re-entrant           */
+} snetwork_t;
+
+/* An inference-only half-precision copy of a network, made by net_half.
+ * Every weight is a 16-bit IEEE half or bfloat16 (`format`), widened to
+ * float a row at a time; sums stay float32 and the biases stay float. */
+typedef struct
+{
+    int             no_of_layers;
+    int            *sizes;           /* neurons per layer                  */
+    int             activation;
+    int             output_activation;
+    int             format;          /* nervenet_half_t                    */
+    unsigned short *weight; /* every (n_upper, n_lower) matrix, back to back */
+    float          *bias;   /* one per row                                 */
+    float          *act[2]; /* scratch: net_hcompute is not re-entrant     */
+    float          *row;    /* scratch: one row widened to float           */
+} hnetwork_t;
+
+/* N networks of one topology, for neuroevolution. The weights of all
+ * members form one tensor, gene-major with the member innermost: gene g of
+ * member m is genome[g * size + m], genes in network order (layer by layer,
+ * row-major, bias last). A forward pass then treats the population like a
+ * batch, and breeding sweeps each gene across all members at once. */
+typedef struct
+{
+    int    size;               /* members                                */
+    int    genes;              /* weights per member                     */
+    int    no_of_layers;
+    int   *sizes;
+    int    activation;
+    int    output_activation;
+    float  bias;               /* bias input: 1, or 0 after net_use_bias */
+    float *genome;             /* genes * size, 64-byte aligned          */
+    float *spare;              /* next generation, built by net_population_breed */
+    float *act[2];             /* (widest layer + 1) * size scratch      */
+} net_population_t;
+
+/* Per-caller scratch for net_compute_ctx: everything a forward pass writes,
+ * nothing it only reads. One context per thread lets any number of threads
+ * share a single network. */
+typedef struct
+{
+    int    size;    /* floats per buffer: widest layer plus its bias */
+    float *act[2];  /* ping-pong activation buffers                  */
+} net_context_t;
+
 /* ── Public API ───────────────────────────────────────────────────────── */
 #ifdef __cplusplus
 extern "C" {
@@ -193,6 +360,25 @@ network_t *net_allocate(int no_of_layers, ...);
 network_t *net_allocate_l(int no_of_layers, const int *arglist);
 void       net_free(network_t *net);
 
+/* Arena allocation ──────────────────────────────────────────────────────
+ * For targets that forbid heap use after startup: net_allocate_in carves
+ * the network, its layers, neurons, weight and delta blocks — and, with
+ * NERVENET_ARENA_ADAM, the Adam moments, and with NERVENET_PROFILE, the
+ * counters — out of one caller-owned buffer of at least net_size_required
+ * bytes (any alignment). net_compute, net_train and the begin/train/end
+ * batch calls then never allocate; net_set_optimizer reuses the reserved
+ * moments. net_free is a no-op on such a network: the buffer is the
+ * caller's. net_train_epoch, net_compute_batch and net_copy
+ * still take their scratch from the heap; net_add_neurons,
+ * net_remove_neurons and net_overwrite, which would have to replace the
+ * buffer's contents with heap blocks, refuse such a network (as the
+ * destination) with NERVENET_ERROR_INVALID_PARAM and leave it unchanged.
+ */
+#define NERVENET_ARENA_ADAM 1   /* reserve room for ADAM/ADAMW moments */
+size_t     net_size_required(int no_of_layers, const int *sizes, int opts);
+network_t *net_allocate_in(void *buffer, size_t size,
+                           int no_of_layers, const int *sizes, int opts);
+
 /* Deterministic RNG ─────────────────────────────────────────────────────
  * Nerve draws every random number from its own generator, never from libc's
  * rand(). This is a portability requirement, not a preference: rand() is
@@ -211,10 +397,37 @@ unsigned long nerve_rand_u32(void);           /* raw 32-bit draw            */
 float         nerve_rand_float(void);         /* uniform in [0, 1)          */
 unsigned long nerve_rand_below(unsigned long bound); /* uniform in [0,bound) */
 
+/* RNG streams ──────────────────────────────────────────────────────────
+ * The global generator is one shared state, so it cannot be drawn from by
+ * several threads at once. A nerve_rng_t is the same generator as a value
+ * the caller owns: seed it, copy it, hand one to each thread. The functions
+ * below mirror the global ones, and the _r variants of the init and training
+ * calls take a stream in place of the global state — the plain calls are
+ * exactly the _r calls on the global stream.
+ *
+ * nerve_rng_jump advances a stream by 2^64 draws and nerve_rng_long_jump by
+ * 2^96, in the time of 128 draws. Seed one stream, then give thread k a copy
+ * jumped k times: the threads' streams are then provably disjoint for 2^64
+ * draws each, and the run is reproducible from the one seed however the
+ * threads are scheduled. Long jumps split at the coarser level — one per
+ * process or machine, with jumps inside each.
+ */
+typedef struct { unsigned long s[4]; } nerve_rng_t;
+
+void          nerve_rng_seed(nerve_rng_t *rng, unsigned long seed);
+unsigned long nerve_rng_u32(nerve_rng_t *rng);
+float         nerve_rng_float(nerve_rng_t *rng);
+unsigned long nerve_rng_below(nerve_rng_t *rng, unsigned long bound);
+void          nerve_rng_jump(nerve_rng_t *rng);      /* skip 2^64 draws */
+void          nerve_rng_long_jump(nerve_rng_t *rng); /* skip 2^96 draws */
+
 /* Initialisation */
 void net_randomize(network_t *net, float range);
 void net_initialize_xavier(network_t *net);
 void net_initialize_he(network_t *net);
+void net_randomize_r(network_t *net, float range, nerve_rng_t *rng);
+void net_initialize_xavier_r(network_t *net, nerve_rng_t *rng);
+void net_initialize_he_r(network_t *net, nerve_rng_t *rng);
 void net_reset_deltas(network_t *net);
 
 /* Configuration */
@@ -227,7 +440,9 @@ void  net_set_loss(network_t *net, nervenet_loss_t loss);
 void  net_set_classification(network_t *net); /* softmax + cross-entropy combo */
 void  net_set_optimizer(network_t *net, nervenet_optimizer_t opt);
 void  net_set_l2_lambda(network_t *net, float lambda);
-void  net_set_dropout(network_t *net, float rate);
+void  net_set_weight_decay(network_t *net, float decay); /* ADAMW only */
+void  net_set_dropout(network_t *net, float rate); /* inverted, 1/256 steps */
+void  net_set_threads(network_t *net, int threads); /* net_train_epoch shards */
 
 /* Query */
 float net_get_momentum(const network_t *net);
@@ -253,18 +468,116 @@ int        net_fbprint(FILE *file, const network_t *net);
 network_t *net_fbscan(FILE *file);
 int        net_bsave(const char *filename, const network_t *net);
 network_t *net_bload(const char *filename);
+network_t *net_map(const char *filename); /* mmap a net_bsave file in place */
+
+/* Ahead-of-time export: write `void name(const float *input, float *output)`
+ * as standalone C89 with compile-time sizes, static const weights and the
+ * activations inlined. Small layers are unrolled into straight-line code
+ * with zero weights dropped; wide ones keep constant-bound loops. The
+ * generated file needs only <math.h>: no heap, no Nerve. */
+int        net_export_c(FILE *file, const network_t *net, const char *name);
+
+/* Checkpoints ────────────────────────────────────────────────────────────
+ * net_checkpoint_save snapshots the network into one of two buffers, one
+ * memcpy per block, and returns the checkpoint's number. A background
+ * thread writes it to "<prefix>-<number>.nrvb" through a temporary file and
+ * a rename, so no checkpoint on disk is ever half written, then deletes all
+ * but the newest `keep` (keep <= 0 keeps them all). A save blocks only
+ * while both buffers are still waiting to be written.
+ *
+ * The file is an NRVB v2 network that net_bload and net_map read as usual,
+ * followed by the training state net_bsave leaves out: momentum deltas, the
+ * Adam moments and step, the prune schedule and mask, and an RNG stream
+ * (`rng`, or the global generator when it is NULL). net_checkpoint_load
+ * restores all of it, so training resumes bit for bit.
+ *
+ * net_checkpoint_wait returns 0, or the error of the first failed write
+ * since the last wait. Without POSIX threads, or with NERVENET_NO_THREADS,
+ * each save writes before it returns.
+ */
+typedef struct nerve_checkpoint_s nerve_checkpoint_t;
+nerve_checkpoint_t *net_checkpoint_open(const char *prefix, int keep);
+int        net_checkpoint_save(nerve_checkpoint_t *ck, const network_t *net,
+                               const nerve_rng_t *rng);
+int        net_checkpoint_wait(nerve_checkpoint_t *ck);
+void       net_checkpoint_close(nerve_checkpoint_t *ck);
+network_t *net_checkpoint_load(const char *filename, nerve_rng_t *rng);
 
 /* Inference */
 void  net_compute(network_t *net, const float *input, float *output);
+
+/**
+ * Sparse input: the nnz non-zero inputs are val[k] at index idx[k]
+ * (distinct, ascending not required); val = NULL means every one is 1, as
+ * for one-hot and binary bag-of-words features. The first layer then reads
+ * only those weight columns and the bias, so its cost scales with nnz, not
+ * with the input width. Otherwise identical to net_compute; the input
+ * neurons are not written. Train with net_train_sparse /
+ * net_train_batch_sparse on the same idx/val, which update only those
+ * columns of the first layer — a lazy update: with momentum, L2 or Adam,
+ * columns a sample does not touch keep their momentum and moments as they
+ * were, rather than decaying every step.
+ */
+void  net_compute_sparse(network_t *net, const int *idx, const float *val,
+                         int nnz, float *output);
+
+/**
+ * Batched inference: run n samples (inputs is n × n_inputs, row-major) and
+ * write n × n_outputs results. Each layer runs as a matrix-matrix product
+ * over tiles of NERVENET_BATCH_TILE samples, so every weight is loaded once
+ * per tile rather than once per sample. Results match net_compute sample for
+ * sample; the neurons' own output fields are left untouched.
+ */
+void  net_compute_batch(network_t *net, const float *inputs, int n,
+                        float *outputs);
+
+/**
+ * Re-entrant inference. net_compute writes into the network's neurons, so two
+ * threads cannot share one network; net_compute_ctx reads the network and
+ * writes only into `ctx`, so they can, one context per thread. Results match
+ * net_compute exactly (to rounding under the FMA kernels of NERVENET_SIMD).
+ * The network must not be trained or resized meanwhile.
+ */
+net_context_t *net_context_allocate(const network_t *net);
+void           net_context_free(net_context_t *ctx);
+void           net_compute_ctx(const network_t *net, net_context_t *ctx,
+                               const float *input, float *output);
+
+/* SIMD dispatch ──────────────────────────────────────────────────────────
+ * With NERVENET_SIMD defined before the implementation (GCC/Clang, x86),
+ * the batched forward, backward and update kernels pick the widest of
+ * SSE2, AVX2/FMA and AVX-512 that the CPU supports. Otherwise, and on
+ * every other target, the portable C kernels run and the level is SCALAR.
+ * Set the cap before any thread starts computing.
+ */
+nervenet_simd_t net_simd_level(void);                  /* kernels in use    */
+nervenet_simd_t net_simd_set_level(nervenet_simd_t cap); /* cap; returns use */
+int             net_simd_self_check(void); /* 1: active kernels match C     */
 float net_compute_output_error(network_t *net, const float *target);
 float net_get_output_error(const network_t *net);
 
+/* Profiling ──────────────────────────────────────────────────────────────
+ * With NERVENET_PROFILE defined before the implementation, every network
+ * counts calls, time, flops and bytes per layer for the forward, backward
+ * and update passes, and overall for the activations, the RNG and the
+ * optimizer. Without it the hooks compile away, net_get_stats returns NULL
+ * and net_fprint_stats reports NERVENET_ERROR_INVALID_PARAM.
+ */
+const nerve_stats_t *net_get_stats(const network_t *net);
+void net_reset_stats(network_t *net);
+int  net_fprint_stats(FILE *file, const network_t *net,
+                      nervenet_stats_format_t format);
+
 /* Online training (one sample) */
 void net_train(network_t *net);
+void net_train_sparse(network_t *net, const int *idx, const float *val,
+                      int nnz);
 
 /* Batch training */
 void net_begin_batch(network_t *net);
 void net_train_batch(network_t *net);
+void net_train_batch_sparse(network_t *net, const int *idx, const float *val,
+                            int nnz);
 void net_end_batch(network_t *net);
 
 /**
@@ -276,6 +589,117 @@ float net_train_epoch(network_t *net,
                       const float *inputs, const float *targets,
                       int n_pairs, int n_inputs, int n_outputs,
                       int batch_size);
+/* The same with shuffle and dropout drawn from `rng`. */
+float net_train_epoch_r(network_t *net,
+                        const float *inputs, const float *targets,
+                        int n_pairs, int n_inputs, int n_outputs,
+                        int batch_size, nerve_rng_t *rng);
+
+/* Streaming datasets ────────────────────────────────────────────────────
+ * A nerve_dataset_t feeds training one mini-batch at a time from a source
+ * that is read sample by sample, so the data never has to fit in memory.
+ * The built-in sources:
+ *
+ *   nerve_dataset_idx  IDX image and label files (MNIST and its kin);
+ *                      bytes become x / 255, labels become one-hot
+ *   nerve_dataset_csv  a sample per line: n_inputs then n_outputs numbers,
+ *                      split by commas or blanks; a non-numeric first
+ *                      line is taken as a header and skipped
+ *   nerve_dataset_raw  fixed records of n_inputs + n_outputs values, all
+ *                      float or all bytes; byte inputs become x / 255,
+ *                      byte targets are kept as they are
+ *
+ * Anything else plugs in through nerve_dataset_new and a nerve_source_t,
+ * which takes ownership of `state` and closes it on free. Samples are
+ * drawn from a shuffle buffer of `buffer` samples, refilled as they leave
+ * (0, the default, keeps file order). A background thread decodes the
+ * next batch while the caller trains on the current one.
+ *
+ * nerve_dataset_next returns the batch size, fewer for the last batch, then
+ * 0 once at the end of a pass, or a negative nervenet_error_t. The call
+ * after that starts the next pass. The batches stay valid until the next
+ * call. batch_size must not change within a pass. net_train_dataset runs
+ * one pass and returns the mean loss, or the error.
+ */
+typedef struct
+{
+    int  (*read)(void *state, float *input, float *target); /* 1, 0 at end */
+    int  (*rewind)(void *state);                            /* 0 on success */
+    void (*close)(void *state);
+} nerve_source_t;
+
+typedef struct nerve_dataset_s nerve_dataset_t;
+
+nerve_dataset_t *nerve_dataset_new(const nerve_source_t *source, void *state,
+                                   int n_inputs, int n_outputs);
+nerve_dataset_t *nerve_dataset_idx(const char *images, const char *labels);
+nerve_dataset_t *nerve_dataset_csv(const char *filename,
+                                   int n_inputs, int n_outputs);
+nerve_dataset_t *nerve_dataset_raw(const char *filename,
+                                   int n_inputs, int n_outputs,
+                                   nervenet_data_t type);
+void  nerve_dataset_shuffle(nerve_dataset_t *ds, int buffer,
+                            unsigned long seed);      /* between passes */
+int   nerve_dataset_inputs(const nerve_dataset_t *ds);
+int   nerve_dataset_outputs(const nerve_dataset_t *ds);
+int   nerve_dataset_next(nerve_dataset_t *ds, int batch_size,
+                         const float **inputs, const float **targets);
+void  nerve_dataset_free(nerve_dataset_t *ds);
+float net_train_dataset(network_t *net, nerve_dataset_t *ds, int batch_size);
+float net_train_dataset_r(network_t *net, nerve_dataset_t *ds,
+                          int batch_size, nerve_rng_t *rng);
+
+/* Byte and short inputs ─────────────────────────────────────────────────
+ * Image-like data is stored as bytes. The _raw calls take such rows as they
+ * are — uint8 or int16 (or float), n_inputs per row — and read feature j
+ * as x = scale[j] * raw + offset[j], so a float copy of the dataset is
+ * never made: 784 bytes a sample for MNIST instead of 3136. Training
+ * converts each tile as it gathers it. Batched inference folds scale and
+ * offset into a copy of the first-layer weights, once a call, and feeds
+ * the raw values to it. A NULL scale is all ones, a NULL offset all zeros;
+ * {NERVENET_DATA_U8, s, NULL} with every s[j] = 1/255 is the usual x/255.
+ * Results match the float calls on the converted inputs, to rounding.
+ *
+ * nerve_idx_map maps an IDX file of bytes (MNIST images or labels) in
+ * place: `data` is `count` rows of `width` bytes, the product of the
+ * dimensions after the first, ready for NERVENET_DATA_U8. Without mmap the
+ * file is read into memory instead. It returns a nervenet_error_t.
+ */
+typedef struct
+{
+    nervenet_data_t type;
+    const float    *scale;      /* per input, or NULL */
+    const float    *offset;     /* per input, or NULL */
+} nerve_input_t;
+
+void  net_compute_raw(network_t *net, const nerve_input_t *fmt,
+                      const void *input, float *output);
+void  net_compute_batch_raw(network_t *net, const nerve_input_t *fmt,
+                            const void *inputs, int n, float *outputs);
+float net_train_epoch_raw(network_t *net, const nerve_input_t *fmt,
+                          const void *inputs, const float *targets,
+                          int n_pairs, int n_inputs, int n_outputs,
+                          int batch_size);
+float net_train_epoch_raw_r(network_t *net, const nerve_input_t *fmt,
+                            const void *inputs, const float *targets,
+                            int n_pairs, int n_inputs, int n_outputs,
+                            int batch_size, nerve_rng_t *rng);
+float net_compute_accuracy_raw(network_t *net, const nerve_input_t *fmt,
+                               const void *inputs, const float *targets,
+                               int n_pairs, int n_inputs, int n_outputs);
+
+typedef struct
+{
+    const unsigned char *data;
+    int    count;               /* rows: the first dimension          */
+    int    width;               /* bytes per row                      */
+    void  *base;                /* the whole file, mapped or in memory */
+    size_t bytes;
+    int    mapped;
+} nerve_idx_t;
+
+int  nerve_idx_map(nerve_idx_t *idx, const char *filename);
+void nerve_idx_unmap(nerve_idx_t *idx);
 
 /* Metrics */
 int   net_classify(network_t *net, const float *input);
@@ -293,12 +717,96 @@ void net_confusion_matrix(network_t *net,
                           int n_pairs, int n_inputs, int n_outputs,
                           int n_classes, int *matrix);
 
-/* Structural modification */
+/* int8 post-training quantization ─────────────────────────────────────
+ * net_quantize keeps a quarter of the weight bytes: each row is scaled so
+ * its largest magnitude maps to 127. Compare net_qcompute_accuracy with
+ * net_compute_accuracy on held-out data to see what the rounding cost.
+ */
+qnetwork_t *net_quantize(const network_t *net);
+void        net_qfree(qnetwork_t *q);
+void        net_qcompute(qnetwork_t *q, const float *input, float *output);
+float       net_qcompute_accuracy(qnetwork_t *q,
+                                  const float *inputs, const float *targets,
+                                  int n_pairs, int n_inputs, int n_outputs);
+int         net_qsave(const char *filename, const qnetwork_t *q);
+qnetwork_t *net_qload(const char *filename);
+
+/* Magnitude pruning ─────────────────────────────────────────────────────
+ * net_prune zeroes the smallest-magnitude fraction `sparsity` of every
+ * layer's weights (biases are kept) and marks them pruned: net_train_epoch
+ * then holds them at zero, so the network can be retrained around the gaps.
+ * Pruning only accumulates; it returns the number of weights now pruned, or
+ * NERVENET_ERROR_MEMORY. net_set_prune_schedule prunes gradually instead:
+ * after each of the next `epochs` calls to net_train_epoch the sparsity
+ * steps along s * (1 - (1 - e / epochs)^3) (Zhu & Gupta, 2017), fast at
+ * first and gently at the end. Resizing a layer drops the pruning state.
+ *
+ * net_sparsify turns the zero weights into a compressed-sparse-row copy
+ * whose forward pass does work only for the weights that remain: at 80-90%
+ * sparsity both the model and its inference time shrink several-fold.
+ */
+int         net_prune(network_t *net, float sparsity);
+void        net_set_prune_schedule(network_t *net, float sparsity, int epochs);
+snetwork_t *net_sparsify(const network_t *net);
+void        net_sfree(snetwork_t *s);
+void        net_scompute(snetwork_t *s, const float *input, float *output);
+float       net_scompute_accuracy(snetwork_t *s,
+                                  const float *inputs, const float *targets,
+                                  int n_pairs, int n_inputs, int n_outputs);
+int         net_ssave(const char *filename, const snetwork_t *s);
+snetwork_t *net_sload(const char *filename);
+
+/* Half-precision storage ────────────────────────────────────────────────
+ * net_half keeps half the weight bytes with every weight rounded to
+ * nearest-even in fp16 (about 3 significant digits, range ±65504) or bf16
+ * (about 2 digits, float's range). The forward pass widens each row back to
+ * float — with the F16C instructions under NERVENET_SIMD on CPUs that have
+ * them — and accumulates in float32, so the loss is the weight rounding
+ * alone: typically far below int8's.
+ */
+hnetwork_t *net_half(const network_t *net, nervenet_half_t format);
+void        net_hfree(hnetwork_t *h);
+void        net_hcompute(hnetwork_t *h, const float *input, float *output);
+float       net_hcompute_accuracy(hnetwork_t *h,
+                                  const float *inputs, const float *targets,
+                                  int n_pairs, int n_inputs, int n_outputs);
+int         net_hsave(const char *filename, const hnetwork_t *h);
+hnetwork_t *net_hload(const char *filename);
+
+/* Neuroevolution population ─────────────────────────────────────────────
+ * net_population_allocate makes `size` members with net's topology,
+ * activations and bias switch, each Xavier-initialised. net_population_compute evaluates
+ * every member on its own input row (inputs is size × n_inputs) in one
+ * batched pass. net_population_breed builds the next generation in one
+ * sweep: member m becomes a uniform crossover of parent_a[m] and
+ * parent_b[m] with Gaussian mutation (probability rate, std-dev sigma) —
+ * except the first n_elite members, copied from parent_a[m] unchanged.
+ * Selection stays with the caller. get/set move one member to or from a
+ * network_t of the same topology.
+ */
+net_population_t *net_population_allocate(const network_t *net, int size);
+void  net_population_free(net_population_t *pop);
+void  net_population_compute(net_population_t *pop,
+                             const float *inputs, float *outputs);
+void  net_population_breed(net_population_t *pop,
+                           const int *parent_a, const int *parent_b,
+                           int n_elite, float rate, float sigma);
+void  net_population_breed_r(net_population_t *pop,
+                             const int *parent_a, const int *parent_b,
+                             int n_elite, float rate, float sigma,
+                             nerve_rng_t *rng);
+void  net_population_get(const net_population_t *pop, int member,
+                         network_t *net);
+void  net_population_set(net_population_t *pop, int member,
+                         const network_t *net);
+
+/* Structural modification. The resizes and net_overwrite return
+ * NERVENET_SUCCESS, or a nervenet_error_t with the network unchanged. */
 void       net_jolt(network_t *net, float factor, float range);
-void       net_add_neurons(network_t *net, int layer, int neuron, int n, float range);
-void       net_remove_neurons(network_t *net, int layer, int neuron, int n);
+int        net_add_neurons(network_t *net, int layer, int neuron, int n, float range);
+int        net_remove_neurons(network_t *net, int layer, int neuron, int n);
 network_t *net_copy(const network_t *net);
-void       net_overwrite(network_t *dest, const network_t *src);
+int        net_overwrite(network_t *dest, const network_t *src);
 
 /* Utility */
 int         net_validate(const network_t *net);
@@ -401,16 +909,18 @@ float nerve_score(nerve_t *net, const float *X, const float *y, int n_samples);
  */
 #define NERVE__U32(x) ((x) & 0xFFFFFFFFUL)
 
-static unsigned long nerve__rng_s[4] = {
+static nerve_rng_t nerve__rng = {{
     0x9E3779B9UL, 0x243F6A88UL, 0xB7E15162UL, 0xDEADBEEFUL
-};
+}};
 
 static unsigned long nerve__rotl(unsigned long x, int k)
 {
     return NERVE__U32((x << k) | (NERVE__U32(x) >> (32 - k)));
 }
 
-void nerve_seed(unsigned long seed)
+/* The generator works on any four-word state: the global one, a caller's
+ * nerve_rng_t, or a threaded trainer shard's private stream. */
+static void nerve__rng_seed_state(unsigned long *s, unsigned long seed)
 {
     int i;
     unsigned long z = NERVE__U32(seed);
@@ -422,48 +932,60 @@ void nerve_seed(unsigned long seed)
         t = z;
         t = NERVE__U32((t ^ (t >> 16)) * 0x21F0AAADUL);
         t = NERVE__U32((t ^ (t >> 15)) * 0x735A2D97UL);
-        nerve__rng_s[i] = NERVE__U32(t ^ (t >> 15));
+        s[i] = NERVE__U32(t ^ (t >> 15));
     }
 
     /* The all-zero state is this generator's fixed point: it would emit
      * nothing but zeros forever. SplitMix32 makes it astronomically unlikely,
      * but the cost of ruling it out is one branch. */
-    if ((nerve__rng_s[0] | nerve__rng_s[1] |
-         nerve__rng_s[2] | nerve__rng_s[3]) == 0UL)
-        nerve__rng_s[0] = 0x9E3779B9UL;
+    if ((s[0] | s[1] | s[2] | s[3]) == 0UL)
+        s[0] = 0x9E3779B9UL;
 }
 
-unsigned long nerve_rand_u32(void)
+static unsigned long nerve__rng_next(unsigned long *s)
 {
     unsigned long result =
-        NERVE__U32(nerve__rotl(NERVE__U32(nerve__rng_s[1] * 5UL), 7) * 9UL);
-    unsigned long t = NERVE__U32(nerve__rng_s[1] << 9);
+        NERVE__U32(nerve__rotl(NERVE__U32(s[1] * 5UL), 7) * 9UL);
+    unsigned long t = NERVE__U32(s[1] << 9);
 
-    nerve__rng_s[2] ^= nerve__rng_s[0];
-    nerve__rng_s[3] ^= nerve__rng_s[1];
-    nerve__rng_s[1] ^= nerve__rng_s[2];
-    nerve__rng_s[0] ^= nerve__rng_s[3];
-    nerve__rng_s[2] ^= t;
-    nerve__rng_s[3]  = nerve__rotl(nerve__rng_s[3], 11);
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3]  = nerve__rotl(s[3], 11);
 
     return result;
 }
 
-float nerve_rand_float(void)
+/* Take the top 24 bits: a float's mantissa holds exactly that many, so
+ * every draw is representable and the spacing is uniform. */
+#define NERVE__U32_TO_FLOAT(u) ((float)((u) >> 8) * (1.0f / 16777216.0f))
+
+void nerve_rng_seed(nerve_rng_t *rng, unsigned long seed)
 {
-    /* Take the top 24 bits: a float's mantissa holds exactly that many, so
-     * every draw is representable and the spacing is uniform. */
-    return (float)(nerve_rand_u32() >> 8) * (1.0f / 16777216.0f);
+    assert(rng != NULL);
+    nerve__rng_seed_state(rng->s, seed);
 }
 
-unsigned long nerve_rand_below(unsigned long bound)
+unsigned long nerve_rng_u32(nerve_rng_t *rng)
+{
+    return nerve__rng_next(rng->s);
+}
+
+float nerve_rng_float(nerve_rng_t *rng)
+{
+    return NERVE__U32_TO_FLOAT(nerve__rng_next(rng->s));
+}
+
+unsigned long nerve_rng_below(nerve_rng_t *rng, unsigned long bound)
 {
     unsigned long rem, r;
 
     if (bound <= 1UL) return 0UL;
     bound = NERVE__U32(bound);
 
-    /* `nerve_rand_u32() % bound` is the obvious spelling and it is biased:
+    /* `nerve_rng_u32() % bound` is the obvious spelling and it is biased:
      * 2^32 is not a multiple of most bounds, so the low residues occur once
      * more often than the high ones. Reject the short tail instead, which
      * costs an expected (2^32 mod bound)/2^32 of a redraw — nothing for any
@@ -476,17 +998,125 @@ unsigned long nerve_rand_below(unsigned long bound)
 
     for (;;)
     {
-        r = nerve_rand_u32();
+        r = nerve__rng_next(rng->s);
         if (rem == 0UL || r <= 0xFFFFFFFFUL - rem) return r % bound;
     }
 }
 
-/* ── Sigmoid ──────────────────────────────────────────────────────────── */
-/* Direct computation — avoids the generated lookup table dependency.
- * For peak throughput use the src/ build which includes interpolation.c.  */
+/* The generator is linear over GF(2), so advancing it 2^k steps is a fixed
+ * polynomial in the one-step map. Evaluating that polynomial walks the
+ * 128 bits of its coefficients: XOR the current state into the result for
+ * every set bit, step once per bit. The coefficients are Blackman & Vigna's
+ * published jump and long-jump constants for xoshiro128. */
+static void nerve__rng_jump(nerve_rng_t *rng, const unsigned long *poly)
+{
+    unsigned long t[4];
+    int i, b, k;
+
+    assert(rng != NULL);
+    t[0] = t[1] = t[2] = t[3] = 0UL;
+    for (i = 0; i < 4; i++)
+        for (b = 0; b < 32; b++)
+        {
+            if (poly[i] & (1UL << b))
+                for (k = 0; k < 4; k++) t[k] ^= rng->s[k];
+            nerve__rng_next(rng->s);
+        }
+    for (k = 0; k < 4; k++) rng->s[k] = t[k];
+}
+
+void nerve_rng_jump(nerve_rng_t *rng)
+{
+    static const unsigned long jump[4] = {
+        0x8764000BUL, 0xF542D2D3UL, 0x6FA035C3UL, 0x77F2DB5BUL
+    };
+    nerve__rng_jump(rng, jump);
+}
+
+void nerve_rng_long_jump(nerve_rng_t *rng)
+{
+    static const unsigned long jump[4] = {
+        0xB523952EUL, 0x0B6F099FUL, 0xCCF5A0EFUL, 0x1C580662UL
+    };
+    nerve__rng_jump(rng, jump);
+}
+
+void nerve_seed(unsigned long seed)
+{
+    nerve_rng_seed(&nerve__rng, seed);
+}
+
+unsigned long nerve_rand_u32(void)
+{
+    return nerve_rng_u32(&nerve__rng);
+}
+
+float nerve_rand_float(void)
+{
+    return nerve_rng_float(&nerve__rng);
+}
+
+unsigned long nerve_rand_below(unsigned long bound)
+{
+    return nerve_rng_below(&nerve__rng, bound);
+}
+
+/* The half-precision conversions and the fast exp work on a float's bits,
+ * through a union; this array has negative size, and stops the build,
+ * wherever unsigned int cannot hold exactly those 32 bits. */
+typedef char nerve__float_bits_check[sizeof(float) == 4 &&
+                                     sizeof(unsigned int) == 4 ? 1 : -1];
+typedef union { float f; unsigned int u; } nerve__float_bits_t;
+
+/* ── Transcendentals ──────────────────────────────────────────────────────
+ * By default exp and tanh are libm's, in double. NERVENET_FAST_MATH swaps in
+ * float approximations with no branches or calls, so activation and softmax
+ * loops vectorise:
+ *
+ *   exp      2^n . p(r), r = x - n ln 2 in [-ln2/2, ln2/2] (Cody-Waite),
+ *            p the Cephes degree-7 polynomial. Relative error <= 1e-7 on
+ *            [-87, 88]; x is clamped there, so exp never over- or underflows.
+ *   sigmoid  1 / (1 + exp(-x)). Absolute error <= 1e-7.
+ *   tanh     1 - 2 / (exp(2x) + 1). Absolute error <= 2e-7.
+ *   softmax  through exp. Absolute error <= 4e-7 per output over ten logits,
+ *            most of it the float sum's, which libm's exp shares.
+ *
+ * The derivatives take the activations themselves, so they are unchanged.
+ */
+#if defined(NERVENET_FAST_MATH)
+static float nerve__exp(float x)
+{
+    nerve__float_bits_t b;
+    float r, p;
+    int n;
+    x = x < -87.0f ? -87.0f : x > 88.0f ? 88.0f : x;
+    /* n = round(x / ln 2); the bias keeps the truncation on positives. */
+    n = (int)(x * 1.44269504f + 128.5f) - 128;
+    r = x - (float)n * 0.693359375f;
+    r = r + (float)n * 2.12194440e-4f;
+    p = 1.9875691500e-4f;
+    p = p * r + 1.3981999507e-3f;
+    p = p * r + 8.3334519073e-3f;
+    p = p * r + 4.1665795894e-2f;
+    p = p * r + 1.6666665459e-1f;
+    p = p * r + 5.0000001201e-1f;
+    p = p * r * r + r + 1.0f;
+    b.u = (unsigned int)(n + 127) << 23;
+    return p * b.f;
+}
+
+static float nerve__tanh(float x)
+{
+    return 1.0f - 2.0f / (nerve__exp(2.0f * x) + 1.0f);
+}
+#else
+static float nerve__exp(float x)  { return (float)exp((double)x); }
+static float nerve__tanh(float x) { return (float)tanh((double)x); }
+#endif
+
 static float nerve__sigma(float x)
 {
-    return 1.0f / (1.0f + (float)exp(-(double)x));
+    return 1.0f / (1.0f + nerve__exp(-x));
 }
 
 /* ── Activation helpers ───────────────────────────────────────────────── */
@@ -495,7 +1125,7 @@ static float nerve__activate(float x, int type)
     switch (type)
     {
     case NERVENET_ACTIVATION_TANH:
-        return (float)tanh((double)x);
+        return nerve__tanh(x);
     case NERVENET_ACTIVATION_RELU:
         return x > 0.0f ? x : 0.0f;
     case NERVENET_ACTIVATION_LEAKY_RELU:
@@ -520,14 +1150,106 @@ static float nerve__activate_deriv(float y, int type)
     }
 }
 
-/* ── Adam offset ──────────────────────────────────────────────────────── */
-static int nerve__adam_offset(const network_t *net, int l, int nu, int nl)
+/* ── Aligned storage ──────────────────────────────────────────────────────
+ * Each layer's weights live in one row-major (n_upper, n_lower + 1) matrix,
+ * and all of a network's matrices share one block, each starting on a 64-byte
+ * cache-line boundary. A 784-128-10 net is then four allocations instead of
+ * several hundred, a forward sweep streams one matrix front to back, and the
+ * delta and Adam blocks use the identical layout so the update walks all of
+ * them in lock-step.
+ *
+ * C89 has no aligned allocator, so over-allocate and keep the pointer malloc
+ * returned in the word just below the aligned address.
+ */
+#define NERVE__ALIGN        64
+#define NERVE__ALIGN_FLOATS (NERVE__ALIGN / (int)sizeof(float))
+
+/* Zeroed, like calloc — which it is: a large block comes straight from fresh
+ * zero pages, so an untouched delta block costs no memory until training. */
+static void *nerve__aligned_alloc(size_t bytes)
+{
+    char *raw = (char *)calloc(1, bytes + NERVE__ALIGN + sizeof(void *));
+    char *p;
+    if (!raw) return NULL;
+    p  = raw + sizeof(void *);
+    p += (NERVE__ALIGN - ((size_t)p & (NERVE__ALIGN - 1))) & (NERVE__ALIGN - 1);
+    ((void **)p)[-1] = raw;
+    return p;
+}
+
+static void nerve__aligned_free(void *p)
+{
+    if (p) free(((void **)p)[-1]);
+}
+
+/* net_map needs POSIX mmap; elsewhere (or with NERVENET_NO_MMAP) it reads the
+ * file like net_bload and nothing is ever mapped. */
+#if !defined(NERVENET_NO_MMAP) && (defined(__unix__) || defined(__APPLE__))
+#define NERVE__MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/* net_checkpoint_save hands its writes to a POSIX thread; elsewhere (or with
+ * NERVENET_NO_THREADS) it writes before returning. */
+#if !defined(NERVENET_NO_THREADS) && (defined(__unix__) || defined(__APPLE__))
+#define NERVE__THREADS
+#include <pthread.h>
+#endif
+
+static void nerve__unmap(void *base, size_t bytes)
+{
+#if defined(NERVE__MMAP)
+    munmap(base, bytes);
+#else
+    (void)base; (void)bytes;
+#endif
+}
+
+static float *nerve__alloc_block(int n_floats)
+{
+    return (float *)nerve__aligned_alloc((size_t)n_floats * sizeof(float));
+}
+
+/* Floats in one parallel block: every layer's matrix, each rounded up to a
+ * whole number of cache lines. */
+static int nerve__block_floats(int no_of_layers, const int *sizes)
+{
+    int l, n, total = 0;
+    for (l = 1; l < no_of_layers; l++)
+    {
+        n = sizes[l] * (sizes[l - 1] + 1);
+        total += (n + NERVE__ALIGN_FLOATS - 1) / NERVE__ALIGN_FLOATS *
+                 NERVE__ALIGN_FLOATS;
+    }
+    return total;
+}
+
+/* Point every layer's matrix views, and every neuron's row views, at their
+ * place in the network's blocks. Called after any (re)allocation. */
+static void nerve__bind_blocks(network_t *net)
 {
-    int i, off = 0;
-    for (i = 1; i < l; i++)
-        off += net->layer[i].no_of_neurons *
-               (net->layer[i - 1].no_of_neurons + 1);
-    return off + nu * (net->layer[l - 1].no_of_neurons + 1) + nl;
+    int l, nu, n, stride, off = 0;
+    layer_t *layer;
+    for (l = 1; l < net->no_of_layers; l++)
+    {
+        layer  = &net->layer[l];
+        stride = net->layer[l - 1].no_of_neurons + 1;
+        layer->weight = net->weight_block + off;
+        layer->delta  = net->delta_block  + off;
+        layer->adam_m = net->adam_m ? net->adam_m + off : NULL;
+        layer->adam_v = net->adam_v ? net->adam_v + off : NULL;
+        for (nu = 0; nu < layer->no_of_neurons; nu++)
+        {
+            layer->neuron[nu].weight = layer->weight + (size_t)nu * stride;
+            layer->neuron[nu].delta  = layer->delta  + (size_t)nu * stride;
+        }
+        n    = layer->no_of_neurons * stride;
+        off += (n + NERVE__ALIGN_FLOATS - 1) / NERVE__ALIGN_FLOATS *
+               NERVE__ALIGN_FLOATS;
+    }
 }
 
 /* ── Allocation helpers ───────────────────────────────────────────────── */
@@ -535,46 +1257,224 @@ static void nerve__alloc_layer(layer_t *layer, int n)
 {
     layer->no_of_neurons = n;
     layer->neuron = (neuron_t *)calloc((size_t)(n + 1), sizeof(neuron_t));
+    layer->weight = layer->delta = NULL;
+    layer->adam_m = layer->adam_v = NULL;
 }
 
-static void nerve__alloc_weights(layer_t *lower, layer_t *upper)
+/* ── Profiling ────────────────────────────────────────────────────────────
+ * NERVENET_PROFILE gives every network a nerve_stats_t and brackets the hot
+ * loops with NERVE__PROF_START / NERVE__PROF_STOP: a clock read on either
+ * side of each layer of each pass, and the work added from the shapes.
+ * Without it the three macros expand to nothing: no clock is read, no
+ * counter is touched and net->stats stays NULL.
+ *
+ * Mini-batch shards after the first count into their own copies, added to
+ * the network's after each batch, so no two threads share a counter.
+ * net_compute_ctx, which many threads may run on one network, passes no
+ * stats to the tile pass it shares with net_compute_batch, so it is not
+ * counted.
+ */
+#if defined(NERVENET_PROFILE)
+#if defined(CLOCK_MONOTONIC)
+static double nerve__now(void)
 {
-    int n;
-    for (n = 0; n < upper->no_of_neurons; n++)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+}
+#elif defined(__unix__) || defined(__APPLE__)
+#include <sys/time.h>
+/* Strict ISO builds hide clock_gettime; gettimeofday is still declared. */
+static double nerve__now(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (double)tv.tv_sec + 1e-6 * (double)tv.tv_usec;
+}
+#else
+static double nerve__now(void) { return (double)clock() / CLOCKS_PER_SEC; }
+#endif
+
+/* Declares the stats pointer `st` and its start time; no semicolon after. */
+#define NERVE__PROF_VARS(st, stats) \
+    nerve_stats_t *st = (stats); double st##_t0 = 0.0;
+#define NERVE__PROF_START(st) \
+    do { if (st) st##_t0 = nerve__now(); } while (0)
+#define NERVE__PROF_STOP(st, counter, flops, bytes) \
+    do { if (st) nerve__count(&(st)->counter, st##_t0, \
+                              (double)(flops), (double)(bytes)); } while (0)
+
+/* Per weight of an optimizer step: flops, and bytes of w, d (and m, v)
+ * read and written. */
+#define NERVE__PROF_STEP_FLOPS(net) \
+    ((net)->optimizer == NERVENET_OPTIMIZER_SGD ? 3.0 : 16.0)
+#define NERVE__PROF_STEP_BYTES(net) \
+    ((net)->optimizer == NERVENET_OPTIMIZER_SGD ? 16.0 : 32.0)
+
+/* The counters and their per-layer array, in one piece. */
+static size_t nerve__stats_bytes(int no_of_layers)
+{
+    return sizeof(nerve_stats_t) +
+           (size_t)no_of_layers * sizeof(nerve_layer_stats_t);
+}
+
+/* Lay the counters out in zeroed memory of nerve__stats_bytes. */
+static nerve_stats_t *nerve__stats_init(void *mem, int no_of_layers)
+{
+    nerve_stats_t *st = (nerve_stats_t *)mem;
+    if (!st) return NULL;
+    st->no_of_layers = no_of_layers;
+    st->layer = (nerve_layer_stats_t *)(void *)(st + 1);
+    return st;
+}
+
+static nerve_stats_t *nerve__stats_new(int no_of_layers)
+{
+    return nerve__stats_init(calloc(1, nerve__stats_bytes(no_of_layers)),
+                             no_of_layers);
+}
+
+static void nerve__count(nerve_counter_t *c, double t0,
+                         double flops, double bytes)
+{
+    c->calls++;
+    c->seconds += nerve__now() - t0;
+    c->flops   += flops;
+    c->bytes   += bytes;
+}
+
+static void nerve__counter_add(nerve_counter_t *dst, nerve_counter_t *src)
+{
+    dst->calls   += src->calls;
+    dst->seconds += src->seconds;
+    dst->flops   += src->flops;
+    dst->bytes   += src->bytes;
+    memset(src, 0, sizeof(nerve_counter_t));
+}
+
+/* Move a shard's counters into the network's. */
+static void nerve__stats_add(nerve_stats_t *dst, nerve_stats_t *src)
+{
+    int l;
+    for (l = 0; l < dst->no_of_layers; l++)
     {
-        upper->neuron[n].weight =
-            (float *)calloc((size_t)(lower->no_of_neurons + 1), sizeof(float));
-        upper->neuron[n].delta =
-            (float *)calloc((size_t)(lower->no_of_neurons + 1), sizeof(float));
+        nerve__counter_add(&dst->layer[l].forward,  &src->layer[l].forward);
+        nerve__counter_add(&dst->layer[l].backward, &src->layer[l].backward);
+        nerve__counter_add(&dst->layer[l].update,   &src->layer[l].update);
     }
-    upper->neuron[n].weight = NULL;
-    upper->neuron[n].delta  = NULL;
+    nerve__counter_add(&dst->activation, &src->activation);
+    nerve__counter_add(&dst->rng,        &src->rng);
+    nerve__counter_add(&dst->optimizer,  &src->optimizer);
 }
 
-/* ── Public: Allocation ───────────────────────────────────────────────── */
-network_t *net_allocate_l(int no_of_layers, const int *arglist)
+/* Multiply-adds in layer l's matrix, bias column included. */
+static double nerve__prof_macs(const network_t *net, int l)
 {
-    int l;
-    network_t *net;
-    assert(no_of_layers >= 2 && arglist != NULL);
+    return (double)net->layer[l].no_of_neurons *
+           (double)(net->layer[l - 1].no_of_neurons + 1);
+}
 
-    net = (network_t *)malloc(sizeof(network_t));
-    if (!net) return NULL;
+/* Layer l's matrix and the padding after it: [off, off + n) of each block. */
+static void nerve__layer_span(const network_t *net, int l, int *off, int *n)
+{
+    *off = (int)(net->layer[l].weight - net->weight_block);
+    *n   = (l + 1 < net->no_of_layers
+            ? (int)(net->layer[l + 1].weight - net->weight_block)
+            : net->block_floats) - *off;
+}
 
-    net->no_of_layers = no_of_layers;
-    net->layer = (layer_t *)calloc((size_t)no_of_layers, sizeof(layer_t));
-    if (!net->layer) { free(net); return NULL; }
+/* Bytes one pass over layer l touches for t samples: its matrix, and the
+ * activations (or errors) below and above it. */
+static double nerve__prof_bytes(const network_t *net, int l, int t)
+{
+    return (double)sizeof(float) * (nerve__prof_macs(net, l) + (double)t *
+           (double)(net->layer[l - 1].no_of_neurons + 1 +
+                    net->layer[l].no_of_neurons));
+}
+#else
+#define NERVE__PROF_VARS(st, stats)
+#define NERVE__PROF_START(st)                       ((void)0)
+#define NERVE__PROF_STOP(st, counter, flops, bytes) ((void)0)
+#endif
 
-    for (l = 0; l < no_of_layers; l++)
+const nerve_stats_t *net_get_stats(const network_t *net)
+{
+    assert(net != NULL);
+    return net->stats;
+}
+
+void net_reset_stats(network_t *net)
+{
+    nerve_stats_t *st;
+    assert(net != NULL);
+    st = net->stats;
+    if (!st) return;
+    memset(st->layer, 0,
+           (size_t)st->no_of_layers * sizeof(nerve_layer_stats_t));
+    memset(&st->activation, 0, sizeof(nerve_counter_t));
+    memset(&st->rng,        0, sizeof(nerve_counter_t));
+    memset(&st->optimizer,  0, sizeof(nerve_counter_t));
+}
+
+/* One counter: a CSV row, or a JSON member followed by `sep`. */
+static void nerve__fprint_counter(FILE *file, int format, const char *name,
+                                  int layer, const nerve_counter_t *c,
+                                  const char *sep)
+{
+    if (format == NERVENET_STATS_CSV)
     {
-        assert(arglist[l] > 0);
-        nerve__alloc_layer(&net->layer[l], arglist[l]);
+        if (layer) fprintf(file, "%s,%d,", name, layer);
+        else       fprintf(file, "%s,,", name);
+        fprintf(file, "%lu,%.9f,%.0f,%.0f\n",
+                c->calls, c->seconds, c->flops, c->bytes);
     }
-    for (l = 1; l < no_of_layers; l++)
-        nerve__alloc_weights(&net->layer[l - 1], &net->layer[l]);
+    else
+        fprintf(file, "\"%s\": {\"calls\": %lu, \"seconds\": %.9f, "
+                      "\"flops\": %.0f, \"bytes\": %.0f}%s",
+                name, c->calls, c->seconds, c->flops, c->bytes, sep);
+}
+
+int net_fprint_stats(FILE *file, const network_t *net,
+                     nervenet_stats_format_t format)
+{
+    const nerve_stats_t *st;
+    int l, csv = format == NERVENET_STATS_CSV;
+    if (!file || !net) return NERVENET_ERROR_NULL_POINTER;
+    st = net->stats;
+    if (!st || (!csv && format != NERVENET_STATS_JSON))
+        return NERVENET_ERROR_INVALID_PARAM;
+
+    if (csv) fprintf(file, "counter,layer,calls,seconds,flops,bytes\n");
+    else     fprintf(file, "{\n  \"layers\": [");
+    for (l = 1; l < st->no_of_layers; l++)
+    {
+        if (!csv)
+            fprintf(file, "%s\n    {\"layer\": %d, \"inputs\": %d, "
+                          "\"neurons\": %d,\n     ", l > 1 ? "," : "", l,
+                    net->layer[l - 1].no_of_neurons,
+                    net->layer[l].no_of_neurons);
+        nerve__fprint_counter(file, format, "forward", l,
+                              &st->layer[l].forward, ",\n     ");
+        nerve__fprint_counter(file, format, "backward", l,
+                              &st->layer[l].backward, ",\n     ");
+        nerve__fprint_counter(file, format, "update", l,
+                              &st->layer[l].update, "}");
+    }
+    if (!csv) fprintf(file, "\n  ],\n  ");
+    nerve__fprint_counter(file, format, "activation", 0, &st->activation,
+                          ",\n  ");
+    nerve__fprint_counter(file, format, "rng", 0, &st->rng, ",\n  ");
+    nerve__fprint_counter(file, format, "optimizer", 0, &st->optimizer,
+                          "\n}\n");
+    return ferror(file) ? NERVENET_ERROR_IO : NERVENET_SUCCESS;
+}
 
+/* ── Public: Allocation ───────────────────────────────────────────────── */
+/* Configuration every constructor starts from. */
+static void nerve__set_defaults(network_t *net)
+{
     net->input_layer   = &net->layer[0];
-    net->output_layer  = &net->layer[no_of_layers - 1];
+    net->output_layer  = &net->layer[net->no_of_layers - 1];
     net->momentum      = NERVENET_DEFAULT_MOMENTUM;
     net->learning_rate = NERVENET_DEFAULT_LEARNING_RATE;
     net->global_error  = 0.0f;
@@ -585,107 +1485,237 @@ network_t *net_allocate_l(int no_of_layers, const int *arglist)
     net->optimizer     = NERVENET_OPTIMIZER_SGD;
     net->l2_lambda     = 0.0f;
     net->dropout_rate  = 0.0f;
-    net->adam_m        = NULL;
-    net->adam_v        = NULL;
+    net->threads       = 1;
     net->adam_t        = 0;
     net->adam_beta1    = NERVENET_ADAM_BETA1;
     net->adam_beta2    = NERVENET_ADAM_BETA2;
     net->adam_epsilon  = NERVENET_ADAM_EPSILON;
-
-    net_randomize(net, NERVENET_DEFAULT_WEIGHT_RANGE);
-    net_reset_deltas(net);
+    net->adam_beta1_t  = 1.0f;
+    net->adam_beta2_t  = 1.0f;
+    net->weight_decay  = 0.0f;
+    net->prune_mask    = NULL;
+    net->prune_target  = 0.0f;
+    net->prune_epochs  = 0;
+    net->prune_epoch   = 0;
+#if defined(NERVENET_PROFILE)
+    if (!net->arena_bytes)               /* arena nets carve theirs */
+        net->stats     = nerve__stats_new(net->no_of_layers);
+#else
+    net->stats         = NULL;
+#endif
     net_use_bias(net, 1);
-    return net;
 }
 
-network_t *net_allocate(int no_of_layers, ...)
+/* Everything net_allocate_l does except draw weights: the loaders overwrite
+ * every weight anyway, and must not advance the caller's RNG stream. */
+static network_t *nerve__allocate(int no_of_layers, const int *arglist)
 {
-    int l, *a;
-    va_list args;
+    int l;
     network_t *net;
-    assert(no_of_layers >= 2);
-    a = (int *)calloc((size_t)no_of_layers, sizeof(int));
-    va_start(args, no_of_layers);
-    for (l = 0; l < no_of_layers; l++) a[l] = va_arg(args, int);
-    va_end(args);
-    net = net_allocate_l(no_of_layers, a);
-    free(a);
-    return net;
-}
+    assert(no_of_layers >= 2 && arglist != NULL);
 
-void net_free(network_t *net)
-{
-    int l, n;
-    assert(net != NULL);
-    for (l = 0; l < net->no_of_layers; l++)
+    /* Zeroed, so a failed allocation below can net_free it: prune_mask and
+     * stats are not set until nerve__set_defaults. */
+    net = (network_t *)calloc(1, sizeof(network_t));
+    if (!net) return NULL;
+
+    net->no_of_layers = no_of_layers;
+    net->layer = (layer_t *)calloc((size_t)no_of_layers, sizeof(layer_t));
+    if (!net->layer) { free(net); return NULL; }
+
+    for (l = 0; l < no_of_layers; l++)
     {
-        if (l != 0)
-            for (n = 0; n < net->layer[l].no_of_neurons; n++)
-            {
-                free(net->layer[l].neuron[n].weight);
-                free(net->layer[l].neuron[n].delta);
-            }
-        free(net->layer[l].neuron);
+        assert(arglist[l] > 0);
+        nerve__alloc_layer(&net->layer[l], arglist[l]);
     }
-    free(net->layer);
-    if (net->adam_m) free(net->adam_m);
-    if (net->adam_v) free(net->adam_v);
-    free(net);
+
+    net->block_floats = nerve__block_floats(no_of_layers, arglist);
+    net->weight_block = nerve__alloc_block(net->block_floats);
+    net->delta_block  = nerve__alloc_block(net->block_floats);
+    if (!net->weight_block || !net->delta_block) { net_free(net); return NULL; }
+    nerve__bind_blocks(net);
+    nerve__set_defaults(net);
+#if defined(NERVENET_PROFILE)
+    if (!net->stats) { net_free(net); return NULL; }
+#endif
+    return net;
 }
 
-/* ── Initialisation ───────────────────────────────────────────────────── */
-void net_randomize(network_t *net, float range)
+/* Arena carving: every piece starts on a cache-line boundary, which also
+ * satisfies the alignment of any struct that follows. */
+#define NERVE__ARENA_ROUND(b) \
+    (((size_t)(b) + NERVE__ALIGN - 1) / NERVE__ALIGN * NERVE__ALIGN)
+
+size_t net_size_required(int no_of_layers, const int *sizes, int opts)
 {
-    int l, nu, nl;
-    assert(net && range >= 0.0f);
-    for (l = 1; l < net->no_of_layers; l++)
-        for (nu = 0; nu < net->layer[l].no_of_neurons; nu++)
-            for (nl = 0; nl <= net->layer[l - 1].no_of_neurons; nl++)
-                net->layer[l].neuron[nu].weight[nl] =
-                    2.0f * range * (nerve_rand_float() - 0.5f);
+    int l;
+    size_t blocks, bytes;
+    assert(no_of_layers >= 2 && sizes != NULL);
+    blocks = (size_t)nerve__block_floats(no_of_layers, sizes) * sizeof(float);
+    bytes  = NERVE__ALIGN                     /* to align the caller's buffer */
+           + blocks * ((opts & NERVENET_ARENA_ADAM) ? 4 : 2)
+           + NERVE__ARENA_ROUND(sizeof(network_t))
+           + NERVE__ARENA_ROUND((size_t)no_of_layers * sizeof(layer_t));
+    for (l = 0; l < no_of_layers; l++)
+        bytes += NERVE__ARENA_ROUND((size_t)(sizes[l] + 1) * sizeof(neuron_t));
+#if defined(NERVENET_PROFILE)
+    bytes += NERVE__ARENA_ROUND(nerve__stats_bytes(no_of_layers));
+#endif
+    return bytes;
 }
 
-void net_initialize_xavier(network_t *net)
+network_t *net_allocate_in(void *buffer, size_t size,
+                           int no_of_layers, const int *sizes, int opts)
+{
+    int l;
+    size_t need, blocks;
+    char *p;
+    network_t *net;
+    assert(no_of_layers >= 2 && sizes != NULL);
+    for (l = 0; l < no_of_layers; l++)
+        if (sizes[l] <= 0) return NULL;
+    need = net_size_required(no_of_layers, sizes, opts);
+    if (!buffer || size < need) return NULL;
+
+    p  = (char *)buffer;
+    p += (NERVE__ALIGN - ((size_t)p & (NERVE__ALIGN - 1))) & (NERVE__ALIGN - 1);
+    memset(p, 0, need - NERVE__ALIGN);
+    blocks = (size_t)nerve__block_floats(no_of_layers, sizes) * sizeof(float);
+
+    net = (network_t *)(void *)p;
+    p  += NERVE__ARENA_ROUND(sizeof(network_t));
+    net->weight_block = (float *)(void *)p; p += blocks;
+    net->delta_block  = (float *)(void *)p; p += blocks;
+    if (opts & NERVENET_ARENA_ADAM)
+    {
+        net->adam_m = (float *)(void *)p; p += blocks;
+        net->adam_v = (float *)(void *)p; p += blocks;
+    }
+    net->no_of_layers = no_of_layers;
+    net->layer = (layer_t *)(void *)p;
+    p += NERVE__ARENA_ROUND((size_t)no_of_layers * sizeof(layer_t));
+    for (l = 0; l < no_of_layers; l++)
+    {
+        net->layer[l].no_of_neurons = sizes[l];
+        net->layer[l].neuron = (neuron_t *)(void *)p;
+        p += NERVE__ARENA_ROUND((size_t)(sizes[l] + 1) * sizeof(neuron_t));
+    }
+#if defined(NERVENET_PROFILE)
+    net->stats = nerve__stats_init(p, no_of_layers);
+#endif
+    net->block_floats = nerve__block_floats(no_of_layers, sizes);
+    net->arena_bytes  = need;
+    nerve__bind_blocks(net);
+    nerve__set_defaults(net);
+    net_randomize(net, NERVENET_DEFAULT_WEIGHT_RANGE);
+    return net;
+}
+
+
+network_t *net_allocate_l(int no_of_layers, const int *arglist)
+{
+    network_t *net = nerve__allocate(no_of_layers, arglist);
+    if (net) net_randomize(net, NERVENET_DEFAULT_WEIGHT_RANGE);
+    return net;
+}
+
+network_t *net_allocate(int no_of_layers, ...)
+{
+    int l, *a;
+    va_list args;
+    network_t *net;
+    assert(no_of_layers >= 2);
+    a = (int *)calloc((size_t)no_of_layers, sizeof(int));
+    va_start(args, no_of_layers);
+    for (l = 0; l < no_of_layers; l++) a[l] = va_arg(args, int);
+    va_end(args);
+    net = net_allocate_l(no_of_layers, a);
+    free(a);
+    return net;
+}
+
+void net_free(network_t *net)
 {
-    int l, nu, nl, fi, fo;
-    float r;
+    int l;
     assert(net != NULL);
+    free(net->prune_mask);
+    if (net->arena_bytes) return;        /* the caller owns the buffer */
+    free(net->stats);
+    for (l = 0; l < net->no_of_layers; l++)
+        free(net->layer[l].neuron);
+    free(net->layer);
+    if (net->map_base) nerve__unmap(net->map_base, net->map_bytes);
+    else nerve__aligned_free(net->weight_block);
+    nerve__aligned_free(net->delta_block);
+    nerve__aligned_free(net->adam_m);
+    nerve__aligned_free(net->adam_v);
+    free(net);
+}
+
+/* ── Initialisation ───────────────────────────────────────────────────── */
+/* Fill one layer's matrix uniformly in [-range, range). Row-major order is
+ * the order the per-neuron loops always drew in, so seeded weights are
+ * unchanged by the contiguous layout. */
+static void nerve__fill_uniform(layer_t *upper, const layer_t *lower,
+                                float range, nerve_rng_t *rng)
+{
+    int i, n = upper->no_of_neurons * (lower->no_of_neurons + 1);
+    for (i = 0; i < n; i++)
+        upper->weight[i] = 2.0f * range * (nerve_rng_float(rng) - 0.5f);
+}
+
+void net_randomize_r(network_t *net, float range, nerve_rng_t *rng)
+{
+    int l;
+    assert(net && rng && range >= 0.0f);
+    for (l = 1; l < net->no_of_layers; l++)
+        nerve__fill_uniform(&net->layer[l], &net->layer[l - 1], range, rng);
+}
+
+void net_initialize_xavier_r(network_t *net, nerve_rng_t *rng)
+{
+    int l, fi, fo;
+    assert(net && rng);
     for (l = 1; l < net->no_of_layers; l++)
     {
         fi = net->layer[l - 1].no_of_neurons;
         fo = net->layer[l].no_of_neurons;
-        r  = (float)sqrt(6.0 / (double)(fi + fo));
-        for (nu = 0; nu < net->layer[l].no_of_neurons; nu++)
-            for (nl = 0; nl <= net->layer[l - 1].no_of_neurons; nl++)
-                net->layer[l].neuron[nu].weight[nl] =
-                    2.0f * r * (nerve_rand_float() - 0.5f);
+        nerve__fill_uniform(&net->layer[l], &net->layer[l - 1],
+                            (float)sqrt(6.0 / (double)(fi + fo)), rng);
     }
 }
 
-void net_initialize_he(network_t *net)
+void net_initialize_he_r(network_t *net, nerve_rng_t *rng)
 {
-    int l, nu, nl, fi;
-    float r;
-    assert(net != NULL);
+    int l, fi;
+    assert(net && rng);
     for (l = 1; l < net->no_of_layers; l++)
     {
         fi = net->layer[l - 1].no_of_neurons;
-        r  = (float)sqrt(6.0 / (double)fi);
-        for (nu = 0; nu < net->layer[l].no_of_neurons; nu++)
-            for (nl = 0; nl <= net->layer[l - 1].no_of_neurons; nl++)
-                net->layer[l].neuron[nu].weight[nl] =
-                    2.0f * r * (nerve_rand_float() - 0.5f);
+        nerve__fill_uniform(&net->layer[l], &net->layer[l - 1],
+                            (float)sqrt(6.0 / (double)fi), rng);
     }
 }
 
+void net_randomize(network_t *net, float range)
+{
+    net_randomize_r(net, range, &nerve__rng);
+}
+
+void net_initialize_xavier(network_t *net)
+{
+    net_initialize_xavier_r(net, &nerve__rng);
+}
+
+void net_initialize_he(network_t *net)
+{
+    net_initialize_he_r(net, &nerve__rng);
+}
+
 void net_reset_deltas(network_t *net)
 {
-    int l, nu, nl;
     assert(net != NULL);
-    for (l = 1; l < net->no_of_layers; l++)
-        for (nu = 0; nu < net->layer[l].no_of_neurons; nu++)
-            for (nl = 0; nl <= net->layer[l - 1].no_of_neurons; nl++)
-                net->layer[l].neuron[nu].delta[nl] = 0.0f;
+    memset(net->delta_block, 0, (size_t)net->block_floats * sizeof(float));
 }
 
 /* ── Configuration ────────────────────────────────────────────────────── */
@@ -725,26 +1755,51 @@ void net_set_classification(network_t *net)
 void net_set_l2_lambda(network_t *net, float v)
 { assert(net && v >= 0.0f); net->l2_lambda = v; }
 
+void net_set_weight_decay(network_t *net, float v)
+{ assert(net && v >= 0.0f); net->weight_decay = v; }
+
 void net_set_dropout(network_t *net, float rate)
 { assert(net && rate >= 0.0f && rate < 1.0f); net->dropout_rate = rate; }
 
+void net_set_threads(network_t *net, int threads)
+{ assert(net && threads >= 1); net->threads = threads; }
+
 void net_set_optimizer(network_t *net, nervenet_optimizer_t opt)
 {
-    int nw;
+    int adam = opt == NERVENET_OPTIMIZER_ADAM || opt == NERVENET_OPTIMIZER_ADAMW;
+    size_t bytes;
     assert(net != NULL);
-    if (net->adam_m) { free(net->adam_m); net->adam_m = NULL; }
-    if (net->adam_v) { free(net->adam_v); net->adam_v = NULL; }
+    if (net->arena_bytes)
+    {
+        /* Arena nets never allocate: reuse the moments reserved up front. */
+        assert(!adam || net->adam_m);
+        if (adam && !net->adam_m) return;
+        bytes = (size_t)net->block_floats * sizeof(float);
+        if (adam) { memset(net->adam_m, 0, bytes); memset(net->adam_v, 0, bytes); }
+    }
+    else
+    {
+        nerve__aligned_free(net->adam_m); net->adam_m = NULL;
+        nerve__aligned_free(net->adam_v); net->adam_v = NULL;
+        if (adam)
+        {
+            net->adam_m = nerve__alloc_block(net->block_floats);
+            net->adam_v = nerve__alloc_block(net->block_floats);
+        }
+    }
     net->optimizer = (int)opt;
-    if (opt == NERVENET_OPTIMIZER_ADAM)
+    if (adam)
     {
-        nw = net_get_no_of_weights(net);
-        net->adam_m      = (float *)calloc((size_t)nw, sizeof(float));
-        net->adam_v      = (float *)calloc((size_t)nw, sizeof(float));
         net->adam_t      = 0;
         net->adam_beta1  = NERVENET_ADAM_BETA1;
         net->adam_beta2  = NERVENET_ADAM_BETA2;
         net->adam_epsilon = NERVENET_ADAM_EPSILON;
+        net->adam_beta1_t = 1.0f;
+        net->adam_beta2_t = 1.0f;
+        net->weight_decay = (opt == NERVENET_OPTIMIZER_ADAMW)
+                          ? NERVENET_ADAMW_DECAY : 0.0f;
     }
+    nerve__bind_blocks(net);
 }
 
 /* ── Query ────────────────────────────────────────────────────────────── */
@@ -764,61 +1819,528 @@ int net_get_no_of_weights(const network_t *net)
 }
 
 /* ── Weight access ────────────────────────────────────────────────────── */
+/* Layer l >= 1 owns the weights from layer l - 1 into it; input nl of
+ * lower's no_of_neurons is the bias. */
 void net_set_weight(network_t *net, int l, int nl, int nu, float w)
 {
-    assert(net && 0 <= l && l < net->no_of_layers);
-    net->layer[l].neuron[nu].weight[nl] = w;
+    assert(net && 1 <= l && l < net->no_of_layers);
+    net->layer[l].weight[(size_t)nu * (net->layer[l - 1].no_of_neurons + 1) + nl] = w;
 }
 float net_get_weight(const network_t *net, int l, int nl, int nu)
 {
-    assert(net && 0 <= l && l < net->no_of_layers - 1);
-    return net->layer[l].neuron[nu].weight[nl];
+    assert(net && 1 <= l && l < net->no_of_layers);
+    return net->layer[l].weight[(size_t)nu * (net->layer[l - 1].no_of_neurons + 1) + nl];
 }
 float net_get_bias(const network_t *net, int l, int nu)
-{ return net_get_weight(net, l - 1, net->layer[l - 1].no_of_neurons, nu); }
+{ return net_get_weight(net, l, net->layer[l - 1].no_of_neurons, nu); }
 void net_set_bias(network_t *net, int l, int nu, float w)
-{ net_set_weight(net, l - 1, net->layer[l - 1].no_of_neurons, nu, w); }
+{ net_set_weight(net, l, net->layer[l - 1].no_of_neurons, nu, w); }
+
+/* ── I/O ──────────────────────────────────────────────────────────────────
+ * Text format v2: a "nerve 2" line, the configuration one `key value` line
+ * each, then "weights" and a line per neuron, layer by layer: its lower + 1
+ * weights, bias last. Every float is written in the fewest decimal digits
+ * that read back to the same bits, so a save and load is exact and a
+ * retrained model diffs row by row. Unknown keys are skipped. v1 files —
+ * the layer count, the sizes, three floats, then the weights, all "%f" —
+ * still load.
+ *
+ * Neither direction goes through stdio a number at a time: the writer
+ * formats into a buffer flushed in large fwrites, and the reader takes a
+ * whole line per fgets into one buffer and parses it by hand. A key's
+ * values share its line and numbers never span lines, so the reader stops
+ * at the end of the network's last line without reading ahead: that needs
+ * no seek, which pipes do not have and text-mode streams do not count in
+ * bytes.
+ */
+#define NERVE__TEXT_MAGIC   "nerve"
+#define NERVE__TEXT_VERSION 2
+#define NERVE__TEXT_BUFFER  65536
+
+static const char *const nerve__act_names[] = {
+    "sigmoid", "tanh", "relu", "leaky_relu", "softmax" };
+static const char *const nerve__loss_names[] = { "mse", "cross_entropy" };
+static const char *const nerve__opt_names[]  = { "sgd", "adam", "adamw" };
+
+/* m * 10^e, the one way both the writer's check and the reader evaluate a
+ * decimal; the powers up to 10^22 are exact. */
+static double nerve__scale10(double m, int e)
+{
+    static const double p10[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    double p = 1.0;
+    int k = e < 0 ? -e : e;
+    for (; k > 22; k -= 22) p *= 1e22;
+    p *= p10[k];
+    return e < 0 ? m / p : m * p;
+}
+
+/* Write f as the shortest decimal that nerve__scan_float reads back to the
+ * same float. Nine significant digits always do; fewer are kept while the
+ * rounded value stays inside f's rounding interval, shrunk by a hair so the
+ * reader's own rounding cannot tip it out. Fixed notation from 1e-5 to 1e9,
+ * exponent notation outside, as %g does. Returns the length. */
+static int nerve__ftoa(char *s, float f)
+{
+    static const double p10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8 };
+    static const double inv10[] = {
+        1e0, 1e-1, 1e-2, 1e-3, 1e-4, 1e-5, 1e-6, 1e-7, 1e-8 };
+    nerve__float_bits_t b, nb;
+    double v, m, lo, hi, slack;
+    unsigned long c, t;
+    int q, be, k, nd, x, i, n = 0;
+    char d[10];
+
+    b.f = f;
+    if ((b.u & 0x7F800000u) == 0x7F800000u)
+    {
+        if (b.u & 0x007FFFFFu) { memcpy(s, "nan", 3); return 3; }
+        if (b.u >> 31) s[n++] = '-';
+        memcpy(s + n, "inf", 3);
+        return n + 3;
+    }
+    if (b.u >> 31) s[n++] = '-';
+    b.u &= 0x7FFFFFFFu;
+    if (b.u == 0) { s[n++] = '0'; return n; }
+    v = (double)b.f;
+
+    /* What reads back as f: up to the midpoints with its neighbours. */
+    nb.u = b.u - 1;
+    lo   = ((double)nb.f + v) * 0.5;
+    if (b.u == 0x7F7FFFFFu) hi = v + (v - (double)nb.f) * 0.5;
+    else { nb.u = b.u + 1; hi = ((double)nb.f + v) * 0.5; }
+
+    /* v = m * 10^(q - 8) with m of nine digits. The binary exponent times
+     * log10(2) lands within one of q. */
+    be = (int)(b.u >> 23) - 127;
+    q  = be >= 0 ? be * 1233 / 4096 : -((-be * 1233 + 4095) / 4096);
+    for (;;)
+    {
+        m = nerve__scale10(v, 8 - q);
+        if (m + 0.5 >= 1e9)     q++;
+        else if (m + 0.5 < 1e8) q--;
+        else break;
+    }
+    slack = m * 1e-12;
+    lo = nerve__scale10(lo, 8 - q) + slack;
+    hi = nerve__scale10(hi, 8 - q) - slack;
+    c  = (unsigned long)(m + 0.5);
+    for (k = 1; k <= 8; k++)
+    {
+        t = (unsigned long)(m * inv10[k] + 0.5);
+        if ((double)t * p10[k] <= lo || (double)t * p10[k] >= hi) break;
+        c = t;
+    }
+    for (q += k - 9; c % 10 == 0; c /= 10) q++;
+
+    for (nd = 0; c; c /= 10) d[nd++] = (char)('0' + (int)(c % 10));
+    x = q + nd - 1;                       /* v ~ d.ddd * 10^x           */
+    if (x >= -5 && x < 9)
+    {
+        if (x < 0)
+        {
+            s[n++] = '0'; s[n++] = '.';
+            for (i = -1; i > x; i--) s[n++] = '0';
+        }
+        for (i = nd - 1; i >= 0; i--)
+        {
+            s[n++] = d[i];
+            if (nd - 1 - i == x && i > 0) s[n++] = '.';
+        }
+        for (i = nd - 1; i < x; i++) s[n++] = '0';
+        return n;
+    }
+    s[n++] = d[nd - 1];
+    if (nd > 1) s[n++] = '.';
+    for (i = nd - 2; i >= 0; i--) s[n++] = d[i];
+    s[n++] = 'e';
+    s[n++] = x < 0 ? '-' : '+';
+    if (x < 0) x = -x;
+    if (x >= 10) s[n++] = (char)('0' + x / 10);
+    else         s[n++] = '0';
+    s[n++] = (char)('0' + x % 10);
+    return n;
+}
+
+static const char *nerve__skip_space(const char *p)
+{
+    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r' ||
+           *p == '\f' || *p == '\v') p++;
+    return p;
+}
+
+/* One decimal, "nan" or "inf" at *pp, advancing past it; 0 if there is
+ * none. Nine significant digits — all the writer uses — are gathered in an
+ * integer; longer mantissas are read again in double, up to 17 digits. */
+static int nerve__scan_float(const char **pp, float *out)
+{
+    nerve__float_bits_t b;
+    const char *p = nerve__skip_space(*pp), *num, *q;
+    unsigned long u = 0;
+    double m, v;
+    int neg = 0, e = 0, x = 0, xneg = 0, digits = 0, sig = 0;
+
+    if (*p == '-' || *p == '+') neg = *p++ == '-';
+    if (((p[0] | 32) == 'n' && (p[1] | 32) == 'a' && (p[2] | 32) == 'n') ||
+        ((p[0] | 32) == 'i' && (p[1] | 32) == 'n' && (p[2] | 32) == 'f'))
+    {
+        b.u = (p[0] | 32) == 'n' ? 0x7FC00000u : 0x7F800000u;
+        if (neg) b.u |= 0x80000000u;
+        *out = b.f;
+        for (p += 3; (*p | 32) >= 'a' && (*p | 32) <= 'z'; p++) ;
+        *pp = p;
+        return 1;
+    }
+    num = p;
+    for (; *p >= '0' && *p <= '9'; p++, digits++)
+        if (sig < 9) { u = u * 10 + (unsigned long)(*p - '0'); sig += u != 0; }
+        else sig = 10;
+    if (*p == '.')
+    {
+        for (p++; *p >= '0' && *p <= '9'; p++, digits++)
+            if (sig < 9)
+            { u = u * 10 + (unsigned long)(*p - '0'); sig += u != 0; e--; }
+            else sig = 10;
+    }
+    if (!digits) return 0;
+    m = (double)u;
+    if (sig > 9)
+    {
+        m = 0.0; sig = 0; e = 0;
+        for (q = num; *q >= '0' && *q <= '9'; q++)
+            if (sig < 17) { m = m * 10.0 + (*q - '0'); sig += m != 0.0; }
+            else e++;
+        if (*q == '.')
+        {
+            for (q++; *q >= '0' && *q <= '9'; q++)
+                if (sig < 17) { m = m * 10.0 + (*q - '0'); sig += m != 0.0; e--; }
+        }
+    }
+    if (*p == 'e' || *p == 'E')
+    {
+        q = p + 1;
+        if (*q == '-' || *q == '+') xneg = *q++ == '-';
+        if (*q >= '0' && *q <= '9')
+        {
+            for (; *q >= '0' && *q <= '9'; q++)
+                if (x < 10000) x = x * 10 + (*q - '0');
+            e += xneg ? -x : x;
+            p = q;
+        }
+    }
+    v = m == 0.0 ? 0.0 : nerve__scale10(m, e);
+    if (v >= 3.4028235677973366e38)       /* past FLT_MAX + half an ulp */
+    { b.u = 0x7F800000u; *out = b.f; }
+    else
+        *out = (float)v;
+    if (neg) *out = -*out;
+    *pp = p;
+    return 1;
+}
+
+static int nerve__scan_int(const char **pp, int *out)
+{
+    const char *p = nerve__skip_space(*pp);
+    long v = 0;
+    int neg = 0;
+    if (*p == '-' || *p == '+') neg = *p++ == '-';
+    if (*p < '0' || *p > '9') return 0;
+    for (; *p >= '0' && *p <= '9'; p++)
+        if (v < 0x7FFFFFFFL) v = v * 10 + (*p - '0');
+    if (v > 0x7FFFFFFFL) v = 0x7FFFFFFFL;
+    *out = (int)(neg ? -v : v);
+    *pp = p;
+    return 1;
+}
+
+/* A key or enum name: letters, digits and underscores; its length. */
+static int nerve__scan_word(const char **pp, const char **word)
+{
+    const char *p = nerve__skip_space(*pp);
+    *word = p;
+    while ((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z') ||
+           (*p >= '0' && *p <= '9') || *p == '_') p++;
+    *pp = p;
+    return (int)(p - *word);
+}
+
+static int nerve__is_word(const char *w, int n, const char *name)
+{
+    return (int)strlen(name) == n && memcmp(w, name, (size_t)n) == 0;
+}
+
+/* An enum value by name, or by number; -1 if neither. */
+static int nerve__scan_enum(const char **pp, const char *const *names, int n)
+{
+    const char *w;
+    int i, len, v;
+    if (nerve__scan_int(pp, &v)) return v >= 0 && v < n ? v : -1;
+    len = nerve__scan_word(pp, &w);
+    for (i = 0; i < n; i++)
+        if (nerve__is_word(w, len, names[i])) return i;
+    return -1;
+}
+
+typedef struct
+{
+    FILE       *file;
+    char       *buf;        /* the current line, NUL-terminated           */
+    size_t      cap;
+    const char *p;          /* the scanners' position in it               */
+} nerve__text_in_t;
+
+/* The scanners' position at the next token, reading lines until there is
+ * one; *p is '\0' at the end of the stream or if a long line cannot grow
+ * the buffer. */
+static const char **nerve__text_next(nerve__text_in_t *in)
+{
+    size_t n;
+    char *t;
+    for (;;)
+    {
+        in->p = nerve__skip_space(in->p);
+        if (*in->p) return &in->p;
+        n = 0;
+        while (fgets(in->buf + n, (int)(in->cap - n), in->file))
+        {
+            n += strlen(in->buf + n);
+            if (n && in->buf[n - 1] == '\n') break;
+            if (n + 1 < in->cap) continue;
+            t = (char *)realloc(in->buf, in->cap * 2);
+            if (!t) { n = 0; break; }
+            in->buf = t;
+            in->cap *= 2;
+        }
+        in->buf[n] = '\0';
+        in->p = in->buf;
+        if (n == 0) return &in->p;
+    }
+}
+
+typedef struct
+{
+    FILE  *file;
+    char  *buf;
+    size_t n;
+    int    err;
+} nerve__text_out_t;
+
+static void nerve__text_flush(nerve__text_out_t *o)
+{
+    if (o->n && fwrite(o->buf, 1, o->n, o->file) < o->n) o->err = 1;
+    o->n = 0;
+}
+
+/* Room for the longest float, a separator and a header line. */
+static char *nerve__text_room(nerve__text_out_t *o)
+{
+    if (o->n > NERVE__TEXT_BUFFER - 128) nerve__text_flush(o);
+    return o->buf + o->n;
+}
+
+static void nerve__text_key(nerve__text_out_t *o, const char *key, float v)
+{
+    char *p = nerve__text_room(o);
+    size_t k = strlen(key);
+    memcpy(p, key, k);
+    p[k] = ' ';
+    k += 1 + (size_t)nerve__ftoa(p + k + 1, v);
+    p[k++] = '\n';
+    o->n += k;
+}
 
-/* ── I/O ──────────────────────────────────────────────────────────────── */
 int net_fprint(FILE *file, const network_t *net)
 {
-    int l, nu, nl;
+    nerve__text_out_t o;
+    const float *w;
+    int l, u, j, lower;
     assert(file && net);
-    if (fprintf(file, "%i\n", net->no_of_layers) < 0) return -1;
+    o.file = file;
+    o.n    = 0;
+    o.err  = 0;
+    o.buf  = (char *)malloc(NERVE__TEXT_BUFFER);
+    if (!o.buf) return -1;
+
+    o.n += (size_t)sprintf(o.buf, "%s %d\nlayers %d", NERVE__TEXT_MAGIC,
+                           NERVE__TEXT_VERSION, net->no_of_layers);
     for (l = 0; l < net->no_of_layers; l++)
-        if (fprintf(file, "%i\n", net->layer[l].no_of_neurons) < 0) return -1;
-    if (fprintf(file, "%f\n%f\n%f\n",
-                net->momentum, net->learning_rate, net->global_error) < 0)
-        return -1;
+        o.n += (size_t)sprintf(nerve__text_room(&o), " %d",
+                               net->layer[l].no_of_neurons);
+    o.n += (size_t)sprintf(nerve__text_room(&o),
+                           "\nactivation %s\noutput_activation %s\n"
+                           "loss %s\noptimizer %s\nbias %d\n",
+                           nerve__act_names[net->activation],
+                           nerve__act_names[net->output_activation],
+                           nerve__loss_names[net->loss],
+                           nerve__opt_names[net->optimizer],
+                           net->input_layer->neuron[
+                               net->input_layer->no_of_neurons].output != 0.0f);
+    nerve__text_key(&o, "momentum",      net->momentum);
+    nerve__text_key(&o, "learning_rate", net->learning_rate);
+    nerve__text_key(&o, "error",         net->global_error);
+    nerve__text_key(&o, "l2_lambda",     net->l2_lambda);
+    nerve__text_key(&o, "dropout",       net->dropout_rate);
+    nerve__text_key(&o, "weight_decay",  net->weight_decay);
+    memcpy(nerve__text_room(&o), "weights\n", 8);
+    o.n += 8;
+
     for (l = 1; l < net->no_of_layers; l++)
-        for (nu = 0; nu < net->layer[l].no_of_neurons; nu++)
-            for (nl = 0; nl <= net->layer[l - 1].no_of_neurons; nl++)
-                if (fprintf(file, "%f\n", net->layer[l].neuron[nu].weight[nl]) < 0)
-                    return -1;
+    {
+        lower = net->layer[l - 1].no_of_neurons + 1;
+        w     = net->layer[l].weight;
+        for (u = 0; u < net->layer[l].no_of_neurons; u++)
+            for (j = 0; j < lower; j++, w++)
+            {
+                o.n += (size_t)nerve__ftoa(nerve__text_room(&o), *w);
+                o.buf[o.n++] = j + 1 < lower ? ' ' : '\n';
+            }
+    }
+    nerve__text_flush(&o);
+    free(o.buf);
+    return o.err ? -1 : 0;
+}
+
+/* Each layer's weights, back to back: both versions store them so. */
+static int nerve__scan_weights(nerve__text_in_t *in, network_t *net)
+{
+    int l;
+    size_t i, n;
+    float *w;
+    for (l = 1; l < net->no_of_layers; l++)
+    {
+        n = (size_t)net->layer[l].no_of_neurons *
+            (size_t)(net->layer[l - 1].no_of_neurons + 1);
+        w = net->layer[l].weight;
+        for (i = 0; i < n; i++)
+            if (!nerve__scan_float(nerve__text_next(in), w + i)) return -1;
+    }
     return 0;
 }
 
-network_t *net_fscan(FILE *file)
+static int nerve__valid_sizes(int no_of_layers, const int *sizes)
+{
+    int l;
+    if (no_of_layers < 2 || no_of_layers > NERVENET_MAX_LAYERS) return 0;
+    for (l = 0; l < no_of_layers; l++)
+        if (sizes[l] <= 0 || sizes[l] > NERVENET_MAX_NEURONS) return 0;
+    return 1;
+}
+
+static network_t *nerve__text_v1(nerve__text_in_t *in)
 {
-    int nl2, l, nu, nl, *a;
+    int l, nl, sizes[NERVENET_MAX_LAYERS];
     network_t *net;
-    assert(file != NULL);
-    if (fscanf(file, "%i", &nl2) <= 0) return NULL;
-    a = (int *)calloc((size_t)nl2, sizeof(int));
-    if (!a) return NULL;
-    for (l = 0; l < nl2; l++)
-        if (fscanf(file, "%i", &a[l]) <= 0) { free(a); return NULL; }
-    net = net_allocate_l(nl2, a);
-    free(a);
+    if (!nerve__scan_int(nerve__text_next(in), &nl) ||
+        nl < 2 || nl > NERVENET_MAX_LAYERS)
+        return NULL;
+    for (l = 0; l < nl; l++)
+        if (!nerve__scan_int(nerve__text_next(in), &sizes[l])) return NULL;
+    if (!nerve__valid_sizes(nl, sizes)) return NULL;
+    net = nerve__allocate(nl, sizes);
     if (!net) return NULL;
-    if (fscanf(file, "%f%f%f",
-               &net->momentum, &net->learning_rate, &net->global_error) < 3)
+    if (!nerve__scan_float(nerve__text_next(in), &net->momentum) ||
+        !nerve__scan_float(nerve__text_next(in), &net->learning_rate) ||
+        !nerve__scan_float(nerve__text_next(in), &net->global_error) ||
+        nerve__scan_weights(in, net) != 0)
     { net_free(net); return NULL; }
-    for (l = 1; l < net->no_of_layers; l++)
-        for (nu = 0; nu < net->layer[l].no_of_neurons; nu++)
-            for (nl = 0; nl <= net->layer[l - 1].no_of_neurons; nl++)
-                if (fscanf(file, "%f", &net->layer[l].neuron[nu].weight[nl]) <= 0)
-                { net_free(net); return NULL; }
+    return net;
+}
+
+static network_t *nerve__text_v2(nerve__text_in_t *in)
+{
+    int l, len, nl = 0, sizes[NERVENET_MAX_LAYERS], version;
+    int act = 0, out_act = 0, loss = 0, opt = 0, bias = 1;
+    float mom = 0.0f, lr = 0.0f, err = 0.0f, l2 = 0.0f, drop = 0.0f;
+    float decay = 0.0f;
+    const char *w, **pp = &in->p;
+    network_t *net;
+
+    if (!nerve__scan_int(pp, &version) || version != NERVE__TEXT_VERSION)
+        return NULL;
+    for (;;)
+    {
+        len = nerve__scan_word(nerve__text_next(in), &w);
+        if (len == 0) return NULL;
+        if (nerve__is_word(w, len, "weights")) break;
+        if (nerve__is_word(w, len, "layers"))
+        {
+            if (!nerve__scan_int(pp, &nl) || nl < 2 || nl > NERVENET_MAX_LAYERS)
+                return NULL;
+            for (l = 0; l < nl; l++)
+                if (!nerve__scan_int(pp, &sizes[l])) return NULL;
+        }
+        else if (nerve__is_word(w, len, "activation"))
+            act = nerve__scan_enum(pp, nerve__act_names, 5);
+        else if (nerve__is_word(w, len, "output_activation"))
+            out_act = nerve__scan_enum(pp, nerve__act_names, 5);
+        else if (nerve__is_word(w, len, "loss"))
+            loss = nerve__scan_enum(pp, nerve__loss_names, 2);
+        else if (nerve__is_word(w, len, "optimizer"))
+            opt = nerve__scan_enum(pp, nerve__opt_names, 3);
+        else if (nerve__is_word(w, len, "bias"))
+        { if (!nerve__scan_int(pp, &bias)) return NULL; }
+        else if (nerve__is_word(w, len, "momentum"))
+        { if (!nerve__scan_float(pp, &mom)) return NULL; }
+        else if (nerve__is_word(w, len, "learning_rate"))
+        { if (!nerve__scan_float(pp, &lr)) return NULL; }
+        else if (nerve__is_word(w, len, "error"))
+        { if (!nerve__scan_float(pp, &err)) return NULL; }
+        else if (nerve__is_word(w, len, "l2_lambda"))
+        { if (!nerve__scan_float(pp, &l2)) return NULL; }
+        else if (nerve__is_word(w, len, "dropout"))
+        { if (!nerve__scan_float(pp, &drop)) return NULL; }
+        else if (nerve__is_word(w, len, "weight_decay"))
+        { if (!nerve__scan_float(pp, &decay)) return NULL; }
+        else
+            while (**pp && **pp != '\n') (*pp)++;   /* a newer key */
+        if (act < 0 || out_act < 0 || loss < 0 || opt < 0) return NULL;
+    }
+    if (!nerve__valid_sizes(nl, sizes)) return NULL;
+
+    net = nerve__allocate(nl, sizes);
+    if (!net) return NULL;
+    net->activation        = act;
+    net->output_activation = out_act;
+    net->loss              = loss;
+    net_use_bias(net, bias);
+    if (opt != NERVENET_OPTIMIZER_SGD)
+        net_set_optimizer(net, (nervenet_optimizer_t)opt);
+    net->momentum      = mom;
+    net->learning_rate = lr;
+    net->global_error  = err;
+    net->l2_lambda     = l2;
+    net->dropout_rate  = drop;
+    net->weight_decay  = decay;
+    if (nerve__scan_weights(in, net) != 0) { net_free(net); return NULL; }
+    return net;
+}
+
+/* The stream is left at the start of the line after the network's last
+ * weight. */
+network_t *net_fscan(FILE *file)
+{
+    nerve__text_in_t in;
+    const char *start, *w;
+    network_t *net;
+    assert(file != NULL);
+    in.file = file;
+    in.cap  = NERVE__TEXT_BUFFER;
+    in.buf  = (char *)malloc(in.cap);
+    if (!in.buf) return NULL;
+    in.buf[0] = '\0';
+    in.p = in.buf;
+    start = *nerve__text_next(&in);
+    if (nerve__scan_word(&in.p, &w) == 5 &&
+        memcmp(w, NERVE__TEXT_MAGIC, 5) == 0)
+        net = nerve__text_v2(&in);
+    else
+    {
+        in.p = start;
+        net = nerve__text_v1(&in);
+    }
+    free(in.buf);
     return net;
 }
 
@@ -844,52 +2366,212 @@ network_t *net_load(const char *fn)
     return net;
 }
 
+/* Binary format ──────────────────────────────────────────────────────────
+ * NRVB v2, native endianness and 32-bit int/float like v1:
+ *
+ *   "NRVB"  int hdr[NERVE__BH_INTS]  float cfg[NERVE__BC_FLOATS]
+ *   int sizes[no_of_layers]  zero padding to a multiple of 64 bytes
+ *   weight_block, verbatim: block_floats floats, every layer 64-byte aligned
+ *
+ * hdr[NERVE__BH_DATA] is the byte offset of the weight block, so a mapping of
+ * the file is already laid out the way nerve__bind_blocks wants it. The
+ * checksum covers the header, config, sizes and weight block, and the enums
+ * are range-checked before any of them is used. v1 files — the layer count, the sizes,
+ * three floats, then each layer's weights — still load: their first int is
+ * never the magic.
+ */
+#define NERVE__BMAGIC   "NRVB"
+#define NERVE__BVERSION 2
+
+enum
+{
+    NERVE__BH_VERSION, NERVE__BH_DATA, NERVE__BH_LAYERS, NERVE__BH_FLOATS,
+    NERVE__BH_ACT, NERVE__BH_OUT_ACT, NERVE__BH_LOSS, NERVE__BH_OPTIMIZER,
+    NERVE__BH_BIAS, NERVE__BH_CHECKSUM, NERVE__BH_INTS
+};
+enum
+{
+    NERVE__BC_MOMENTUM, NERVE__BC_LR, NERVE__BC_ERROR, NERVE__BC_L2,
+    NERVE__BC_DROPOUT, NERVE__BC_DECAY, NERVE__BC_FLOATS
+};
+
+static size_t nerve__bdata_offset(int no_of_layers)
+{
+    size_t n = 4 + NERVE__BH_INTS * sizeof(int) + NERVE__BC_FLOATS * sizeof(float)
+             + (size_t)no_of_layers * sizeof(int);
+    return (n + NERVE__ALIGN - 1) / NERVE__ALIGN * NERVE__ALIGN;
+}
+
+/* FNV-1a over 32-bit words, continuing from h. */
+static unsigned long nerve__fnv(unsigned long h, const void *p, size_t n)
+{
+    const unsigned char *b = (const unsigned char *)p;
+    unsigned int w;
+    size_t i;
+    for (i = 0; i < n; i++)
+    {
+        memcpy(&w, b + i * sizeof(w), sizeof(w));
+        h = ((h ^ (unsigned long)w) * 16777619UL) & 0xFFFFFFFFUL;
+    }
+    return h;
+}
+
+/* Every header int but the checksum itself, the config, the sizes and the
+ * weight block: a flipped enum or rate is caught like a flipped weight. */
+static int nerve__checksum(const int *hdr, const float *cfg, const int *sizes,
+                           const float *block)
+{
+    unsigned long h = 2166136261UL;
+    h = nerve__fnv(h, hdr, NERVE__BH_CHECKSUM);
+    h = nerve__fnv(h, cfg, NERVE__BC_FLOATS);
+    h = nerve__fnv(h, sizes, (size_t)hdr[NERVE__BH_LAYERS]);
+    h = nerve__fnv(h, block, (size_t)hdr[NERVE__BH_FLOATS]);
+    return (int)(h & 0x7FFFFFFFUL);       /* stored in an int: keep it positive */
+}
+
+/* Validate a v2 header and build the network it describes, weights unset. */
+static network_t *nerve__bnew(const int *hdr, const float *cfg, const int *sizes)
+{
+    int l;
+    network_t *net;
+    if (hdr[NERVE__BH_VERSION] != NERVE__BVERSION) return NULL;
+    if (hdr[NERVE__BH_LAYERS] < 2 ||
+        hdr[NERVE__BH_LAYERS] > NERVENET_MAX_LAYERS) return NULL;
+    for (l = 0; l < hdr[NERVE__BH_LAYERS]; l++)
+        if (sizes[l] <= 0 || sizes[l] > NERVENET_MAX_NEURONS) return NULL;
+    if ((size_t)hdr[NERVE__BH_DATA] !=
+        nerve__bdata_offset(hdr[NERVE__BH_LAYERS])) return NULL;
+    if (hdr[NERVE__BH_ACT] < 0 ||
+        hdr[NERVE__BH_ACT] > NERVENET_ACTIVATION_SOFTMAX ||
+        hdr[NERVE__BH_OUT_ACT] < 0 ||
+        hdr[NERVE__BH_OUT_ACT] > NERVENET_ACTIVATION_SOFTMAX ||
+        hdr[NERVE__BH_LOSS] < 0 ||
+        hdr[NERVE__BH_LOSS] > NERVENET_LOSS_CROSS_ENTROPY ||
+        hdr[NERVE__BH_OPTIMIZER] < 0 ||
+        hdr[NERVE__BH_OPTIMIZER] > NERVENET_OPTIMIZER_ADAMW ||
+        (hdr[NERVE__BH_BIAS] != 0 && hdr[NERVE__BH_BIAS] != 1)) return NULL;
+    net = nerve__allocate(hdr[NERVE__BH_LAYERS], sizes);
+    if (!net) return NULL;
+    if (net->block_floats != hdr[NERVE__BH_FLOATS]) { net_free(net); return NULL; }
+    net->activation        = hdr[NERVE__BH_ACT];
+    net->output_activation = hdr[NERVE__BH_OUT_ACT];
+    net->loss              = hdr[NERVE__BH_LOSS];
+    net_use_bias(net, hdr[NERVE__BH_BIAS]);
+    if (hdr[NERVE__BH_OPTIMIZER] != NERVENET_OPTIMIZER_SGD)
+        net_set_optimizer(net, (nervenet_optimizer_t)hdr[NERVE__BH_OPTIMIZER]);
+    net->momentum      = cfg[NERVE__BC_MOMENTUM];
+    net->learning_rate = cfg[NERVE__BC_LR];
+    net->global_error  = cfg[NERVE__BC_ERROR];
+    net->l2_lambda     = cfg[NERVE__BC_L2];
+    net->dropout_rate  = cfg[NERVE__BC_DROPOUT];
+    net->weight_decay  = cfg[NERVE__BC_DECAY];
+    return net;
+}
+
 int net_fbprint(FILE *file, const network_t *net)
 {
-    int l, nu, *info;
-    size_t dim;
-    float c[3];
+    int l, hdr[NERVE__BH_INTS], *sizes;
+    float cfg[NERVE__BC_FLOATS];
+    char pad[NERVE__ALIGN];
+    size_t head, n;
     assert(file && net);
-    dim  = (size_t)(net->no_of_layers + 1);
-    info = (int *)malloc(dim * sizeof(int));
-    if (!info) return -1;
-    info[0] = net->no_of_layers;
-    for (l = 0; l < net->no_of_layers; l++) info[l + 1] = net->layer[l].no_of_neurons;
-    if (fwrite(info, sizeof(int), dim, file) < dim) { free(info); return -1; }
-    free(info);
-    c[0] = net->momentum; c[1] = net->learning_rate; c[2] = net->global_error;
-    if (fwrite(c, sizeof(float), 3, file) < 3) return -1;
-    for (l = 1; l < net->no_of_layers; l++)
-        for (nu = 0; nu < net->layer[l].no_of_neurons; nu++)
-            fwrite(net->layer[l].neuron[nu].weight, sizeof(float),
-                   (size_t)(net->layer[l - 1].no_of_neurons + 1), file);
+    n    = (size_t)net->no_of_layers;
+    head = 4 + sizeof(hdr) + sizeof(cfg) + n * sizeof(int);
+    hdr[NERVE__BH_VERSION]   = NERVE__BVERSION;
+    hdr[NERVE__BH_DATA]      = (int)nerve__bdata_offset(net->no_of_layers);
+    hdr[NERVE__BH_LAYERS]    = net->no_of_layers;
+    hdr[NERVE__BH_FLOATS]    = net->block_floats;
+    hdr[NERVE__BH_ACT]       = net->activation;
+    hdr[NERVE__BH_OUT_ACT]   = net->output_activation;
+    hdr[NERVE__BH_LOSS]      = net->loss;
+    hdr[NERVE__BH_OPTIMIZER] = net->optimizer;
+    hdr[NERVE__BH_BIAS]      =
+        net->input_layer->neuron[net->input_layer->no_of_neurons].output != 0.0f;
+    cfg[NERVE__BC_MOMENTUM]  = net->momentum;
+    cfg[NERVE__BC_LR]        = net->learning_rate;
+    cfg[NERVE__BC_ERROR]     = net->global_error;
+    cfg[NERVE__BC_L2]        = net->l2_lambda;
+    cfg[NERVE__BC_DROPOUT]   = net->dropout_rate;
+    cfg[NERVE__BC_DECAY]     = net->weight_decay;
+    sizes = (int *)malloc(n * sizeof(int));
+    if (!sizes) return -1;
+    for (l = 0; l < net->no_of_layers; l++) sizes[l] = net->layer[l].no_of_neurons;
+    hdr[NERVE__BH_CHECKSUM]  = nerve__checksum(hdr, cfg, sizes, net->weight_block);
+    memset(pad, 0, sizeof(pad));
+    if (fwrite(NERVE__BMAGIC, 1, 4, file) < 4 ||
+        fwrite(hdr, sizeof(int), NERVE__BH_INTS, file) < NERVE__BH_INTS ||
+        fwrite(cfg, sizeof(float), NERVE__BC_FLOATS, file) < NERVE__BC_FLOATS ||
+        fwrite(sizes, sizeof(int), n, file) < n ||
+        fwrite(pad, 1, (size_t)hdr[NERVE__BH_DATA] - head, file) <
+            (size_t)hdr[NERVE__BH_DATA] - head)
+    { free(sizes); return -1; }
+    free(sizes);
+    /* The whole block in one write: the file is the in-memory layout. */
+    n = (size_t)net->block_floats;
+    if (fwrite(net->weight_block, sizeof(float), n, file) < n) return -1;
     return 0;
 }
 
-network_t *net_fbscan(FILE *file)
+/* v1: no header, no config, one unpadded matrix per layer. */
+static network_t *nerve__fbscan_v1(FILE *file, int nl2)
 {
-    int nl2, l, nu, *a;
-    size_t rd;
+    int l, *a;
+    size_t n;
     network_t *net;
-    assert(file != NULL);
-    if (fread(&nl2, sizeof(int), 1, file) < 1) return NULL;
+    if (nl2 < 2 || nl2 > NERVENET_MAX_LAYERS) return NULL;
     a = (int *)calloc((size_t)nl2, sizeof(int));
     if (!a) return NULL;
     if (fread(a, sizeof(int), (size_t)nl2, file) < (size_t)nl2) { free(a); return NULL; }
-    net = net_allocate_l(nl2, a);
+    for (l = 0; l < nl2; l++)
+        if (a[l] <= 0 || a[l] > NERVENET_MAX_NEURONS) { free(a); return NULL; }
+    net = nerve__allocate(nl2, a);
     free(a);
     if (!net) return NULL;
     if (fread(&net->momentum,      sizeof(float), 1, file) < 1) { net_free(net); return NULL; }
     if (fread(&net->learning_rate, sizeof(float), 1, file) < 1) { net_free(net); return NULL; }
     if (fread(&net->global_error,  sizeof(float), 1, file) < 1) { net_free(net); return NULL; }
     for (l = 1; l < net->no_of_layers; l++)
-        for (nu = 0; nu < net->layer[l].no_of_neurons; nu++)
-        {
-            rd = fread(net->layer[l].neuron[nu].weight, sizeof(float),
-                       (size_t)(net->layer[l - 1].no_of_neurons + 1), file);
-            if (rd < (size_t)(net->layer[l - 1].no_of_neurons + 1))
-            { net_free(net); return NULL; }
-        }
+    {
+        n = (size_t)net->layer[l].no_of_neurons *
+            (size_t)(net->layer[l - 1].no_of_neurons + 1);
+        if (fread(net->layer[l].weight, sizeof(float), n, file) < n)
+        { net_free(net); return NULL; }
+    }
+    return net;
+}
+
+network_t *net_fbscan(FILE *file)
+{
+    int first, hdr[NERVE__BH_INTS], *sizes = NULL;
+    float cfg[NERVE__BC_FLOATS];
+    char pad[NERVE__ALIGN];
+    size_t head, n;
+    network_t *net = NULL;
+    assert(file != NULL);
+    if (fread(&first, sizeof(int), 1, file) < 1) return NULL;
+    if (memcmp(&first, NERVE__BMAGIC, 4) != 0)
+        return nerve__fbscan_v1(file, first);
+
+    if (fread(hdr, sizeof(int), NERVE__BH_INTS, file) < NERVE__BH_INTS ||
+        fread(cfg, sizeof(float), NERVE__BC_FLOATS, file) < NERVE__BC_FLOATS ||
+        hdr[NERVE__BH_LAYERS] < 2 || hdr[NERVE__BH_LAYERS] > NERVENET_MAX_LAYERS)
+        return NULL;
+    n     = (size_t)hdr[NERVE__BH_LAYERS];
+    head  = 4 + sizeof(hdr) + sizeof(cfg) + n * sizeof(int);
+    sizes = (int *)malloc(n * sizeof(int));
+    if (!sizes) return NULL;
+    if (fread(sizes, sizeof(int), n, file) == n &&
+        (net = nerve__bnew(hdr, cfg, sizes)) != NULL)
+    {
+        n = (size_t)net->block_floats;
+        if (fread(pad, 1, (size_t)hdr[NERVE__BH_DATA] - head, file) <
+                (size_t)hdr[NERVE__BH_DATA] - head ||
+            fread(net->weight_block, sizeof(float), n, file) < n ||
+            nerve__checksum(hdr, cfg, sizes, net->weight_block) !=
+                hdr[NERVE__BH_CHECKSUM])
+        { net_free(net); net = NULL; }
+    }
+    free(sizes);
     return net;
 }
 
@@ -913,6 +2595,237 @@ network_t *net_bload(const char *fn)
     return net;
 }
 
+/* Map a v2 file privately and point weight_block at its payload: no read, no
+ * copy, and processes mapping the same file share its page cache. Pages are
+ * copy-on-write, so training a mapped net works and never touches the file.
+ * The checksum is not verified — that would fault in every page; net_bload
+ * verifies it. v1 files and platforms without mmap fall back to net_bload. */
+network_t *net_map(const char *fn)
+{
+#if defined(NERVE__MMAP)
+    int fd, hdr[NERVE__BH_INTS];
+    float cfg[NERVE__BC_FLOATS];
+    struct stat st;
+    size_t bytes, head;
+    unsigned char *base;
+    network_t *net;
+    assert(fn != NULL);
+    fd = open(fn, O_RDONLY);
+    if (fd < 0) return NULL;
+    if (fstat(fd, &st) != 0) { close(fd); return NULL; }
+    bytes = (size_t)st.st_size;
+    head  = 4 + sizeof(hdr) + sizeof(cfg);
+    if (bytes < head) { close(fd); return NULL; }
+    base = (unsigned char *)mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+                                 MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == (unsigned char *)MAP_FAILED) return NULL;
+    if (memcmp(base, NERVE__BMAGIC, 4) != 0)
+    { munmap(base, bytes); return net_bload(fn); }
+
+    memcpy(hdr, base + 4, sizeof(hdr));
+    memcpy(cfg, base + 4 + sizeof(hdr), sizeof(cfg));
+    net = NULL;
+    if (hdr[NERVE__BH_LAYERS] >= 2 && hdr[NERVE__BH_LAYERS] <= NERVENET_MAX_LAYERS &&
+        hdr[NERVE__BH_FLOATS] >= 0 &&
+        nerve__bdata_offset(hdr[NERVE__BH_LAYERS]) +
+            (size_t)hdr[NERVE__BH_FLOATS] * sizeof(float) <= bytes)
+        net = nerve__bnew(hdr, cfg, (const int *)(const void *)(base + head));
+    if (!net) { munmap(base, bytes); return NULL; }
+    nerve__aligned_free(net->weight_block);
+    net->weight_block = (float *)(void *)(base + hdr[NERVE__BH_DATA]);
+    net->map_base     = base;
+    net->map_bytes    = bytes;
+    nerve__bind_blocks(net);
+    return net;
+#else
+    return net_bload(fn);
+#endif
+}
+
+/* ── C export ─────────────────────────────────────────────────────────────
+ * A layer with at most NERVE__EXPORT_UNROLL weights is emitted one output
+ * per statement with its weights as literals; larger layers become a
+ * static const [nu][nl] matrix plus bias vector and a pair of constant-bound
+ * loops the compiler can unroll and vectorise itself. Biases are folded the
+ * way net_quantize folds them. Hidden activations ping-pong between two
+ * stack arrays as wide as the widest hidden layer.
+ */
+#define NERVE__EXPORT_UNROLL 256
+
+/* "%.9g" round-trips every float; give it a decimal point and an f. */
+static void nerve__export_float(FILE *file, float v)
+{
+    char buf[32];
+    sprintf(buf, "%.9g", (double)v);
+    fprintf(file, strpbrk(buf, ".e") ? "%sf" : "%s.0f", buf);
+}
+
+/* Apply activation `act` to s and store it in dst[u]. */
+static void nerve__export_activate(FILE *file, const char *dst, int act)
+{
+    switch (act)
+    {
+    case NERVENET_ACTIVATION_SOFTMAX:
+        fprintf(file, "%s = s;\n", dst);
+        break;
+    case NERVENET_ACTIVATION_TANH:
+        fprintf(file, "%s = (float)tanh((double)s);\n", dst);
+        break;
+    case NERVENET_ACTIVATION_RELU:
+        fprintf(file, "%s = s > 0.0f ? s : 0.0f;\n", dst);
+        break;
+    case NERVENET_ACTIVATION_LEAKY_RELU:
+        fprintf(file, "%s = s > 0.0f ? s : 0.01f * s;\n", dst);
+        break;
+    default:
+        fprintf(file, "%s = 1.0f / (1.0f + (float)exp(-(double)s));\n", dst);
+        break;
+    }
+}
+
+static int nerve__export_unrolled(const network_t *net, int l)
+{
+    return (long)net->layer[l].no_of_neurons *
+           (long)net->layer[l - 1].no_of_neurons <= NERVE__EXPORT_UNROLL;
+}
+
+int net_export_c(FILE *file, const network_t *net, const char *name)
+{
+    int l, u, j, nl, nu, act, width = 0, loops = 0;
+    int L;
+    const float *row;
+    float b, v;
+    const char *src, *dst, *buf[2];
+    char out[32];
+    assert(file && net && name);
+
+    /* The name becomes a C identifier and a prefix for the tables. */
+    if (!((*name >= 'a' && *name <= 'z') || (*name >= 'A' && *name <= 'Z') ||
+          *name == '_') || strlen(name) > 64)
+        return -1;
+    for (src = name; *src; src++)
+        if (!((*src >= 'a' && *src <= 'z') || (*src >= 'A' && *src <= 'Z') ||
+              (*src >= '0' && *src <= '9') || *src == '_'))
+            return -1;
+    L = net->no_of_layers;
+    for (l = 1; l < L; l++)
+    {
+        nl = net->layer[l - 1].no_of_neurons;
+        for (j = 0; j < net->layer[l].no_of_neurons * (nl + 1); j++)
+            if (!(net->layer[l].weight[j] - net->layer[l].weight[j] == 0.0f))
+                return -1;              /* inf or NaN has no literal */
+        if (l < L - 1 && net->layer[l].no_of_neurons > width)
+            width = net->layer[l].no_of_neurons;
+        if (!nerve__export_unrolled(net, l)) loops = 1;
+    }
+
+    fprintf(file, "/* %s: ", name);
+    for (l = 0; l < L; l++)
+        fprintf(file, l ? "-%d" : "%d", net->layer[l].no_of_neurons);
+    fprintf(file, " network exported by Nerve %s.\n"
+                  " * Call %s(input, output) with %d inputs and room for"
+                  " %d outputs. */\n#include <math.h>\n\n",
+            NERVENET_VERSION, name, net->input_layer->no_of_neurons,
+            net->output_layer->no_of_neurons);
+
+    for (l = 1; l < L; l++)
+    {
+        if (nerve__export_unrolled(net, l)) continue;
+        nl = net->layer[l - 1].no_of_neurons;
+        nu = net->layer[l].no_of_neurons;
+        fprintf(file, "static const float %s_w%d[%d][%d] = {\n",
+                name, l, nu, nl);
+        for (u = 0; u < nu; u++)
+        {
+            row = net->layer[l].weight + (size_t)u * (nl + 1);
+            fprintf(file, "    {");
+            for (j = 0; j < nl; j++)
+            {
+                fprintf(file, j % 6 ? ", " : j ? ",\n     " : " ");
+                nerve__export_float(file, row[j]);
+            }
+            fprintf(file, " }%s\n", u < nu - 1 ? "," : "");
+        }
+        fprintf(file, "};\nstatic const float %s_b%d[%d] = {", name, l, nu);
+        for (u = 0; u < nu; u++)
+        {
+            row = net->layer[l].weight + (size_t)u * (nl + 1);
+            fprintf(file, u % 6 ? ", " : u ? ",\n    " : "\n    ");
+            nerve__export_float(file,
+                                row[nl] * net->layer[l - 1].neuron[nl].output);
+        }
+        fprintf(file, "\n};\n\n");
+    }
+
+    fprintf(file, "void %s(const float *input, float *output)\n{\n", name);
+    if (L > 3)
+        fprintf(file, "    float a[%d], b[%d];\n", width, width);
+    else if (L > 2)
+        fprintf(file, "    float a[%d];\n", width);
+    fprintf(file, "    float s;\n");
+    if (net->output_activation == NERVENET_ACTIVATION_SOFTMAX)
+        fprintf(file, "    float m, z;\n");
+    if (loops || net->output_activation == NERVENET_ACTIVATION_SOFTMAX)
+        fprintf(file, "    int u%s;\n", loops ? ", j" : "");
+
+    buf[0] = "a"; buf[1] = "b";
+    for (l = 1; l < L; l++)
+    {
+        nl  = net->layer[l - 1].no_of_neurons;
+        nu  = net->layer[l].no_of_neurons;
+        src = l == 1 ? "input" : buf[l % 2];
+        dst = l == L - 1 ? "output" : buf[(l + 1) % 2];
+        act = l == L - 1 ? net->output_activation : net->activation;
+        fprintf(file, "\n    /* layer %d: %d -> %d */\n", l, nl, nu);
+        if (!nerve__export_unrolled(net, l))
+        {
+            fprintf(file, "    for (u = 0; u < %d; u++) {\n"
+                          "        s = %s_b%d[u];\n"
+                          "        for (j = 0; j < %d; j++)"
+                          " s += %s_w%d[u][j] * %s[j];\n        ",
+                    nu, name, l, nl, name, l, src);
+            sprintf(out, "%s[u]", dst);
+            nerve__export_activate(file, out, act);
+            fprintf(file, "    }\n");
+            continue;
+        }
+        for (u = 0; u < nu; u++)
+        {
+            row = net->layer[l].weight + (size_t)u * (nl + 1);
+            b   = row[nl] * net->layer[l - 1].neuron[nl].output;
+            fprintf(file, "    s = ");
+            nerve__export_float(file, b);
+            for (j = 0; j < nl; j++)
+            {
+                if ((v = row[j]) == 0.0f) continue;   /* pruned */
+                fprintf(file, v < 0.0f ? "\n      - " : "\n      + ");
+                nerve__export_float(file, v < 0.0f ? -v : v);
+                fprintf(file, " * %s[%d]", src, j);
+            }
+            fprintf(file, ";\n    ");
+            sprintf(out, "%s[%d]", dst, u);
+            nerve__export_activate(file, out, act);
+        }
+    }
+
+    if (net->output_activation == NERVENET_ACTIVATION_SOFTMAX)
+        fprintf(file,
+                "\n    m = output[0];\n"
+                "    for (u = 1; u < %d; u++) if (output[u] > m) m = output[u];\n"
+                "    z = 0.0f;\n"
+                "    for (u = 0; u < %d; u++) {\n"
+                "        output[u] = (float)exp((double)(output[u] - m));\n"
+                "        z += output[u];\n"
+                "    }\n"
+                "    for (u = 0; u < %d; u++) output[u] /= z;\n",
+                net->output_layer->no_of_neurons,
+                net->output_layer->no_of_neurons,
+                net->output_layer->no_of_neurons);
+    fprintf(file, "}\n");
+    return ferror(file) ? -1 : 0;
+}
+
 /* ── Forward pass ─────────────────────────────────────────────────────── */
 static void nerve__set_input(network_t *net, const float *in)
 {
@@ -928,24 +2841,195 @@ static void nerve__get_output(const network_t *net, float *out)
         out[n] = net->output_layer->neuron[n].output;
 }
 
+/* Where a pass reads its samples: float rows, or the uint8 / int16 rows of
+ * the _raw calls, which become scale * raw + offset as they are read. Row r
+ * starts r * stride elements in. */
+typedef struct
+{
+    const void  *data;
+    int          type;      /* nervenet_data_t         */
+    size_t       stride;    /* elements between rows   */
+    const float *scale;     /* per feature, or NULL    */
+    const float *offset;    /* per feature, or NULL    */
+} nerve__rows_t;
+
+static nerve__rows_t nerve__float_rows(const float *data, int stride)
+{
+    nerve__rows_t in;
+    in.data   = data;
+    in.type   = NERVENET_DATA_F32;
+    in.stride = (size_t)stride;
+    in.scale  = NULL;
+    in.offset = NULL;
+    return in;
+}
+
+static nerve__rows_t nerve__raw_rows(const nerve_input_t *fmt,
+                                     const void *data, int stride)
+{
+    nerve__rows_t in;
+    assert(fmt->type == NERVENET_DATA_F32 || fmt->type == NERVENET_DATA_U8 ||
+           fmt->type == NERVENET_DATA_I16);
+    in.data   = data;
+    in.type   = (int)fmt->type;
+    in.stride = (size_t)stride;
+    in.scale  = fmt->scale;
+    in.offset = fmt->offset;
+    return in;
+}
+
+/* Gather rows into a feature-major tile: a[j * t + s] is feature j of row
+ * idx[s], or of row first + s when idx is NULL. Without `affine` the values
+ * are only converted, for a first layer that has scale and offset folded
+ * in; with it, float rows and no scale or offset, this is a plain copy. */
+static void nerve__gather_tile(float *a, const nerve__rows_t *in,
+                               const int *idx, size_t first, int t, int n,
+                               int affine)
+{
+    int s, j;
+    size_t r;
+    const unsigned char *u8;
+    const short *i16;
+    const float *f32;
+    for (s = 0; s < t; s++)
+    {
+        r = (idx ? (size_t)idx[s] : first + (size_t)s) * in->stride;
+        switch (in->type)
+        {
+        case NERVENET_DATA_U8:
+            u8 = (const unsigned char *)in->data + r;
+            for (j = 0; j < n; j++) a[(size_t)j * t + s] = (float)u8[j];
+            break;
+        case NERVENET_DATA_I16:
+            i16 = (const short *)in->data + r;
+            for (j = 0; j < n; j++) a[(size_t)j * t + s] = (float)i16[j];
+            break;
+        default:
+            f32 = (const float *)in->data + r;
+            for (j = 0; j < n; j++) a[(size_t)j * t + s] = f32[j];
+            break;
+        }
+    }
+    if (!affine) return;
+    if (in->scale)
+        for (j = 0; j < n; j++)
+            for (s = 0; s < t; s++) a[(size_t)j * t + s] *= in->scale[j];
+    if (in->offset)
+        for (j = 0; j < n; j++)
+            for (s = 0; s < t; s++) a[(size_t)j * t + s] += in->offset[j];
+}
+
+static void nerve__set_input_row(network_t *net, const nerve__rows_t *in,
+                                 size_t r)
+{
+    int j;
+    size_t k = r * in->stride;
+    float x;
+    for (j = 0; j < net->input_layer->no_of_neurons; j++, k++)
+    {
+        x = in->type == NERVENET_DATA_U8
+          ? (float)((const unsigned char *)in->data)[k]
+          : in->type == NERVENET_DATA_I16
+          ? (float)((const short *)in->data)[k]
+          : ((const float *)in->data)[k];
+        if (in->scale)  x *= in->scale[j];
+        if (in->offset) x += in->offset[j];
+        net->input_layer->neuron[j].output = x;
+    }
+}
+
+/* ── Dropout ──────────────────────────────────────────────────────────────
+ * A unit survives when an 8-bit uniform draw is at or above the threshold
+ * round(256 * rate), so the rate resolves to 1/256. The draws are bit-sliced:
+ * one 32-bit word supplies the next bit, most significant first, to each of
+ * 32 units, and the comparison stops as soon as every unit is decided or the
+ * threshold has no set bits left — at most eight words per 32 units, one at
+ * p = 0.5. Survivors are scaled by 256 / (256 - threshold) — inverted
+ * dropout — so their expected value is the undropped activation and
+ * inference runs the plain network with no rescale.
+ *
+ * Dropped units are skipped outright, found by their mask bit: the
+ * per-sample path (the fallback of net_train_epoch) draws a mask per layer
+ * per sample, the tile trainer one per layer per tile, shared by its
+ * samples, so its GEMMs run over the surviving rows only.
+ */
+static int nerve__drop_threshold(float rate)
+{
+    int thr = (int)(rate * 256.0f + 0.5f);
+    if (rate <= 0.0f) return 0;
+    return thr < 1 ? 1 : thr > 255 ? 255 : thr;
+}
+
+#define NERVE__DROP_KEEP(thr)  ((float)(256 - (thr)) * (1.0f / 256.0f))
+#define NERVE__BIT(mask, j)   (((mask)[(j) >> 5] >> ((j) & 31)) & 1UL)
+#define NERVE__MASK_WORDS(n)  (((n) + 31) / 32)
+
+/* Bit j of `mask` is set when unit j of n survives. Returns the number of
+ * 32-bit draws taken. */
+static int nerve__drop_mask(unsigned long *mask, int n, int thr,
+                            nerve_rng_t *rng)
+{
+    int i, b, draws = 0;
+    unsigned long keep, tie, r;
+    for (i = 0; i < NERVE__MASK_WORDS(n); i++)
+    {
+        /* tie: lanes whose draw so far equals the threshold's prefix */
+        keep = 0UL;
+        tie  = 0xFFFFFFFFUL;
+        for (b = 7; b >= 0 && tie; b--)
+        {
+            if ((thr & ((2 << b) - 1)) == 0) break;    /* rest is >= thr */
+            r = nerve_rng_u32(rng);
+            draws++;
+            if ((thr >> b) & 1) tie &= r;
+            else { keep |= tie & r; tie &= ~r; }
+        }
+        mask[i] = keep | tie;
+    }
+    if (n & 31) mask[n >> 5] &= (1UL << (n & 31)) - 1UL;
+    return draws;
+}
+
+/* With thr set, draw upper's mask into `keep` first and leave dropped
+ * units at zero without a dot product. */
 static void nerve__propagate(layer_t *lower, layer_t *upper, int act,
-                             float dropout)
+                             int thr, unsigned long *keep, nerve_rng_t *rng)
 {
-    int nu, nl;
-    float v;
-    for (nu = 0; nu < upper->no_of_neurons; nu++)
+    int nu, nl, stride = lower->no_of_neurons + 1;
+    const float *w = upper->weight;
+    float v, scale = thr ? 1.0f / NERVE__DROP_KEEP(thr) : 1.0f;
+    if (thr) nerve__drop_mask(keep, upper->no_of_neurons, thr, rng);
+    for (nu = 0; nu < upper->no_of_neurons; nu++, w += stride)
     {
-        /* Dropout: randomly silence hidden neurons during training */
-        if (dropout > 0.0f && nerve_rand_float() < dropout)
+        if (thr && !NERVE__BIT(keep, nu))
         {
             upper->neuron[nu].output = 0.0f;
             continue;
         }
         v = 0.0f;
-        for (nl = 0; nl <= lower->no_of_neurons; nl++)
-            v += upper->neuron[nu].weight[nl] * lower->neuron[nl].output;
-        upper->neuron[nu].output = nerve__activate(v, act);
+        for (nl = 0; nl < stride; nl++)
+            v += w[nl] * lower->neuron[nl].output;
+        upper->neuron[nu].output = scale * nerve__activate(v, act);
+    }
+}
+
+/* Turn a layer of logits into softmax outputs: exp/normalise with
+ * max-subtraction for numerical stability. */
+static void nerve__softmax_layer(layer_t *out)
+{
+    int nu;
+    float v, maxv, sum = 0.0f;
+    maxv = out->neuron[0].output;
+    for (nu = 1; nu < out->no_of_neurons; nu++)
+        if (out->neuron[nu].output > maxv) maxv = out->neuron[nu].output;
+    for (nu = 0; nu < out->no_of_neurons; nu++)
+    {
+        v = nerve__exp(out->neuron[nu].output - maxv);
+        out->neuron[nu].output = v;
+        sum += v;
     }
+    for (nu = 0; nu < out->no_of_neurons; nu++)
+        out->neuron[nu].output /= sum;
 }
 
 /* Output layer forward pass. For softmax the whole layer is normalised
@@ -955,378 +3039,3639 @@ static void nerve__forward_output(network_t *net)
 {
     layer_t *lower = &net->layer[net->no_of_layers - 2];
     layer_t *out   = net->output_layer;
-    int nu, nl;
+    int nu, nl, stride = lower->no_of_neurons + 1;
+    const float *w = out->weight;
     float v;
 
     if (net->output_activation != NERVENET_ACTIVATION_SOFTMAX)
     {
-        nerve__propagate(lower, out, net->output_activation, 0.0f);
+        nerve__propagate(lower, out, net->output_activation, 0, NULL, NULL);
         return;
     }
 
-    /* Softmax: raw logits, then exp/normalise with max-subtraction for
-     * numerical stability. */
+    /* Softmax: raw logits, then normalise. */
+    for (nu = 0; nu < out->no_of_neurons; nu++, w += stride)
     {
-        float maxv, sum = 0.0f;
-        for (nu = 0; nu < out->no_of_neurons; nu++)
-        {
-            v = 0.0f;
-            for (nl = 0; nl <= lower->no_of_neurons; nl++)
-                v += out->neuron[nu].weight[nl] * lower->neuron[nl].output;
-            out->neuron[nu].output = v;
-        }
-        maxv = out->neuron[0].output;
-        for (nu = 1; nu < out->no_of_neurons; nu++)
-            if (out->neuron[nu].output > maxv) maxv = out->neuron[nu].output;
-        for (nu = 0; nu < out->no_of_neurons; nu++)
-        {
-            v = (float)exp((double)(out->neuron[nu].output - maxv));
-            out->neuron[nu].output = v;
-            sum += v;
-        }
-        for (nu = 0; nu < out->no_of_neurons; nu++)
-            out->neuron[nu].output /= sum;
+        v = 0.0f;
+        for (nl = 0; nl < stride; nl++)
+            v += w[nl] * lower->neuron[nl].output;
+        out->neuron[nu].output = v;
     }
+    nerve__softmax_layer(out);
 }
 
-static void nerve__forward(network_t *net, int training)
+/* Words for every hidden layer's dropout mask, layer after layer. */
+static int nerve__hidden_mask_words(const network_t *net)
 {
-    int l;
-    float drop = training ? net->dropout_rate : 0.0f;
+    int l, words = 0;
     for (l = 1; l < net->no_of_layers - 1; l++)
+        words += NERVE__MASK_WORDS(net->layer[l].no_of_neurons);
+    return words;
+}
+
+/* A training pass passes the stream its dropout draws from and room for
+ * nerve__hidden_mask_words masks; inference passes NULL and drops nothing. */
+static void nerve__forward(network_t *net, nerve_rng_t *rng,
+                           unsigned long *keep)
+{
+    int l, thr = rng ? nerve__drop_threshold(net->dropout_rate) : 0;
+    NERVE__PROF_VARS(st, net->stats)
+    for (l = 1; l < net->no_of_layers - 1; l++)
+    {
+        NERVE__PROF_START(st);
         nerve__propagate(&net->layer[l - 1], &net->layer[l],
-                         net->activation, drop);
+                         net->activation, thr, keep, rng);
+        if (thr) keep += NERVE__MASK_WORDS(net->layer[l].no_of_neurons);
+        NERVE__PROF_STOP(st, layer[l].forward, 2.0 * nerve__prof_macs(net, l),
+                         nerve__prof_bytes(net, l, 1));
+    }
     if (net->no_of_layers > 1)
+    {
+        NERVE__PROF_START(st);
         nerve__forward_output(net);
+        NERVE__PROF_STOP(st, layer[l].forward, 2.0 * nerve__prof_macs(net, l),
+                         nerve__prof_bytes(net, l, 1));
+    }
 }
 
 void net_compute(network_t *net, const float *input, float *output)
 {
     assert(net && input);
     nerve__set_input(net, input);
-    nerve__forward(net, 0);
+    nerve__forward(net, NULL, NULL);
     if (output) nerve__get_output(net, output);
 }
 
-/* ── Error & backward ─────────────────────────────────────────────────── */
-float net_compute_output_error(network_t *net, const float *target)
+/* First layer from a sparse input: each row gathers its nnz columns and the
+ * bias, where the dense path would walk the whole row. */
+static void nerve__propagate_sparse(const layer_t *in, layer_t *upper, int act,
+                                    const int *idx, const float *val, int nnz)
 {
-    int n;
-    float y, e, t;
-    assert(net && target);
-    net->global_error = 0.0f;
+    int nu, k, stride = in->no_of_neurons + 1;
+    const float *w = upper->weight;
+    float v, bias = in->neuron[in->no_of_neurons].output;
+    for (nu = 0; nu < upper->no_of_neurons; nu++, w += stride)
+    {
+        v = w[stride - 1] * bias;
+        if (val)
+            for (k = 0; k < nnz; k++) v += w[idx[k]] * val[k];
+        else
+            for (k = 0; k < nnz; k++) v += w[idx[k]];
+        upper->neuron[nu].output =
+            act == NERVENET_ACTIVATION_SOFTMAX ? v : nerve__activate(v, act);
+    }
+    if (act == NERVENET_ACTIVATION_SOFTMAX) nerve__softmax_layer(upper);
+}
 
-    if (net->loss == NERVENET_LOSS_CROSS_ENTROPY)
+void net_compute_sparse(network_t *net, const int *idx, const float *val,
+                        int nnz, float *output)
+{
+    int l, L;
+    assert(net && net->no_of_layers >= 2 && nnz >= 0 && (idx || nnz == 0));
+#ifndef NDEBUG
+    for (l = 0; l < nnz; l++)
+        assert(0 <= idx[l] && idx[l] < net->input_layer->no_of_neurons);
+#endif
+    L = net->no_of_layers;
+    nerve__propagate_sparse(net->input_layer, &net->layer[1],
+                            L == 2 ? net->output_activation : net->activation,
+                            idx, val, nnz);
+    for (l = 2; l < L - 1; l++)
+        nerve__propagate(&net->layer[l - 1], &net->layer[l],
+                         net->activation, 0, NULL, NULL);
+    if (L > 2) nerve__forward_output(net);
+    if (output) nerve__get_output(net, output);
+}
+
+/* ── SIMD kernels ─────────────────────────────────────────────────────────
+ * The hot loops of the batched passes reduce to five kernels:
+ *
+ *     axpy    y += a * x                  backward  E_{l-1} += w * E_l
+ *     axpy4   four axpys sharing one x    forward   C = W . A, four rows
+ *     dot     a . b                       gradient  G += E . A^T
+ *     sgd     d *= scale, w += d          update
+ *     adam    fused Adam / AdamW          update
+ *
+ * plus `widen`, fp16 or bf16 to float, for the half-precision inference.
+ * The portable C versions below are the reference, and the only ones built by
+ * default. Define NERVENET_SIMD before including the implementation to also
+ * build SSE2, AVX2/FMA and AVX-512 versions (GCC or Clang on x86). The widest
+ * set the CPU supports is picked the first time a kernel is needed; CPUID is
+ * asked through __builtin_cpu_supports, which also checks that the OS saves
+ * the wide registers. net_simd_set_level caps the choice and
+ * net_simd_self_check compares the active set against the reference.
+ *
+ * The SSE2 set only widens the portable loops, so it gives the same bits.
+ * AVX2 and AVX-512 fuse multiply-adds, and AVX-512 sums sixteen lanes instead
+ * of eight, so results agree to rounding rather than bit for bit.
+ */
+typedef struct
+{
+    float scale, l2, b1, b2, lr_t, eps_t, decay;
+} nerve__adam_args_t;
+
+typedef struct
+{
+    int   level;
+    void  (*widen)(float *dst, const unsigned short *src, int n, int format);
+    void  (*axpy)(float *y, float a, const float *x, int n);
+    void  (*axpy4)(float *c, size_t ldc, const float *w, const float *x, int n);
+    float (*dot)(const float *a, const float *b, int n);
+    void  (*sgd)(float *w, float *d, int n, float scale);
+    void  (*adam)(float *w, float *d, float *m, float *v, int n,
+                  const nerve__adam_args_t *p);
+} nerve__kernels_t;
+
+/* Round to nearest, ties to even, through subnormals; overflow saturates to
+ * infinity and NaN stays NaN. */
+static unsigned short nerve__f32_to_f16(float f)
+{
+    nerve__float_bits_t b;
+    unsigned int sign, m, h, rem, half;
+    int e;
+    b.f  = f;
+    sign = (b.u >> 16) & 0x8000u;
+    e    = (int)((b.u >> 23) & 0xFFu);
+    m    = b.u & 0x7FFFFFu;
+    if (e == 0xFF) return (unsigned short)(sign | 0x7C00u | (m ? 0x200u : 0u));
+    e -= 127 - 15;
+    if (e >= 0x1F) return (unsigned short)(sign | 0x7C00u);
+    if (e <= 0)
     {
-        /* Cross-entropy. With a softmax (or sigmoid) output the gradient of
-         * the loss w.r.t. each logit collapses to the clean term (t - y),
-         * so the rest of the backward pass is unchanged. */
-        for (n = 0; n < net->output_layer->no_of_neurons; n++)
-        {
-            y = net->output_layer->neuron[n].output;
-            t = target[n];
-            net->output_layer->neuron[n].error = t - y;
-            if (t > 0.0f)
-                net->global_error -=
-                    t * (float)log((double)(y > 1e-12f ? y : 1e-12f));
-        }
-        return net->global_error;
+        if (e < -10) return (unsigned short)sign;
+        m   |= 0x800000u;
+        h    = m >> (14 - e);
+        rem  = m & ((1u << (14 - e)) - 1u);
+        half = 1u << (13 - e);
+    }
+    else
+    {
+        h    = ((unsigned int)e << 10) | (m >> 13);
+        rem  = m & 0x1FFFu;
+        half = 0x1000u;
     }
+    /* A carry out of the mantissa bumps the exponent, which is exactly right
+     * — up to and including rounding the largest finite value to infinity. */
+    if (rem > half || (rem == half && (h & 1u))) h++;
+    return (unsigned short)(sign | h);
+}
 
-    /* Mean squared error. The output-layer delta carries the activation
-     * derivative; for the default sigmoid output this is exactly y*(1-y)*e. */
-    for (n = 0; n < net->output_layer->no_of_neurons; n++)
+static float nerve__f16_to_f32(unsigned short h)
+{
+    nerve__float_bits_t b;
+    unsigned int sign = ((unsigned int)h & 0x8000u) << 16;
+    unsigned int e = ((unsigned int)h >> 10) & 0x1Fu, m = (unsigned int)h & 0x3FFu;
+    if (e == 0)
     {
-        y = net->output_layer->neuron[n].output;
-        e = target[n] - y;
-        net->output_layer->neuron[n].error =
-            nerve__activate_deriv(y, net->output_activation) * e;
-        net->global_error += e * e;
+        b.f = (float)m * (1.0f / 16777216.0f);          /* m * 2^-24 */
+        b.u |= sign;
+        return b.f;
     }
-    net->global_error *= 0.5f;
-    return net->global_error;
+    b.u = sign | (e == 0x1F ? 0x7F800000u : (e + 127 - 15) << 23) | (m << 13);
+    return b.f;
 }
 
-float net_get_output_error(const network_t *net)
-{ assert(net); return net->global_error; }
+/* bfloat16 is a float's top half: round the bottom half away, ties to even,
+ * keeping NaNs quiet rather than letting the rounding turn them into inf. */
+static unsigned short nerve__f32_to_bf16(float f)
+{
+    nerve__float_bits_t b;
+    b.f = f;
+    if ((b.u & 0x7F800000u) == 0x7F800000u && (b.u & 0x7FFFFFu))
+        return (unsigned short)((b.u >> 16) | 0x40u);
+    return (unsigned short)((b.u + 0x7FFFu + ((b.u >> 16) & 1u)) >> 16);
+}
 
-static void nerve__backprop_layer(layer_t *lower, layer_t *upper, int act)
+static float nerve__bf16_to_f32(unsigned short h)
 {
-    int nl, nu;
-    float e, y;
-    for (nl = 0; nl <= lower->no_of_neurons; nl++)
+    nerve__float_bits_t b;
+    b.u = (unsigned int)h << 16;
+    return b.f;
+}
+
+static void nerve__widen_c(float *dst, const unsigned short *src, int n,
+                           int format)
+{
+    int i;
+    if (format == NERVENET_HALF_BF16)
+        for (i = 0; i < n; i++) dst[i] = nerve__bf16_to_f32(src[i]);
+    else
+        for (i = 0; i < n; i++) dst[i] = nerve__f16_to_f32(src[i]);
+}
+
+static void nerve__axpy_c(float *y, float a, const float *x, int n)
+{
+    int i;
+    for (i = 0; i < n; i++) y[i] += a * x[i];
+}
+
+/* Rows c, c + ldc, c + 2 ldc, c + 3 ldc gain w[0..3] times x. */
+static void nerve__axpy4_c(float *c, size_t ldc, const float *w,
+                           const float *x, int n)
+{
+    int s;
+    float w0 = w[0], w1 = w[1], w2 = w[2], w3 = w[3];
+    float *c0 = c, *c1 = c + ldc, *c2 = c1 + ldc, *c3 = c2 + ldc;
+    for (s = 0; s < n; s++)
     {
-        e = 0.0f;
-        for (nu = 0; nu < upper->no_of_neurons; nu++)
-            e += upper->neuron[nu].weight[nl] * upper->neuron[nu].error;
-        y = lower->neuron[nl].output;
-        lower->neuron[nl].error = nerve__activate_deriv(y, act) * e;
+        c0[s] += w0 * x[s];
+        c1[s] += w1 * x[s];
+        c2[s] += w2 * x[s];
+        c3[s] += w3 * x[s];
     }
 }
 
-static void nerve__backward(network_t *net)
+/* Dot product with eight independent lanes, summed in a fixed order: the
+ * shape the compiler can vectorise without -ffast-math. */
+static float nerve__dot_c(const float *a, const float *b, int n)
 {
-    int l;
-    for (l = net->no_of_layers - 1; l > 1; l--)
-        nerve__backprop_layer(&net->layer[l - 1], &net->layer[l],
-                              net->activation);
+    float acc[8];
+    int j, k;
+    for (k = 0; k < 8; k++) acc[k] = 0.0f;
+    for (j = 0; j + 8 <= n; j += 8)
+        for (k = 0; k < 8; k++) acc[k] += a[j + k] * b[j + k];
+    for (k = 0; j < n; j++, k++) acc[k] += a[j] * b[j];
+    return ((acc[0] + acc[1]) + (acc[2] + acc[3])) +
+           ((acc[4] + acc[5]) + (acc[6] + acc[7]));
 }
 
-/* ── Weight update ────────────────────────────────────────────────────── */
-static void nerve__adjust(network_t *net)
+static void nerve__sgd_c(float *w, float *d, int n, float scale)
 {
-    int l, nu, nl, idx, adam = (net->optimizer == NERVENET_OPTIMIZER_ADAM);
-    float lr = net->learning_rate, grad, delta;
-    float b1 = 0, b2 = 0, eps = 0, bc1 = 0, bc2 = 0, mh, vh;
+    int i;
+    for (i = 0; i < n; i++)
+    {
+        d[i] *= scale;
+        w[i] += d[i];
+    }
+}
 
-    if (adam)
+static void nerve__adam_c(float *w, float *d, float *m, float *v, int n,
+                          const nerve__adam_args_t *p)
+{
+    int i;
+    float g, step;
+    for (i = 0; i < n; i++)
     {
-        net->adam_t++;
-        b1  = net->adam_beta1;  b2  = net->adam_beta2;
-        eps = net->adam_epsilon;
-        bc1 = 1.0f - (float)pow((double)b1, (double)net->adam_t);
-        bc2 = 1.0f - (float)pow((double)b2, (double)net->adam_t);
+        g    = d[i] * p->scale - p->l2 * w[i];
+        m[i] = p->b1 * m[i] + (1.0f - p->b1) * g;
+        v[i] = p->b2 * v[i] + (1.0f - p->b2) * g * g;
+        step = p->lr_t * m[i] / ((float)sqrt((double)v[i]) + p->eps_t)
+             - p->decay * w[i];
+        w[i] += step;
+        d[i]  = step;
     }
+}
 
-    for (l = 1; l < net->no_of_layers; l++)
-        for (nu = 0; nu < net->layer[l].no_of_neurons; nu++)
-        {
-            float err = net->layer[l].neuron[nu].error;
-            /* Skip dropped neurons (output is 0 and error is 0) */
-            if (net->dropout_rate > 0.0f && err == 0.0f &&
-                net->layer[l].neuron[nu].output == 0.0f) continue;
+static const nerve__kernels_t nerve__kernels_c = {
+    NERVENET_SIMD_SCALAR, nerve__widen_c, nerve__axpy_c, nerve__axpy4_c, nerve__dot_c,
+    nerve__sgd_c, nerve__adam_c
+};
 
-            for (nl = 0; nl <= net->layer[l - 1].no_of_neurons; nl++)
-            {
-                grad = err * net->layer[l - 1].neuron[nl].output;
-                if (net->l2_lambda > 0.0f)
-                    grad -= net->l2_lambda *
-                            net->layer[l].neuron[nu].weight[nl];
+#if defined(NERVENET_SIMD) && (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define NERVE__X86_SIMD 1
+#include <immintrin.h>
 
-                if (adam)
-                {
-                    idx = nerve__adam_offset(net, l, nu, nl);
-                    net->adam_m[idx] = b1 * net->adam_m[idx] + (1.0f - b1) * grad;
-                    net->adam_v[idx] = b2 * net->adam_v[idx] + (1.0f - b2) * grad * grad;
-                    mh = net->adam_m[idx] / bc1;
-                    vh = net->adam_v[idx] / bc2;
-                    delta = lr * mh / ((float)sqrt((double)vh) + eps);
-                }
-                else
-                {
-                    delta = lr * grad +
-                            net->momentum * net->layer[l].neuron[nu].delta[nl];
-                }
-                net->layer[l].neuron[nu].weight[nl] += delta;
-                net->layer[l].neuron[nu].delta[nl]   = delta;
-            }
+#define NERVE__SSE2   __attribute__((target("sse2")))
+#define NERVE__AVX2   __attribute__((target("avx2,fma")))
+#define NERVE__AVX512 __attribute__((target("avx512f")))
+#define NERVE__F16C   __attribute__((target("avx2,f16c")))
+#include <cpuid.h>
+
+/* F16C (the vcvtph2ps conversion) shipped alongside AVX2 on every x86 core
+ * so far, but it is a separate CPUID bit: ask for it rather than assume. */
+static int nerve__has_f16c(void)
+{
+    unsigned int a, b, c, d;
+    return __get_cpuid(1, &a, &b, &c, &d) && (c & bit_F16C) != 0;
+}
+
+/* SSE2 ─ four lanes, multiply then add, exactly the portable arithmetic. */
+NERVE__SSE2 static void nerve__axpy_sse2(float *y, float a, const float *x,
+                                         int n)
+{
+    int i;
+    __m128 va = _mm_set1_ps(a);
+    for (i = 0; i + 4 <= n; i += 4)
+        _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i),
+                                        _mm_mul_ps(va, _mm_loadu_ps(x + i))));
+    for (; i < n; i++) y[i] += a * x[i];
+}
+
+NERVE__SSE2 static void nerve__axpy4_sse2(float *c, size_t ldc,
+                                          const float *w, const float *x, int n)
+{
+    int k;
+    for (k = 0; k < 4; k++) nerve__axpy_sse2(c + k * ldc, w[k], x, n);
+}
+
+NERVE__SSE2 static float nerve__dot_sse2(const float *a, const float *b, int n)
+{
+    float acc[8];
+    int j, k;
+    __m128 lo = _mm_setzero_ps(), hi = _mm_setzero_ps();
+    for (j = 0; j + 8 <= n; j += 8)
+    {
+        lo = _mm_add_ps(lo, _mm_mul_ps(_mm_loadu_ps(a + j),
+                                       _mm_loadu_ps(b + j)));
+        hi = _mm_add_ps(hi, _mm_mul_ps(_mm_loadu_ps(a + j + 4),
+                                       _mm_loadu_ps(b + j + 4)));
+    }
+    _mm_storeu_ps(acc, lo);
+    _mm_storeu_ps(acc + 4, hi);
+    for (k = 0; j < n; j++, k++) acc[k] += a[j] * b[j];
+    return ((acc[0] + acc[1]) + (acc[2] + acc[3])) +
+           ((acc[4] + acc[5]) + (acc[6] + acc[7]));
+}
+
+NERVE__SSE2 static void nerve__sgd_sse2(float *w, float *d, int n, float scale)
+{
+    int i;
+    __m128 vs = _mm_set1_ps(scale), vd;
+    for (i = 0; i + 4 <= n; i += 4)
+    {
+        vd = _mm_mul_ps(_mm_loadu_ps(d + i), vs);
+        _mm_storeu_ps(d + i, vd);
+        _mm_storeu_ps(w + i, _mm_add_ps(_mm_loadu_ps(w + i), vd));
+    }
+    nerve__sgd_c(w + i, d + i, n - i, scale);
+}
+
+NERVE__SSE2 static void nerve__adam_sse2(float *w, float *d, float *m,
+                                         float *v, int n,
+                                         const nerve__adam_args_t *p)
+{
+    int i;
+    __m128 scale = _mm_set1_ps(p->scale), l2 = _mm_set1_ps(p->l2);
+    __m128 b1 = _mm_set1_ps(p->b1), c1 = _mm_set1_ps(1.0f - p->b1);
+    __m128 b2 = _mm_set1_ps(p->b2), c2 = _mm_set1_ps(1.0f - p->b2);
+    __m128 lr = _mm_set1_ps(p->lr_t), eps = _mm_set1_ps(p->eps_t);
+    __m128 decay = _mm_set1_ps(p->decay);
+    __m128 vw, g, vm, vv, step;
+    for (i = 0; i + 4 <= n; i += 4)
+    {
+        vw = _mm_loadu_ps(w + i);
+        g  = _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(d + i), scale),
+                        _mm_mul_ps(l2, vw));
+        vm = _mm_add_ps(_mm_mul_ps(b1, _mm_loadu_ps(m + i)), _mm_mul_ps(c1, g));
+        vv = _mm_add_ps(_mm_mul_ps(b2, _mm_loadu_ps(v + i)),
+                        _mm_mul_ps(_mm_mul_ps(c2, g), g));
+        step = _mm_sub_ps(_mm_div_ps(_mm_mul_ps(lr, vm),
+                                     _mm_add_ps(_mm_sqrt_ps(vv), eps)),
+                          _mm_mul_ps(decay, vw));
+        _mm_storeu_ps(m + i, vm);
+        _mm_storeu_ps(v + i, vv);
+        _mm_storeu_ps(w + i, _mm_add_ps(vw, step));
+        _mm_storeu_ps(d + i, step);
+    }
+    nerve__adam_c(w + i, d + i, m + i, v + i, n - i, p);
+}
+
+static const nerve__kernels_t nerve__kernels_sse2 = {
+    NERVENET_SIMD_SSE2, nerve__widen_c, nerve__axpy_sse2, nerve__axpy4_sse2,
+    nerve__dot_sse2, nerve__sgd_sse2, nerve__adam_sse2
+};
+
+/* AVX2 + FMA ─ eight lanes, fused multiply-adds. */
+NERVE__AVX2 static void nerve__axpy_avx2(float *y, float a, const float *x,
+                                         int n)
+{
+    int i;
+    __m256 va = _mm256_set1_ps(a);
+    for (i = 0; i + 8 <= n; i += 8)
+        _mm256_storeu_ps(y + i, _mm256_fmadd_ps(va, _mm256_loadu_ps(x + i),
+                                                _mm256_loadu_ps(y + i)));
+    for (; i < n; i++) y[i] += a * x[i];
+}
+
+NERVE__AVX2 static void nerve__axpy4_avx2(float *c, size_t ldc,
+                                          const float *w, const float *x, int n)
+{
+    int s;
+    float *c0 = c, *c1 = c + ldc, *c2 = c1 + ldc, *c3 = c2 + ldc;
+    __m256 w0 = _mm256_set1_ps(w[0]), w1 = _mm256_set1_ps(w[1]);
+    __m256 w2 = _mm256_set1_ps(w[2]), w3 = _mm256_set1_ps(w[3]), vx;
+    for (s = 0; s + 8 <= n; s += 8)
+    {
+        vx = _mm256_loadu_ps(x + s);
+        _mm256_storeu_ps(c0 + s, _mm256_fmadd_ps(w0, vx, _mm256_loadu_ps(c0 + s)));
+        _mm256_storeu_ps(c1 + s, _mm256_fmadd_ps(w1, vx, _mm256_loadu_ps(c1 + s)));
+        _mm256_storeu_ps(c2 + s, _mm256_fmadd_ps(w2, vx, _mm256_loadu_ps(c2 + s)));
+        _mm256_storeu_ps(c3 + s, _mm256_fmadd_ps(w3, vx, _mm256_loadu_ps(c3 + s)));
+    }
+    for (; s < n; s++)
+    {
+        c0[s] += w[0] * x[s];
+        c1[s] += w[1] * x[s];
+        c2[s] += w[2] * x[s];
+        c3[s] += w[3] * x[s];
+    }
+}
+
+NERVE__AVX2 static float nerve__dot_avx2(const float *a, const float *b, int n)
+{
+    float acc[8];
+    int j, k;
+    __m256 va = _mm256_setzero_ps();
+    for (j = 0; j + 8 <= n; j += 8)
+        va = _mm256_fmadd_ps(_mm256_loadu_ps(a + j), _mm256_loadu_ps(b + j), va);
+    _mm256_storeu_ps(acc, va);
+    for (k = 0; j < n; j++, k++) acc[k] += a[j] * b[j];
+    return ((acc[0] + acc[1]) + (acc[2] + acc[3])) +
+           ((acc[4] + acc[5]) + (acc[6] + acc[7]));
+}
+
+NERVE__AVX2 static void nerve__sgd_avx2(float *w, float *d, int n, float scale)
+{
+    int i;
+    __m256 vs = _mm256_set1_ps(scale), vd;
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        vd = _mm256_mul_ps(_mm256_loadu_ps(d + i), vs);
+        _mm256_storeu_ps(d + i, vd);
+        _mm256_storeu_ps(w + i, _mm256_add_ps(_mm256_loadu_ps(w + i), vd));
+    }
+    nerve__sgd_c(w + i, d + i, n - i, scale);
+}
+
+NERVE__AVX2 static void nerve__adam_avx2(float *w, float *d, float *m,
+                                         float *v, int n,
+                                         const nerve__adam_args_t *p)
+{
+    int i;
+    __m256 scale = _mm256_set1_ps(p->scale), l2 = _mm256_set1_ps(p->l2);
+    __m256 b1 = _mm256_set1_ps(p->b1), c1 = _mm256_set1_ps(1.0f - p->b1);
+    __m256 b2 = _mm256_set1_ps(p->b2), c2 = _mm256_set1_ps(1.0f - p->b2);
+    __m256 lr = _mm256_set1_ps(p->lr_t), eps = _mm256_set1_ps(p->eps_t);
+    __m256 decay = _mm256_set1_ps(p->decay);
+    __m256 vw, g, vm, vv, step;
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        vw = _mm256_loadu_ps(w + i);
+        g  = _mm256_fnmadd_ps(l2, vw, _mm256_mul_ps(_mm256_loadu_ps(d + i), scale));
+        vm = _mm256_fmadd_ps(b1, _mm256_loadu_ps(m + i), _mm256_mul_ps(c1, g));
+        vv = _mm256_fmadd_ps(b2, _mm256_loadu_ps(v + i),
+                             _mm256_mul_ps(_mm256_mul_ps(c2, g), g));
+        step = _mm256_fnmadd_ps(decay, vw,
+                   _mm256_div_ps(_mm256_mul_ps(lr, vm),
+                                 _mm256_add_ps(_mm256_sqrt_ps(vv), eps)));
+        _mm256_storeu_ps(m + i, vm);
+        _mm256_storeu_ps(v + i, vv);
+        _mm256_storeu_ps(w + i, _mm256_add_ps(vw, step));
+        _mm256_storeu_ps(d + i, step);
+    }
+    nerve__adam_c(w + i, d + i, m + i, v + i, n - i, p);
+}
+
+/* Eight halves at a time: F16C converts fp16 exactly, and bf16 is the top
+ * half of a float, so a zero-extend and a shift rebuild it. */
+NERVE__F16C static void nerve__widen_f16c(float *dst, const unsigned short *src,
+                                          int n, int format)
+{
+    int i = 0;
+    __m128i h;
+    if (format == NERVENET_HALF_BF16)
+        for (; i + 8 <= n; i += 8)
+        {
+            h = _mm_loadu_si128((const __m128i *)(src + i));
+            _mm256_storeu_ps(dst + i, _mm256_castsi256_ps(_mm256_slli_epi32(
+                                          _mm256_cvtepu16_epi32(h), 16)));
+        }
+    else
+        for (; i + 8 <= n; i += 8)
+        {
+            h = _mm_loadu_si128((const __m128i *)(src + i));
+            _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+        }
+    nerve__widen_c(dst + i, src + i, n - i, format);
+}
+
+static const nerve__kernels_t nerve__kernels_avx2 = {
+    NERVENET_SIMD_AVX2, nerve__widen_f16c, nerve__axpy_avx2, nerve__axpy4_avx2, nerve__dot_avx2,
+    nerve__sgd_avx2, nerve__adam_avx2
+};
+
+/* AVX-512 ─ sixteen lanes; tails go through a lane mask, not a scalar loop. */
+NERVE__AVX512 static void nerve__axpy_avx512(float *y, float a,
+                                             const float *x, int n)
+{
+    int i;
+    __m512 va = _mm512_set1_ps(a);
+    __mmask16 k;
+    for (i = 0; i + 16 <= n; i += 16)
+        _mm512_storeu_ps(y + i, _mm512_fmadd_ps(va, _mm512_loadu_ps(x + i),
+                                                _mm512_loadu_ps(y + i)));
+    if (i < n)
+    {
+        k = (__mmask16)((1u << (n - i)) - 1u);
+        _mm512_mask_storeu_ps(y + i, k,
+            _mm512_fmadd_ps(va, _mm512_maskz_loadu_ps(k, x + i),
+                            _mm512_maskz_loadu_ps(k, y + i)));
+    }
+}
+
+NERVE__AVX512 static void nerve__axpy4_avx512(float *c, size_t ldc,
+                                              const float *w, const float *x,
+                                              int n)
+{
+    int s, r;
+    __m512 vw[4], vx;
+    __mmask16 k;
+    for (r = 0; r < 4; r++) vw[r] = _mm512_set1_ps(w[r]);
+    for (s = 0; s + 16 <= n; s += 16)
+    {
+        vx = _mm512_loadu_ps(x + s);
+        for (r = 0; r < 4; r++)
+            _mm512_storeu_ps(c + r * ldc + s,
+                _mm512_fmadd_ps(vw[r], vx, _mm512_loadu_ps(c + r * ldc + s)));
+    }
+    if (s < n)
+    {
+        k  = (__mmask16)((1u << (n - s)) - 1u);
+        vx = _mm512_maskz_loadu_ps(k, x + s);
+        for (r = 0; r < 4; r++)
+            _mm512_mask_storeu_ps(c + r * ldc + s, k,
+                _mm512_fmadd_ps(vw[r], vx,
+                                _mm512_maskz_loadu_ps(k, c + r * ldc + s)));
+    }
+}
+
+NERVE__AVX512 static float nerve__dot_avx512(const float *a, const float *b,
+                                             int n)
+{
+    int j;
+    __m512 acc = _mm512_setzero_ps();
+    __mmask16 k;
+    for (j = 0; j + 16 <= n; j += 16)
+        acc = _mm512_fmadd_ps(_mm512_loadu_ps(a + j), _mm512_loadu_ps(b + j),
+                              acc);
+    if (j < n)
+    {
+        k   = (__mmask16)((1u << (n - j)) - 1u);
+        acc = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(k, a + j),
+                              _mm512_maskz_loadu_ps(k, b + j), acc);
+    }
+    return _mm512_reduce_add_ps(acc);
+}
+
+NERVE__AVX512 static void nerve__sgd_avx512(float *w, float *d, int n,
+                                            float scale)
+{
+    int i;
+    __m512 vs = _mm512_set1_ps(scale), vd;
+    for (i = 0; i + 16 <= n; i += 16)
+    {
+        vd = _mm512_mul_ps(_mm512_loadu_ps(d + i), vs);
+        _mm512_storeu_ps(d + i, vd);
+        _mm512_storeu_ps(w + i, _mm512_add_ps(_mm512_loadu_ps(w + i), vd));
+    }
+    nerve__sgd_c(w + i, d + i, n - i, scale);
+}
+
+NERVE__AVX512 static void nerve__adam_avx512(float *w, float *d, float *m,
+                                             float *v, int n,
+                                             const nerve__adam_args_t *p)
+{
+    int i;
+    __m512 scale = _mm512_set1_ps(p->scale), l2 = _mm512_set1_ps(p->l2);
+    __m512 b1 = _mm512_set1_ps(p->b1), c1 = _mm512_set1_ps(1.0f - p->b1);
+    __m512 b2 = _mm512_set1_ps(p->b2), c2 = _mm512_set1_ps(1.0f - p->b2);
+    __m512 lr = _mm512_set1_ps(p->lr_t), eps = _mm512_set1_ps(p->eps_t);
+    __m512 decay = _mm512_set1_ps(p->decay);
+    __m512 vw, g, vm, vv, step;
+    for (i = 0; i + 16 <= n; i += 16)
+    {
+        vw = _mm512_loadu_ps(w + i);
+        g  = _mm512_fnmadd_ps(l2, vw, _mm512_mul_ps(_mm512_loadu_ps(d + i), scale));
+        vm = _mm512_fmadd_ps(b1, _mm512_loadu_ps(m + i), _mm512_mul_ps(c1, g));
+        vv = _mm512_fmadd_ps(b2, _mm512_loadu_ps(v + i),
+                             _mm512_mul_ps(_mm512_mul_ps(c2, g), g));
+        step = _mm512_fnmadd_ps(decay, vw,
+                   _mm512_div_ps(_mm512_mul_ps(lr, vm),
+                                 _mm512_add_ps(_mm512_sqrt_ps(vv), eps)));
+        _mm512_storeu_ps(m + i, vm);
+        _mm512_storeu_ps(v + i, vv);
+        _mm512_storeu_ps(w + i, _mm512_add_ps(vw, step));
+        _mm512_storeu_ps(d + i, step);
+    }
+    nerve__adam_c(w + i, d + i, m + i, v + i, n - i, p);
+}
+
+static const nerve__kernels_t nerve__kernels_avx512 = {
+    NERVENET_SIMD_AVX512, nerve__widen_f16c, nerve__axpy_avx512, nerve__axpy4_avx512,
+    nerve__dot_avx512, nerve__sgd_avx512, nerve__adam_avx512
+};
+#endif /* NERVE__X86_SIMD */
+
+static const nerve__kernels_t *nerve__kern = NULL;
+static int nerve__simd_cap = NERVENET_SIMD_AVX512;
+
+static const nerve__kernels_t *nerve__kernels_for(int cap)
+{
+#if defined(NERVE__X86_SIMD)
+    __builtin_cpu_init();
+    if (cap >= NERVENET_SIMD_AVX512 && __builtin_cpu_supports("avx512f") &&
+        nerve__has_f16c())
+        return &nerve__kernels_avx512;
+    if (cap >= NERVENET_SIMD_AVX2 && __builtin_cpu_supports("avx2") &&
+        __builtin_cpu_supports("fma") && nerve__has_f16c())
+        return &nerve__kernels_avx2;
+    if (cap >= NERVENET_SIMD_SSE2 && __builtin_cpu_supports("sse2"))
+        return &nerve__kernels_sse2;
+#else
+    (void)cap;
+#endif
+    return &nerve__kernels_c;
+}
+
+static void nerve__kernels_init(void)
+{
+    if (!nerve__kern) nerve__kern = nerve__kernels_for(nerve__simd_cap);
+}
+
+/* The table is picked once, under pthread_once where there are threads, so
+ * net_compute_ctx callers on fresh networks see it published rather than
+ * racing to store it. net_simd_set_level replaces it outright and must not
+ * run while other threads compute. */
+static const nerve__kernels_t *nerve__kernels(void)
+{
+#if defined(NERVE__THREADS)
+    static pthread_once_t once = PTHREAD_ONCE_INIT;
+    pthread_once(&once, nerve__kernels_init);
+#else
+    nerve__kernels_init();
+#endif
+    return nerve__kern;
+}
+
+nervenet_simd_t net_simd_level(void)
+{
+    return (nervenet_simd_t)nerve__kernels()->level;
+}
+
+nervenet_simd_t net_simd_set_level(nervenet_simd_t cap)
+{
+    nerve__simd_cap = (int)cap;
+    nerve__kern     = nerve__kernels_for(nerve__simd_cap);
+    return (nervenet_simd_t)nerve__kern->level;
+}
+
+/* Run every active kernel against the portable reference on awkward lengths
+ * (empty, sub-vector, odd tails) and random data from a private stream, so
+ * the global generator is left alone. */
+int net_simd_self_check(void)
+{
+    enum { MAXN = 67 };
+    const nerve__kernels_t *k = nerve__kernels(), *r = &nerve__kernels_c;
+    float x[MAXN], y[4 * MAXN], yr[4 * MAXN], w[4];
+    float pw[4][MAXN], pr[4][MAXN];
+    unsigned short hx[MAXN];
+    float a, b, tol;
+    unsigned long s[4];
+    nerve__adam_args_t args;
+    int n, i, j, ok = 1;
+
+    nerve__rng_seed_state(s, 0x51D0CA7UL);
+#define NERVE__RND() (2.0f * NERVE__U32_TO_FLOAT(nerve__rng_next(s)) - 1.0f)
+#define NERVE__NEAR(p, q) \
+    ((float)fabs((double)((p) - (q))) <= tol * (1.0f + (float)fabs((double)(q))))
+    tol = 1e-5f;
+    args.scale = 0.25f; args.l2 = 1e-3f; args.b1 = 0.9f; args.b2 = 0.999f;
+    args.lr_t = 0.01f; args.eps_t = 1e-8f; args.decay = 1e-4f;
+
+    for (n = 0; n <= MAXN; n++)
+    {
+        for (i = 0; i < n; i++) x[i] = NERVE__RND();
+        for (i = 0; i < 4 * n; i++) y[i] = yr[i] = NERVE__RND();
+        for (i = 0; i < 4; i++) w[i] = NERVE__RND();
+
+        a = k->dot(x, y, n);
+        b = r->dot(x, y, n);
+        if (!NERVE__NEAR(a, b)) ok = 0;
+
+        /* Widening is exact in every implementation. */
+        for (j = NERVENET_HALF_FP16; j <= NERVENET_HALF_BF16; j++)
+        {
+            for (i = 0; i < n; i++)
+                hx[i] = j == NERVENET_HALF_BF16 ? nerve__f32_to_bf16(x[i])
+                                                : nerve__f32_to_f16(x[i]);
+            k->widen(y, hx, n, j);
+            r->widen(yr, hx, n, j);
+            for (i = 0; i < n; i++) if (y[i] != yr[i]) ok = 0;
+        }
+
+        k->axpy(y, w[0], x, n);
+        r->axpy(yr, w[0], x, n);
+        k->axpy4(y, (size_t)n, w, x, n);
+        r->axpy4(yr, (size_t)n, w, x, n);
+        for (i = 0; i < 4 * n; i++)
+            if (!NERVE__NEAR(y[i], yr[i])) ok = 0;
+
+        for (j = 0; j < 4; j++)
+            for (i = 0; i < n; i++)
+                pw[j][i] = pr[j][i] = j == 3 ? (float)fabs((double)NERVE__RND())
+                                             : NERVE__RND();
+        k->sgd(pw[0], pw[1], n, args.scale);
+        r->sgd(pr[0], pr[1], n, args.scale);
+        k->adam(pw[0], pw[1], pw[2], pw[3], n, &args);
+        r->adam(pr[0], pr[1], pr[2], pr[3], n, &args);
+        for (j = 0; j < 4; j++)
+            for (i = 0; i < n; i++)
+                if (!NERVE__NEAR(pw[j][i], pr[j][i])) ok = 0;
+    }
+#undef NERVE__RND
+#undef NERVE__NEAR
+    return ok;
+}
+
+/* ── Batched forward pass ─────────────────────────────────────────────────
+ * Activations for a tile of samples are held feature-major: A[j * tile + s]
+ * is feature j of sample s, with the bias as one extra feature row. One layer
+ * is then C = W . A — (n_upper, n_lower+1) times (n_lower+1, tile) — and the
+ * innermost loop runs across samples:
+ *
+ *     for each weight row u, for each feature j:  C[u][s] += W[u][j] * A[j][s]
+ *
+ * Every lane of that loop is an independent accumulator, so it vectorises
+ * without -ffast-math, and each C[u][s] still sums its terms in feature
+ * order — the same order as nerve__propagate, hence the same result. Four
+ * weight rows are processed together so every A[j] row loaded from cache
+ * feeds four accumulators.
+ */
+#define NERVE__MR 4
+
+static void nerve__activate_rows(float *x, int n, int type)
+{
+    int i;
+    switch (type)
+    {
+    case NERVENET_ACTIVATION_TANH:
+        for (i = 0; i < n; i++) x[i] = nerve__tanh(x[i]);
+        break;
+    case NERVENET_ACTIVATION_RELU:
+        for (i = 0; i < n; i++) x[i] = x[i] > 0.0f ? x[i] : 0.0f;
+        break;
+    case NERVENET_ACTIVATION_LEAKY_RELU:
+        for (i = 0; i < n; i++) x[i] = x[i] > 0.0f ? x[i] : 0.01f * x[i];
+        break;
+    default:
+        for (i = 0; i < n; i++) x[i] = nerve__sigma(x[i]);
+        break;
+    }
+}
+
+/* C (n_upper, t) = W (n_upper, n_lower + 1) . A (n_lower + 1, t) */
+static void nerve__gemm_layer(float *c, const float *w, const float *a,
+                              int n_upper, int n_lower, int t)
+{
+    int u, j, r, stride = n_lower + 1;
+    float w4[NERVE__MR];
+    const nerve__kernels_t *k = nerve__kernels();
+
+    memset(c, 0, (size_t)n_upper * (size_t)t * sizeof(float));
+    for (u = 0; u + NERVE__MR <= n_upper; u += NERVE__MR)
+        for (j = 0; j < stride; j++)
+        {
+            for (r = 0; r < NERVE__MR; r++)
+                w4[r] = w[(size_t)(u + r) * stride + j];
+            k->axpy4(c + (size_t)u * t, (size_t)t, w4, a + (size_t)j * t, t);
+        }
+    for (r = u; r < n_upper; r++)
+        for (j = 0; j < stride; j++)
+            k->axpy(c + (size_t)r * t, w[(size_t)r * stride + j],
+                    a + (size_t)j * t, t);
+}
+
+/* nerve__gemm_layer over the rows whose bit is set in `keep` only, packed
+ * into the first rows of c; returns how many. Each packed row gets the same
+ * kernel calls, in the same order, as in the full product. */
+static int nerve__gemm_kept(float *c, const float *w, const float *a,
+                            const unsigned long *keep,
+                            int n_upper, int n_lower, int t)
+{
+    int u = 0, j, r, n = 0, stride = n_lower + 1, row[NERVE__MR];
+    float w4[NERVE__MR];
+    const nerve__kernels_t *k = nerve__kernels();
+
+    for (j = 0; j < n_upper; j++) n += (int)NERVE__BIT(keep, j);
+    memset(c, 0, (size_t)n * (size_t)t * sizeof(float));
+    for (n = 0; ; n += NERVE__MR)
+    {
+        for (r = 0; r < NERVE__MR && u < n_upper; u++)
+            if (NERVE__BIT(keep, u)) row[r++] = u;
+        if (r < NERVE__MR) break;
+        for (j = 0; j < stride; j++)
+        {
+            for (r = 0; r < NERVE__MR; r++)
+                w4[r] = w[(size_t)row[r] * stride + j];
+            k->axpy4(c + (size_t)n * t, (size_t)t, w4, a + (size_t)j * t, t);
+        }
+    }
+    for (u = 0; u < r; u++)
+        for (j = 0; j < stride; j++)
+            k->axpy(c + (size_t)(n + u) * t, w[(size_t)row[u] * stride + j],
+                    a + (size_t)j * t, t);
+    return n + r;
+}
+
+/* Spread the n packed rows of c back to the units set in `keep`, last
+ * first so no row is overwritten before it moves, and zero the others. */
+static void nerve__unpack_rows(float *c, const unsigned long *keep,
+                               int n_upper, int n, int t)
+{
+    int u;
+    for (u = n_upper - 1; u >= 0; u--)
+        if (!NERVE__BIT(keep, u))
+            memset(c + (size_t)u * t, 0, (size_t)t * sizeof(float));
+        else if (--n != u)
+            memcpy(c + (size_t)u * t, c + (size_t)n * t,
+                   (size_t)t * sizeof(float));
+}
+
+/* Column-wise softmax over a feature-major (n, t) tile. */
+static void nerve__softmax_cols(float *c, int n, int t)
+{
+    int u, s;
+    float maxv, sum, v;
+    for (s = 0; s < t; s++)
+    {
+        maxv = c[s];
+        for (u = 1; u < n; u++)
+            if (c[(size_t)u * t + s] > maxv) maxv = c[(size_t)u * t + s];
+        sum = 0.0f;
+        for (u = 0; u < n; u++)
+        {
+            v = nerve__exp(c[(size_t)u * t + s] - maxv);
+            c[(size_t)u * t + s] = v;
+            sum += v;
+        }
+        for (u = 0; u < n; u++)
+            c[(size_t)u * t + s] /= sum;
+    }
+}
+
+/* Run a feature-major tile of t samples through every layer. The input
+ * features are in *a; *a and *c are swapped as the layers go, so on return
+ * *a holds the output layer. Both must hold (widest layer + 1) * t floats.
+ * w1, if not NULL, stands in for the first layer's weights, with a bias
+ * input of 1 (see nerve__fold_first). The pass counts into `stats`, which
+ * is NULL where the caller may share the network with other threads. */
+static void nerve__forward_tile(const network_t *net, const float *w1,
+                                float **a, float **c, int t,
+                                nerve_stats_t *stats)
+{
+    int l, s;
+    float *tmp;
+    const layer_t *lower, *upper;
+    NERVE__PROF_VARS(st, stats)
+    NERVE__PROF_VARS(act, stats)
+    (void)stats;
+
+    for (l = 1; l < net->no_of_layers; l++)
+    {
+        NERVE__PROF_START(st);
+        lower = &net->layer[l - 1];
+        upper = &net->layer[l];
+        for (s = 0; s < t; s++)
+            (*a)[(size_t)lower->no_of_neurons * t + s] = l == 1 && w1
+                ? 1.0f : lower->neuron[lower->no_of_neurons].output;
+
+        nerve__gemm_layer(*c, l == 1 && w1 ? w1 : upper->weight, *a,
+                          upper->no_of_neurons, lower->no_of_neurons, t);
+        NERVE__PROF_START(act);
+        if (l < net->no_of_layers - 1)
+            nerve__activate_rows(*c, upper->no_of_neurons * t,
+                                 net->activation);
+        else if (net->output_activation == NERVENET_ACTIVATION_SOFTMAX)
+            nerve__softmax_cols(*c, upper->no_of_neurons, t);
+        else
+            nerve__activate_rows(*c, upper->no_of_neurons * t,
+                                 net->output_activation);
+        NERVE__PROF_STOP(act, activation, (double)upper->no_of_neurons * t,
+                         8.0 * upper->no_of_neurons * t);
+        tmp = *a; *a = *c; *c = tmp;
+        NERVE__PROF_STOP(st, layer[l].forward,
+                         2.0 * nerve__prof_macs(net, l) * t,
+                         nerve__prof_bytes(net, l, t));
+    }
+}
+
+static int nerve__widest_layer(const network_t *net)
+{
+    int l, width = 0;
+    for (l = 0; l < net->no_of_layers; l++)
+        if (net->layer[l].no_of_neurons > width)
+            width = net->layer[l].no_of_neurons;
+    return width;
+}
+
+/* x = scale * raw + offset, folded into a copy of the first layer: column
+ * j is scaled by scale[j], and the bias column absorbs the bias input and
+ * the row's dot with offset, so the tile carries raw values and a bias
+ * input of 1. NULL if there is nothing to fold or no memory for it. */
+static float *nerve__fold_first(const network_t *net, const nerve__rows_t *in)
+{
+    const layer_t *lower = net->input_layer, *upper = &net->layer[1];
+    int nu, j, nl = lower->no_of_neurons, stride = nl + 1;
+    const float *src;
+    float *w, *dst, b;
+
+    if (!in->scale && !in->offset) return NULL;
+    w = (float *)nerve__aligned_alloc((size_t)upper->no_of_neurons *
+                                      (size_t)stride * sizeof(float));
+    if (!w) return NULL;
+    for (nu = 0; nu < upper->no_of_neurons; nu++)
+    {
+        src = upper->weight + (size_t)nu * stride;
+        dst = w + (size_t)nu * stride;
+        b   = src[nl] * lower->neuron[nl].output;
+        for (j = 0; j < nl; j++)
+        {
+            dst[j] = in->scale ? src[j] * in->scale[j] : src[j];
+            if (in->offset) b += src[j] * in->offset[j];
+        }
+        dst[nl] = b;
+    }
+    return w;
+}
+
+/* Rows of `in` may carry extra columns, so the metric helpers can pass
+ * datasets with the targets alongside. */
+static void nerve__compute_batch(network_t *net, const nerve__rows_t *in,
+                                 int n, float *outputs)
+{
+    int j, s, t, b0, width, n_out = net->output_layer->no_of_neurons;
+    float *a, *c, *w1;
+
+    width = nerve__widest_layer(net);
+    w1 = nerve__fold_first(net, in);
+    a = (float *)nerve__aligned_alloc((size_t)(width + 1) *
+                                      NERVENET_BATCH_TILE * sizeof(float));
+    c = (float *)nerve__aligned_alloc((size_t)(width + 1) *
+                                      NERVENET_BATCH_TILE * sizeof(float));
+    if (!a || !c)
+    {
+        /* Out of memory for the tiles: degrade to one sample at a time. */
+        nerve__aligned_free(a); nerve__aligned_free(c);
+        nerve__aligned_free(w1);
+        for (s = 0; s < n; s++)
+        {
+            nerve__set_input_row(net, in, (size_t)s);
+            nerve__forward(net, NULL, NULL);
+            nerve__get_output(net, outputs + (size_t)s * n_out);
+        }
+        return;
+    }
+
+    for (b0 = 0; b0 < n; b0 += NERVENET_BATCH_TILE)
+    {
+        t = n - b0 < NERVENET_BATCH_TILE ? n - b0 : NERVENET_BATCH_TILE;
+
+        /* Transpose the input tile to feature-major, bias row last. */
+        nerve__gather_tile(a, in, NULL, (size_t)b0, t,
+                           net->input_layer->no_of_neurons, w1 == NULL);
+
+        nerve__forward_tile(net, w1, &a, &c, t, net->stats);
+
+        for (s = 0; s < t; s++)
+            for (j = 0; j < n_out; j++)
+                outputs[(size_t)(b0 + s) * n_out + j] = a[(size_t)j * t + s];
+    }
+
+    nerve__aligned_free(a);
+    nerve__aligned_free(c);
+    nerve__aligned_free(w1);
+}
+
+void net_compute_batch(network_t *net, const float *inputs, int n,
+                       float *outputs)
+{
+    nerve__rows_t in;
+    assert(net && inputs && outputs && n >= 0);
+    in = nerve__float_rows(inputs, net->input_layer->no_of_neurons);
+    nerve__compute_batch(net, &in, n, outputs);
+}
+
+void net_compute_raw(network_t *net, const nerve_input_t *fmt,
+                     const void *input, float *output)
+{
+    nerve__rows_t in;
+    assert(net && fmt && input);
+    in = nerve__raw_rows(fmt, input, net->input_layer->no_of_neurons);
+    nerve__set_input_row(net, &in, 0);
+    nerve__forward(net, NULL, NULL);
+    if (output) nerve__get_output(net, output);
+}
+
+void net_compute_batch_raw(network_t *net, const nerve_input_t *fmt,
+                           const void *inputs, int n, float *outputs)
+{
+    nerve__rows_t in;
+    assert(net && fmt && inputs && outputs && n >= 0);
+    in = nerve__raw_rows(fmt, inputs, net->input_layer->no_of_neurons);
+    nerve__compute_batch(net, &in, n, outputs);
+}
+
+/* ── Inference contexts ───────────────────────────────────────────────── */
+net_context_t *net_context_allocate(const network_t *net)
+{
+    net_context_t *ctx;
+    int size;
+    assert(net != NULL);
+    /* Round each buffer to whole cache lines so the two never share one. */
+    size = (nerve__widest_layer(net) + 1 + 15) / 16 * 16;
+    ctx  = (net_context_t *)malloc(sizeof(net_context_t));
+    if (!ctx) return NULL;
+    ctx->size   = size;
+    ctx->act[0] = nerve__alloc_block(2 * size);
+    if (!ctx->act[0]) { free(ctx); return NULL; }
+    ctx->act[1] = ctx->act[0] + size;
+    return ctx;
+}
+
+void net_context_free(net_context_t *ctx)
+{
+    if (!ctx) return;
+    nerve__aligned_free(ctx->act[0]);
+    free(ctx);
+}
+
+/* A one-sample tile: the same kernels as net_compute_batch with t = 1,
+ * which sum each neuron's inputs in the same order as net_compute. */
+void net_compute_ctx(const network_t *net, net_context_t *ctx,
+                     const float *input, float *output)
+{
+    float *a, *c;
+    assert(net && ctx && input && output);
+    assert(ctx->size > nerve__widest_layer(net));
+    a = ctx->act[0];
+    c = ctx->act[1];
+    memcpy(a, input, (size_t)net->input_layer->no_of_neurons * sizeof(float));
+    nerve__forward_tile(net, NULL, &a, &c, 1, NULL);
+    memcpy(output, a,
+           (size_t)net->output_layer->no_of_neurons * sizeof(float));
+}
+
+/* ── Error & backward ─────────────────────────────────────────────────── */
+float net_compute_output_error(network_t *net, const float *target)
+{
+    int n;
+    float y, e, t;
+    assert(net && target);
+    net->global_error = 0.0f;
+
+    if (net->loss == NERVENET_LOSS_CROSS_ENTROPY)
+    {
+        /* Cross-entropy. With a softmax (or sigmoid) output the gradient of
+         * the loss w.r.t. each logit collapses to the clean term (t - y),
+         * so the rest of the backward pass is unchanged. */
+        for (n = 0; n < net->output_layer->no_of_neurons; n++)
+        {
+            y = net->output_layer->neuron[n].output;
+            t = target[n];
+            net->output_layer->neuron[n].error = t - y;
+            if (t > 0.0f)
+                net->global_error -=
+                    t * (float)log((double)(y > 1e-12f ? y : 1e-12f));
+        }
+        return net->global_error;
+    }
+
+    /* Mean squared error. The output-layer delta carries the activation
+     * derivative; for the default sigmoid output this is exactly y*(1-y)*e. */
+    for (n = 0; n < net->output_layer->no_of_neurons; n++)
+    {
+        y = net->output_layer->neuron[n].output;
+        e = target[n] - y;
+        net->output_layer->neuron[n].error =
+            nerve__activate_deriv(y, net->output_activation) * e;
+        net->global_error += e * e;
+    }
+    net->global_error *= 0.5f;
+    return net->global_error;
+}
+
+float net_get_output_error(const network_t *net)
+{ assert(net); return net->global_error; }
+
+/* lower.error = f'(lower.output) * (W^T . upper.error). Walked row by row
+ * — each upper neuron scatters its error along its own weight row — so the
+ * matrix is read front to back instead of one column at a time; a row with
+ * no error (a dropped neuron) is skipped.
+ *
+ * After a dropout pass `mask` holds lower's surviving units and q is the
+ * surviving fraction: survivors were scaled by 1 / q, so the derivative is
+ * taken at the unscaled activation, and dropped units get no error.
+ * Inference passes leave mask NULL. */
+static void nerve__backprop_layer(layer_t *lower, layer_t *upper, int act,
+                                  float q, const unsigned long *mask)
+{
+    int nl, nu, stride = lower->no_of_neurons + 1;
+    const float *w = upper->weight;
+    float e, y;
+    for (nl = 0; nl < stride; nl++)
+        lower->neuron[nl].error = 0.0f;
+    for (nu = 0; nu < upper->no_of_neurons; nu++, w += stride)
+    {
+        e = upper->neuron[nu].error;
+        if (e == 0.0f) continue;
+        for (nl = 0; nl < stride; nl++)
+            lower->neuron[nl].error += w[nl] * e;
+    }
+    for (nl = 0; nl < stride; nl++)
+    {
+        y = lower->neuron[nl].output;
+        if (!mask)
+            lower->neuron[nl].error *= nerve__activate_deriv(y, act);
+        else if (nl < stride - 1 && !NERVE__BIT(mask, nl))
+            lower->neuron[nl].error = 0.0f;
+        else
+            lower->neuron[nl].error *= nerve__activate_deriv(y * q, act) / q;
+    }
+}
+
+/* `keep` is the forward pass's masks, or NULL without dropout. */
+static void nerve__backward(network_t *net, float q, const unsigned long *keep)
+{
+    int l, off = keep ? nerve__hidden_mask_words(net) : 0;
+    NERVE__PROF_VARS(st, net->stats)
+    for (l = net->no_of_layers - 1; l > 1; l--)
+    {
+        NERVE__PROF_START(st);
+        if (keep) off -= NERVE__MASK_WORDS(net->layer[l - 1].no_of_neurons);
+        nerve__backprop_layer(&net->layer[l - 1], &net->layer[l],
+                              net->activation, q, keep ? keep + off : NULL);
+        NERVE__PROF_STOP(st, layer[l].backward,
+                         2.0 * nerve__prof_macs(net, l),
+                         nerve__prof_bytes(net, l, 1));
+    }
+}
+
+/* ── Weight update ────────────────────────────────────────────────────── */
+static int nerve__is_adam(const network_t *net)
+{
+    return net->optimizer == NERVENET_OPTIMIZER_ADAM ||
+           net->optimizer == NERVENET_OPTIMIZER_ADAMW;
+}
+
+/* Advance the Adam step counter and return the two bias corrections
+ * 1 - beta^t. The powers are carried forward by one multiply per step. */
+static void nerve__adam_tick(network_t *net, float *bc1, float *bc2)
+{
+    net->adam_t++;
+    net->adam_beta1_t *= net->adam_beta1;
+    net->adam_beta2_t *= net->adam_beta2;
+    *bc1 = 1.0f - net->adam_beta1_t;
+    *bc2 = 1.0f - net->adam_beta2_t;
+}
+
+/* With nnz >= 0 the first layer's input is the sparse vector (idx, val, nnz)
+ * of net_compute_sparse and only its columns and the bias are stepped; the
+ * dense callers pass nnz = -1. */
+static void nerve__adjust(network_t *net,
+                          const int *idx, const float *val, int nnz)
+{
+    int l, nu, nl, k, n, sparse, stride, adam = nerve__is_adam(net);
+    float lr = net->learning_rate, grad, delta, decay = 0.0f, x;
+    float b1 = 0, b2 = 0, eps = 0, bc1 = 0, bc2 = 0, mh, vh;
+    float *w, *d, *m = NULL, *v = NULL;
+    const layer_t *lower;
+    NERVE__PROF_VARS(opt, net->stats)
+    NERVE__PROF_VARS(st, net->stats)
+
+    NERVE__PROF_START(opt);
+    if (adam)
+    {
+        b1  = net->adam_beta1;  b2  = net->adam_beta2;
+        eps = net->adam_epsilon;
+        nerve__adam_tick(net, &bc1, &bc2);
+        if (net->optimizer == NERVENET_OPTIMIZER_ADAMW)
+            decay = lr * net->weight_decay;
+    }
+
+    for (l = 1; l < net->no_of_layers; l++)
+    {
+        NERVE__PROF_START(st);
+        lower  = &net->layer[l - 1];
+        stride = lower->no_of_neurons + 1;
+        for (nu = 0; nu < net->layer[l].no_of_neurons; nu++)
+        {
+            float err = net->layer[l].neuron[nu].error;
+
+            /* Row nu of every parallel block: same offset in each. */
+            w = net->layer[l].weight + (size_t)nu * stride;
+            d = net->layer[l].delta  + (size_t)nu * stride;
+            if (adam)
+            {
+                m = net->layer[l].adam_m + (size_t)nu * stride;
+                v = net->layer[l].adam_v + (size_t)nu * stride;
+            }
+            sparse = (l == 1 && nnz >= 0);
+            n = sparse ? nnz + 1 : stride;
+            for (k = 0; k < n; k++)
+            {
+                if (!sparse)
+                {
+                    nl = k;
+                    x  = lower->neuron[nl].output;
+                }
+                else if (k < nnz)
+                {
+                    nl = idx[k];
+                    x  = val ? val[k] : 1.0f;
+                }
+                else
+                {
+                    nl = stride - 1;
+                    x  = lower->neuron[nl].output;
+                }
+                grad = err * x;
+                if (net->l2_lambda > 0.0f)
+                    grad -= net->l2_lambda * w[nl];
+
+                if (adam)
+                {
+                    m[nl] = b1 * m[nl] + (1.0f - b1) * grad;
+                    v[nl] = b2 * v[nl] + (1.0f - b2) * grad * grad;
+                    mh = m[nl] / bc1;
+                    vh = v[nl] / bc2;
+                    delta = lr * mh / ((float)sqrt((double)vh) + eps)
+                          - decay * w[nl];
+                }
+                else
+                {
+                    delta = lr * grad + net->momentum * d[nl];
+                }
+                w[nl] += delta;
+                d[nl]  = delta;
+            }
+        }
+        NERVE__PROF_STOP(st, layer[l].update,
+                         NERVE__PROF_STEP_FLOPS(net) * nerve__prof_macs(net, l),
+                         NERVE__PROF_STEP_BYTES(net) * nerve__prof_macs(net, l));
+    }
+    NERVE__PROF_STOP(opt, optimizer,
+                     NERVE__PROF_STEP_FLOPS(net) * net_get_no_of_weights(net),
+                     NERVE__PROF_STEP_BYTES(net) * net_get_no_of_weights(net));
+}
+
+/* ── Online training ──────────────────────────────────────────────────── */
+void net_train(network_t *net)
+{
+    assert(net != NULL);
+    nerve__backward(net, 0.0f, NULL);
+    nerve__adjust(net, NULL, NULL, -1);
+}
+
+void net_train_sparse(network_t *net, const int *idx, const float *val,
+                      int nnz)
+{
+    assert(net && nnz >= 0 && (idx || nnz == 0));
+    nerve__backward(net, 0.0f, NULL);
+    nerve__adjust(net, idx, val, nnz);
+}
+
+/* ── Batch training ───────────────────────────────────────────────────── */
+/* As in nerve__adjust, nnz >= 0 makes the first layer's input sparse. */
+static void nerve__accum_deltas(network_t *net,
+                                const int *idx, const float *val, int nnz)
+{
+    int l, nu, nl, k, stride;
+    float err, *d;
+    const layer_t *lower;
+    NERVE__PROF_VARS(st, net->stats)
+    if (nnz >= 0)
+    {
+        NERVE__PROF_START(st);
+        lower  = net->input_layer;
+        stride = lower->no_of_neurons + 1;
+        d      = net->layer[1].delta;
+        for (nu = 0; nu < net->layer[1].no_of_neurons; nu++, d += stride)
+        {
+            err = net->learning_rate * net->layer[1].neuron[nu].error;
+            if (err == 0.0f) continue;
+            for (k = 0; k < nnz; k++)
+                d[idx[k]] += err * (val ? val[k] : 1.0f);
+            d[stride - 1] += err * lower->neuron[stride - 1].output;
+        }
+        NERVE__PROF_STOP(st, layer[1].update,
+                         2.0 * net->layer[1].no_of_neurons * (nnz + 1),
+                         8.0 * net->layer[1].no_of_neurons * (nnz + 1));
+    }
+    for (l = nnz >= 0 ? 2 : 1; l < net->no_of_layers; l++)
+    {
+        NERVE__PROF_START(st);
+        lower  = &net->layer[l - 1];
+        stride = lower->no_of_neurons + 1;
+        d      = net->layer[l].delta;
+        for (nu = 0; nu < net->layer[l].no_of_neurons; nu++, d += stride)
+        {
+            err = net->learning_rate * net->layer[l].neuron[nu].error;
+            if (err == 0.0f) continue;  /* adds nothing: dropped, or exact */
+            for (nl = 0; nl < stride; nl++)
+                d[nl] += err * lower->neuron[nl].output;
+        }
+        NERVE__PROF_STOP(st, layer[l].update, 2.0 * nerve__prof_macs(net, l),
+                         2.0 * nerve__prof_bytes(net, l, 1));
+    }
+}
+
+/* The padding between layers is zero in both blocks, so the whole span can
+ * be swept as one flat array. */
+static void nerve__apply_deltas(network_t *net)
+{
+    int i;
+    float d = (net->no_of_patterns > 0) ? (float)net->no_of_patterns : 1.0f;
+    for (i = 0; i < net->block_floats; i++)
+        net->weight_block[i] += net->delta_block[i] / d;
+}
+
+void net_begin_batch(network_t *net)
+{ assert(net); net->no_of_patterns = 0; net_reset_deltas(net); }
+
+void net_train_batch(network_t *net)
+{ assert(net); net->no_of_patterns++; nerve__backward(net, 0.0f, NULL); nerve__accum_deltas(net, NULL, NULL, -1); }
+
+void net_train_batch_sparse(network_t *net, const int *idx, const float *val,
+                            int nnz)
+{
+    assert(net && nnz >= 0 && (idx || nnz == 0));
+    net->no_of_patterns++;
+    nerve__backward(net, 0.0f, NULL);
+    nerve__accum_deltas(net, idx, val, nnz);
+}
+
+void net_end_batch(network_t *net)
+{
+    NERVE__PROF_VARS(st, net->stats)
+    assert(net);
+    NERVE__PROF_START(st);
+    nerve__apply_deltas(net);
+    NERVE__PROF_STOP(st, optimizer, 2.0 * net_get_no_of_weights(net),
+                     12.0 * net_get_no_of_weights(net));
+}
+
+/* ── Mini-batch trainer ───────────────────────────────────────────────────
+ * Trains on a block of samples at once instead of looping the one-sample
+ * path. For a tile of t samples it holds, per layer, the activations
+ * A_l (n_l + 1, t) — feature-major with the bias as the last row, the same
+ * layout as the batched forward pass — and the errors E_l (n_l, t). Then
+ *
+ *     forward    A_l     = f(W_l . A_{l-1})           one GEMM per layer
+ *     backward   E_{l-1} = f'(A_{l-1}) * (W_l^T . E_l)
+ *     gradient   G_l    += E_l . A_{l-1}^T            one GEMM per layer
+ *
+ * so each weight is touched a handful of times per tile rather than three
+ * times per sample. A mini-batch larger than NERVENET_TRAIN_TILE is walked
+ * tile by tile with G accumulating, which bounds memory even for full-batch
+ * training; the optimizer step is taken once, after the last tile.
+ *
+ * G lives in the network's delta block: same layout as the weights, so the
+ * update is one flat sweep.
+ */
+typedef struct
+{
+    float         *act;     /* (n_l + 1) * tile                          */
+    float         *err;     /* n_l * tile; NULL for the input layer      */
+    unsigned long *keep;    /* n_l dropout bits for the tile; hidden only */
+} nerve__tile_layer_t;
+
+typedef struct
+{
+    int                  tile;   /* samples per tile                     */
+    nerve__tile_layer_t *layer;
+    void                *mem;
+    float               *grad;   /* private gradient block, or NULL      */
+    float                loss;   /* summed loss of the last run          */
+    nerve_rng_t         *rng;    /* dropout stream: the caller's or own  */
+    nerve_rng_t          own;    /* a shard's private stream             */
+    nerve_stats_t       *stats;  /* private counters, or NULL            */
+} nerve__trainer_t;
+
+static void nerve__trainer_free(nerve__trainer_t *tr)
+{
+    if (!tr) return;
+    nerve__aligned_free(tr->mem);
+    nerve__aligned_free(tr->grad);
+    free(tr->stats);
+    free(tr->layer);
+    free(tr);
+}
+
+static nerve__trainer_t *nerve__trainer_new(const network_t *net, int tile)
+{
+    int l, n, L = net->no_of_layers;
+    size_t bytes = 0, off = 0, sz;
+    char *p;
+    nerve__trainer_t *tr = (nerve__trainer_t *)malloc(sizeof(nerve__trainer_t));
+    if (!tr) return NULL;
+    tr->tile  = tile;
+    tr->mem   = NULL;
+    tr->grad  = NULL;
+    tr->loss  = 0.0f;
+    tr->rng   = &tr->own;
+    tr->stats = NULL;
+    tr->layer = (nerve__tile_layer_t *)calloc((size_t)L,
+                                              sizeof(nerve__tile_layer_t));
+    if (!tr->layer) { free(tr); return NULL; }
+
+    /* One allocation, every array starting on a cache line. */
+#define NERVE__ROUND(b) (((b) + NERVE__ALIGN - 1) / NERVE__ALIGN * NERVE__ALIGN)
+#define NERVE__MASK_BYTES(n) (NERVE__MASK_WORDS(n) * sizeof(unsigned long))
+    for (l = 0; l < L; l++)
+    {
+        n = net->layer[l].no_of_neurons;
+        bytes += NERVE__ROUND((size_t)(n + 1) * tile * sizeof(float));
+        if (l > 0)
+            bytes += NERVE__ROUND((size_t)n * tile * sizeof(float));
+        if (l > 0 && l < L - 1)
+            bytes += NERVE__ROUND(NERVE__MASK_BYTES((size_t)n));
+    }
+    tr->mem = nerve__aligned_alloc(bytes);
+    if (!tr->mem) { nerve__trainer_free(tr); return NULL; }
+    p = (char *)tr->mem;
+    for (l = 0; l < L; l++)
+    {
+        n  = net->layer[l].no_of_neurons;
+        sz = (size_t)(n + 1) * tile * sizeof(float);
+        tr->layer[l].act = (float *)(p + off); off += NERVE__ROUND(sz);
+        if (l > 0)
+        {
+            sz = (size_t)n * tile * sizeof(float);
+            tr->layer[l].err = (float *)(p + off); off += NERVE__ROUND(sz);
+        }
+        if (l > 0 && l < L - 1)
+        {
+            tr->layer[l].keep = (unsigned long *)(p + off);
+            off += NERVE__ROUND(NERVE__MASK_BYTES((size_t)n));
+        }
+    }
+#undef NERVE__MASK_BYTES
+#undef NERVE__ROUND
+    return tr;
+}
+
+static void nerve__deriv_rows(float *e, const float *y, int n, int type)
+{
+    int i;
+    switch (type)
+    {
+    case NERVENET_ACTIVATION_TANH:
+        for (i = 0; i < n; i++) e[i] *= 1.0f - y[i] * y[i];
+        break;
+    case NERVENET_ACTIVATION_RELU:
+        for (i = 0; i < n; i++) e[i] = y[i] > 0.0f ? e[i] : 0.0f;
+        break;
+    case NERVENET_ACTIVATION_LEAKY_RELU:
+        for (i = 0; i < n; i++) e[i] *= y[i] > 0.0f ? 1.0f : 0.01f;
+        break;
+    default:
+        for (i = 0; i < n; i++) e[i] *= y[i] * (1.0f - y[i]);
+        break;
+    }
+}
+
+/* Forward a tile of t samples (rows idx[0..t) of the dataset) and fill the
+ * output-layer errors. Returns the summed loss over the tile. */
+static float nerve__trainer_forward(network_t *net, nerve__trainer_t *tr,
+                                    const nerve__rows_t *in,
+                                    const float *targets,
+                                    const int *idx, int t, int n_outputs)
+{
+    int l, j, s, u, n, kept, draws, L = net->no_of_layers;
+    int thr = nerve__drop_threshold(net->dropout_rate);
+    float scale = thr ? 1.0f / NERVE__DROP_KEEP(thr) : 1.0f;
+    float loss = 0.0f, y, e, tg, *a, *c, *err;
+    const layer_t *lower, *upper;
+    unsigned long *keep;
+    NERVE__PROF_VARS(st, tr->stats ? tr->stats : net->stats)
+    NERVE__PROF_VARS(act, st)
+    NERVE__PROF_VARS(rs, st)
+
+    nerve__gather_tile(tr->layer[0].act, in, idx, 0, t,
+                       net->input_layer->no_of_neurons, 1);
+
+    for (l = 1; l < L; l++)
+    {
+        NERVE__PROF_START(st);
+        lower = &net->layer[l - 1];
+        upper = &net->layer[l];
+        a = tr->layer[l - 1].act;
+        c = tr->layer[l].act;
+        n = upper->no_of_neurons;
+        for (s = 0; s < t; s++)
+            a[(size_t)lower->no_of_neurons * t + s] =
+                lower->neuron[lower->no_of_neurons].output;
+
+        if (l < L - 1 && thr)
+        {
+            /* Dropout: one mask for the tile, which also gates the units'
+             * errors and gradient rows on the way back. Only the surviving
+             * rows are multiplied, activated and scaled, packed, then
+             * spread back over a zeroed tile. */
+            keep = tr->layer[l].keep;
+            NERVE__PROF_START(rs);
+            draws = nerve__drop_mask(keep, n, thr, tr->rng);
+            NERVE__PROF_STOP(rs, rng, draws, 4.0 * NERVE__MASK_WORDS(n));
+            (void)draws;
+            kept = nerve__gemm_kept(c, upper->weight, a, keep, n,
+                                    lower->no_of_neurons, t);
+            NERVE__PROF_START(act);
+            nerve__activate_rows(c, kept * t, net->activation);
+            NERVE__PROF_STOP(act, activation, (double)n * t, 8.0 * n * t);
+            for (j = 0; j < kept * t; j++) c[j] *= scale;
+            nerve__unpack_rows(c, keep, n, kept, t);
+        }
+        else
+        {
+            nerve__gemm_layer(c, upper->weight, a, n, lower->no_of_neurons, t);
+            NERVE__PROF_START(act);
+            if (l < L - 1)
+                nerve__activate_rows(c, n * t, net->activation);
+            else if (net->output_activation == NERVENET_ACTIVATION_SOFTMAX)
+                nerve__softmax_cols(c, n, t);
+            else
+                nerve__activate_rows(c, n * t, net->output_activation);
+            NERVE__PROF_STOP(act, activation, (double)n * t, 8.0 * n * t);
+        }
+        NERVE__PROF_STOP(st, layer[l].forward,
+                         2.0 * nerve__prof_macs(net, l) * t,
+                         nerve__prof_bytes(net, l, t));
+    }
+
+    /* Output errors, as net_compute_output_error does per sample. */
+    a   = tr->layer[L - 1].act;
+    err = tr->layer[L - 1].err;
+    for (u = 0; u < net->output_layer->no_of_neurons; u++)
+        for (s = 0; s < t; s++)
+        {
+            y  = a[(size_t)u * t + s];
+            tg = targets[(size_t)idx[s] * n_outputs + u];
+            e  = tg - y;
+            if (net->loss == NERVENET_LOSS_CROSS_ENTROPY)
+            {
+                err[(size_t)u * t + s] = e;
+                if (tg > 0.0f)
+                    loss -= tg * (float)log((double)(y > 1e-12f ? y : 1e-12f));
+            }
+            else
+            {
+                err[(size_t)u * t + s] =
+                    nerve__activate_deriv(y, net->output_activation) * e;
+                loss += 0.5f * e * e;
+            }
+        }
+    return loss;
+}
+
+/* Back-propagate the tile's errors and add its gradient E_l . A_{l-1}^T
+ * into `grad`, a block laid out like the network's weight block. Under
+ * dropout a dropped unit's error row and activation row are zero for the
+ * whole tile, so its gradient row, its gradient column and its share of
+ * W^T . E are skipped. */
+static void nerve__trainer_backward(network_t *net, nerve__trainer_t *tr,
+                                    float *grad, int t)
+{
+    int l, u, j, s, nl, nu, L = net->no_of_layers;
+    int thr = nerve__drop_threshold(net->dropout_rate);
+    float *g, *el, q = NERVE__DROP_KEEP(thr);
+    const float *w, *eu, *al;
+    const unsigned long *up, *lo;
+    const nerve__kernels_t *k = nerve__kernels();
+    NERVE__PROF_VARS(st, tr->stats ? tr->stats : net->stats)
+    NERVE__PROF_VARS(act, st)
+
+    for (l = L - 1; l >= 1; l--)
+    {
+        NERVE__PROF_START(st);
+        nu = net->layer[l].no_of_neurons;
+        nl = net->layer[l - 1].no_of_neurons;
+        w  = net->layer[l].weight;
+        al = tr->layer[l - 1].act;
+        g  = grad + (net->layer[l].weight - net->weight_block);
+        up = thr && l < L - 1 ? tr->layer[l].keep : NULL;
+        lo = thr && l > 1     ? tr->layer[l - 1].keep : NULL;
+
+        for (u = 0; u < nu; u++)
+        {
+            if (up && !NERVE__BIT(up, u)) continue;
+            eu = tr->layer[l].err + (size_t)u * t;
+            for (j = 0; j <= nl; j++)
+                if (!lo || j == nl || NERVE__BIT(lo, j))
+                    g[(size_t)u * (nl + 1) + j] +=
+                        k->dot(eu, al + (size_t)j * t, t);
+        }
+
+        if (l == 1)                 /* the input layer has no error */
+        {
+            NERVE__PROF_STOP(st, layer[l].backward,
+                             2.0 * nerve__prof_macs(net, l) * t,
+                             nerve__prof_bytes(net, l, t) +
+                             4.0 * nerve__prof_macs(net, l));
+            break;
+        }
+
+        /* E_{l-1} = W^T . E_l, accumulated row by row of W so the matrix
+         * is read front to back; the bias column has no error to carry. */
+        el = tr->layer[l - 1].err;
+        memset(el, 0, (size_t)nl * (size_t)t * sizeof(float));
+        for (u = 0; u < nu; u++)
+        {
+            if (up && !NERVE__BIT(up, u)) continue;
+            eu = tr->layer[l].err + (size_t)u * t;
+            for (j = 0; j < nl; j++)
+                if (!lo || NERVE__BIT(lo, j))
+                    k->axpy(el + (size_t)j * t, w[(size_t)u * (nl + 1) + j],
+                            eu, t);
+        }
+        NERVE__PROF_START(act);
+        if (lo)
+        {
+            /* Survivors were scaled by 1/q: take f' at the unscaled value
+             * and carry the scale through; dropped rows stay zero. */
+            for (j = 0; j < nl; j++)
+                if (NERVE__BIT(lo, j))
+                    for (s = 0; s < t; s++)
+                        el[(size_t)j * t + s] *= nerve__activate_deriv(
+                            al[(size_t)j * t + s] * q, net->activation) / q;
+        }
+        else
+            nerve__deriv_rows(el, al, nl * t, net->activation);
+        NERVE__PROF_STOP(act, activation, (double)nl * t, 12.0 * nl * t);
+        NERVE__PROF_STOP(st, layer[l].backward,
+                         4.0 * nerve__prof_macs(net, l) * t,
+                         nerve__prof_bytes(net, l, t) +
+                         4.0 * nerve__prof_macs(net, l));
+    }
+}
+
+/* Run rows idx[0..m) of the dataset through one trainer, adding their
+ * gradient into `grad`; the summed loss is left in tr->loss. */
+static void nerve__trainer_run(network_t *net, nerve__trainer_t *tr,
+                               float *grad,
+                               const nerve__rows_t *in, const float *targets,
+                               const int *idx, int m, int n_outputs)
+{
+    int k, t;
+    tr->loss = 0.0f;
+    for (k = 0; k < m; k += t)
+    {
+        t = m - k < tr->tile ? m - k : tr->tile;
+        tr->loss += nerve__trainer_forward(net, tr, in, targets, idx + k,
+                                           t, n_outputs);
+        nerve__trainer_backward(net, tr, grad, t);
+    }
+}
+
+/* ── Data-parallel shards ─────────────────────────────────────────────────
+ * With net->threads = T > 1 each mini-batch is cut into T contiguous shards,
+ * one trainer apiece, each with its own activations and gradient block. The
+ * shards run concurrently when the program is built with -fopenmp and one
+ * after another otherwise. Their gradients are then added into the delta
+ * block in shard order, one element at a time, so the sum — and therefore
+ * every weight — depends on T but never on scheduling, and a given seed
+ * gives bit-identical training with or without OpenMP.
+ *
+ * Dropout cannot share one stream across threads: before each batch every
+ * shard is seeded from the epoch's stream, in order, and draws its masks
+ * from its own. T = 1 is exactly the single-trainer path.
+ */
+static void nerve__shards_free(nerve__trainer_t **tr, int nt)
+{
+    int k;
+    if (!tr) return;
+    for (k = 0; k < nt; k++) nerve__trainer_free(tr[k]);
+    free(tr);
+}
+
+static nerve__trainer_t **nerve__shards_new(const network_t *net, int nt,
+                                            int tile)
+{
+    int k;
+    nerve__trainer_t **tr =
+        (nerve__trainer_t **)calloc((size_t)nt, sizeof(nerve__trainer_t *));
+    if (!tr) return NULL;
+    for (k = 0; k < nt; k++)
+    {
+        tr[k] = nerve__trainer_new(net, tile);
+        if (!tr[k]) { nerve__shards_free(tr, nt); return NULL; }
+        /* Shard 0 accumulates straight into the network's delta block,
+         * and counts into the network's stats. */
+        if (k > 0)
+        {
+            tr[k]->grad = nerve__alloc_block(net->block_floats);
+            if (!tr[k]->grad) { nerve__shards_free(tr, nt); return NULL; }
+#if defined(NERVENET_PROFILE)
+            tr[k]->stats = nerve__stats_new(net->no_of_layers);
+            if (!tr[k]->stats) { nerve__shards_free(tr, nt); return NULL; }
+#endif
+        }
+    }
+    return tr;
+}
+
+/* Run one mini-batch (rows idx[0..m) of the dataset) across the nt shards,
+ * leaving the summed gradient in the delta block. Returns the summed loss. */
+static float nerve__trainer_batch(network_t *net, nerve__trainer_t **tr,
+                                  int nt,
+                                  const nerve__rows_t *in,
+                                  const float *targets,
+                                  const int *idx, int m, int n_outputs,
+                                  nerve_rng_t *rng)
+{
+    int k, i, per = (m + nt - 1) / nt;
+    float loss = 0.0f;
+
+    net_reset_deltas(net);
+    if (nt == 1)
+    {
+        tr[0]->rng = rng;
+        nerve__trainer_run(net, tr[0], net->delta_block, in, targets,
+                           idx, m, n_outputs);
+        return tr[0]->loss;
+    }
+
+    if (net->dropout_rate > 0.0f)
+        for (k = 0; k < nt; k++)
+            nerve_rng_seed(tr[k]->rng, nerve_rng_u32(rng));
+
+#if defined(_OPENMP)
+#   pragma omp parallel for schedule(static) num_threads(nt)
+#endif
+    for (k = 0; k < nt; k++)
+    {
+        int lo = k * per, hi = lo + per;
+        float *g = k ? tr[k]->grad : net->delta_block;
+        if (hi > m) hi = m;
+        if (k > 0)
+            memset(g, 0, (size_t)net->block_floats * sizeof(float));
+        nerve__trainer_run(net, tr[k], g, in, targets,
+                           idx + lo, hi > lo ? hi - lo : 0, n_outputs);
+    }
+
+#if defined(_OPENMP)
+#   pragma omp parallel for schedule(static) num_threads(nt)
+#endif
+    for (i = 0; i < net->block_floats; i++)
+    {
+        int j;
+        for (j = 1; j < nt; j++) net->delta_block[i] += tr[j]->grad[i];
+    }
+
+#if defined(NERVENET_PROFILE)
+    for (k = 1; net->stats && k < nt; k++)
+        nerve__stats_add(net->stats, tr[k]->stats);
+#endif
+    for (k = 0; k < nt; k++) loss += tr[k]->loss;
+    return loss;
+}
+
+/* Classic mini-batch SGD: step by lr times the batch-mean gradient, the same
+ * update net_end_batch applies. The delta block keeps the step taken. */
+static void nerve__sgd_batch_step(network_t *net, int m)
+{
+#if defined(NERVENET_PROFILE)
+    int l, off, n;
+    NERVE__PROF_VARS(st, net->stats)
+    for (l = 1; l < net->no_of_layers; l++)
+    {
+        nerve__layer_span(net, l, &off, &n);
+        NERVE__PROF_START(st);
+        nerve__kernels()->sgd(net->weight_block + off, net->delta_block + off,
+                              n, net->learning_rate / (float)m);
+        NERVE__PROF_STOP(st, layer[l].update, 2.0 * nerve__prof_macs(net, l),
+                         16.0 * nerve__prof_macs(net, l));
+    }
+#else
+    nerve__kernels()->sgd(net->weight_block, net->delta_block,
+                          net->block_floats, net->learning_rate / (float)m);
+#endif
+}
+
+/* Adam / AdamW from the summed gradient in the delta block; `scale` turns
+ * that sum into the batch mean. One fused sweep reads g, m, v and w once and
+ * writes m, v, w and the step taken, where the per-sample path pays that
+ * traffic for every sample. The bias corrections are folded into the step
+ * size and epsilon (Kingma & Ba, section 2), which leaves a single divide and
+ * square root per weight. Zero padding yields a zero step and stays zero. */
+static void nerve__adam_batch_step(network_t *net, float scale)
+{
+    float bc1, bc2, sq;
+    nerve__adam_args_t p;
+#if defined(NERVENET_PROFILE)
+    int l, off, n;
+    NERVE__PROF_VARS(st, net->stats)
+#endif
+
+    nerve__adam_tick(net, &bc1, &bc2);
+    sq      = (float)sqrt((double)bc2);
+    p.scale = scale;
+    p.l2    = net->l2_lambda;
+    p.b1    = net->adam_beta1;
+    p.b2    = net->adam_beta2;
+    p.lr_t  = net->learning_rate * sq / bc1;
+    p.eps_t = net->adam_epsilon * sq;
+    p.decay = net->optimizer == NERVENET_OPTIMIZER_ADAMW
+            ? net->learning_rate * net->weight_decay : 0.0f;
+#if defined(NERVENET_PROFILE)
+    for (l = 1; l < net->no_of_layers; l++)
+    {
+        nerve__layer_span(net, l, &off, &n);
+        NERVE__PROF_START(st);
+        nerve__kernels()->adam(net->weight_block + off, net->delta_block + off,
+                               net->adam_m + off, net->adam_v + off, n, &p);
+        NERVE__PROF_STOP(st, layer[l].update, 16.0 * nerve__prof_macs(net, l),
+                         32.0 * nerve__prof_macs(net, l));
+    }
+#else
+    nerve__kernels()->adam(net->weight_block, net->delta_block,
+                           net->adam_m, net->adam_v, net->block_floats, &p);
+#endif
+}
+
+/* Zero the pruned weights again after an optimizer step, and the step and
+ * moments that would push them off zero. */
+static void nerve__hold_pruned(network_t *net)
+{
+    int i;
+    for (i = 0; i < net->block_floats; i++)
+        if (NERVE__BIT(net->prune_mask, i))
+        {
+            net->weight_block[i] = 0.0f;
+            net->delta_block[i]  = 0.0f;
+            if (net->adam_m) net->adam_m[i] = 0.0f;
+            if (net->adam_v) net->adam_v[i] = 0.0f;
+        }
+}
+
+/* ── Mini-batch / shuffled-online epoch helper ────────────────────────── */
+/*
+ * Shuffles the dataset, then iterates in mini-batches of `batch_size`.
+ *
+ * Each mini-batch goes through the batched trainer above and the optimizer
+ * then takes one step on the batch-mean gradient:
+ *
+ *   ADAM / ADAMW (recommended): one fused Adam step per batch. batch_size 1
+ *     is plain stochastic Adam.
+ *   SGD: classic mini-batch SGD, lr times the mean gradient.
+ *
+ * net_set_threads(net, T) splits each batch across T shards (see above);
+ * build with -fopenmp to run them on T threads.
+ *
+ * Returns the mean loss over all samples in the epoch.
+ */
+float net_train_epoch(network_t *net,
+                      const float *inputs, const float *targets,
+                      int n_pairs, int n_inputs, int n_outputs,
+                      int batch_size)
+{
+    return net_train_epoch_r(net, inputs, targets, n_pairs, n_inputs,
+                             n_outputs, batch_size, &nerve__rng);
+}
+
+/* One optimiser step on samples idx[0..m) of inputs and targets; returns
+ * their summed loss. The trainers leave the summed gradient in the delta
+ * block. Without them (tr NULL) the one-sample path accumulates there
+ * instead — lr times the gradient, hence the different scale — and if even
+ * its dropout masks cannot be allocated, the step trains without dropout. */
+static float nerve__train_step(network_t *net, nerve__trainer_t **tr, int nt,
+                               const nerve__rows_t *in, const float *targets,
+                               const int *idx, int m, int n_outputs,
+                               nerve_rng_t *rng)
+{
+    int k, thr;
+    float loss = 0.0f, q;
+    unsigned long *keep = NULL;
+    NERVE__PROF_VARS(st, net->stats)
+    if (tr)
+        loss = nerve__trainer_batch(net, tr, nt, in, targets, idx, m,
+                                    n_outputs, rng);
+    else
+    {
+        thr = nerve__drop_threshold(net->dropout_rate);
+        if (thr && nerve__hidden_mask_words(net) > 0)
+            keep = (unsigned long *)malloc(
+                (size_t)nerve__hidden_mask_words(net) * sizeof(unsigned long));
+        q = NERVE__DROP_KEEP(thr);
+        net_begin_batch(net);
+        for (k = 0; k < m; k++)
+        {
+            nerve__set_input_row(net, in, (size_t)idx[k]);
+            nerve__forward(net, keep ? rng : NULL, keep);
+            loss += net_compute_output_error(net, targets + idx[k] * n_outputs);
+            net->no_of_patterns++;
+            nerve__backward(net, q, keep);
+            nerve__accum_deltas(net, NULL, NULL, -1);
+        }
+        free(keep);
+    }
+
+    NERVE__PROF_START(st);
+    if (nerve__is_adam(net))
+        nerve__adam_batch_step(net, tr ? 1.0f / (float)m
+                                       : 1.0f / ((float)m * net->learning_rate));
+    else if (tr)
+        nerve__sgd_batch_step(net, m);
+    else
+        nerve__apply_deltas(net);
+    if (net->prune_mask) nerve__hold_pruned(net);
+    NERVE__PROF_STOP(st, optimizer,
+                     NERVE__PROF_STEP_FLOPS(net) * net_get_no_of_weights(net),
+                     NERVE__PROF_STEP_BYTES(net) * net_get_no_of_weights(net));
+    return loss;
+}
+
+/* One trainer per thread, each holding at most NERVENET_TRAIN_TILE of a
+ * batch_size batch; NULL if the workspace cannot be allocated. */
+static nerve__trainer_t **nerve__shards_for(network_t *net, int batch_size,
+                                            int *nt)
+{
+    int tile;
+    *nt  = net->threads > batch_size ? batch_size : net->threads;
+    tile = (batch_size + *nt - 1) / *nt;
+    return nerve__shards_new(net, *nt, tile < NERVENET_TRAIN_TILE
+                                       ? tile : NERVENET_TRAIN_TILE);
+}
+
+/* The end of an epoch advances net_set_prune_schedule by one step. */
+static void nerve__prune_step(network_t *net)
+{
+    float f;
+    if (net->prune_epoch >= net->prune_epochs) return;
+    f = 1.0f - (float)++net->prune_epoch / (float)net->prune_epochs;
+    net_prune(net, net->prune_target * (1.0f - f * f * f));
+}
+
+static float nerve__train_epoch(network_t *net, const nerve__rows_t *in,
+                                const float *targets,
+                                int n_pairs, int n_outputs,
+                                int batch_size, nerve_rng_t *rng)
+{
+    int *order, i, j, tmp, b_start, m, nt;
+    float total_err = 0.0f;
+    nerve__trainer_t **tr;
+    NERVE__PROF_VARS(st, net->stats)
+
+    order = (int *)malloc((size_t)n_pairs * sizeof(int));
+    NERVE__PROF_START(st);
+    for (i = 0; i < n_pairs; i++) order[i] = i;
+    for (i = n_pairs - 1; i > 0; i--)
+    {
+        j = (int)nerve_rng_below(rng, (unsigned long)(i + 1));
+        tmp = order[i]; order[i] = order[j]; order[j] = tmp;
+    }
+    NERVE__PROF_STOP(st, rng, n_pairs - 1, 8.0 * n_pairs);
+
+    tr = nerve__shards_for(net, batch_size, &nt);
+    for (b_start = 0; b_start < n_pairs; b_start += batch_size)
+    {
+        m = n_pairs - b_start < batch_size ? n_pairs - b_start : batch_size;
+        total_err += nerve__train_step(net, tr, nt, in, targets,
+                                       order + b_start, m, n_outputs, rng);
+    }
+    nerve__shards_free(tr, nt);
+    nerve__prune_step(net);
+
+    free(order);
+    return total_err / (float)n_pairs;
+}
+
+float net_train_epoch_r(network_t *net,
+                        const float *inputs, const float *targets,
+                        int n_pairs, int n_inputs, int n_outputs,
+                        int batch_size, nerve_rng_t *rng)
+{
+    nerve__rows_t in;
+    assert(net && inputs && targets && n_pairs > 0 && batch_size > 0);
+    assert(rng != NULL);
+    in = nerve__float_rows(inputs, n_inputs);
+    return nerve__train_epoch(net, &in, targets, n_pairs, n_outputs,
+                              batch_size, rng);
+}
+
+float net_train_epoch_raw(network_t *net, const nerve_input_t *fmt,
+                          const void *inputs, const float *targets,
+                          int n_pairs, int n_inputs, int n_outputs,
+                          int batch_size)
+{
+    return net_train_epoch_raw_r(net, fmt, inputs, targets, n_pairs,
+                                 n_inputs, n_outputs, batch_size, &nerve__rng);
+}
+
+float net_train_epoch_raw_r(network_t *net, const nerve_input_t *fmt,
+                            const void *inputs, const float *targets,
+                            int n_pairs, int n_inputs, int n_outputs,
+                            int batch_size, nerve_rng_t *rng)
+{
+    nerve__rows_t in;
+    assert(net && fmt && inputs && targets && n_pairs > 0 && batch_size > 0);
+    assert(rng != NULL);
+    in = nerve__raw_rows(fmt, inputs, n_inputs);
+    return nerve__train_epoch(net, &in, targets, n_pairs, n_outputs,
+                              batch_size, rng);
+}
+
+/* ── Streaming datasets ───────────────────────────────────────────────────
+ * Two batch slots. The producer — the background thread, or the caller
+ * itself without one — fills `fill` from the source through the shuffle
+ * pool; the caller takes `take` and holds it until its next call, so one
+ * batch is always being decoded while another trains.
+ */
+struct nerve_dataset_s
+{
+    nerve_source_t src;
+    void        *state;
+    int          n_inputs, n_outputs;
+    int          buffer;            /* shuffle pool capacity, in samples   */
+    int          pooled;            /* samples in the pool                 */
+    int          drained;           /* the source ended this pass          */
+    float       *pool;
+    nerve_rng_t  rng;
+    int          batch, cap;        /* this pass's batch size; slot size   */
+    float       *in[2], *out[2];
+    int          count[2];
+    int          take;
+#if defined(NERVE__THREADS)
+    int          ready[2], fill, held, running, done, quit;
+    pthread_t       thread;
+    pthread_mutex_t mu;
+    pthread_cond_t  cv;
+#endif
+};
+
+/* Decode up to ds->batch samples into slot i. 0 ends the pass and rewinds
+ * the source for the next one. */
+static int nerve__dataset_fill(nerve_dataset_t *ds, int i)
+{
+    int m = 0, r, j, ni = ds->n_inputs, no = ds->n_outputs, stride = ni + no;
+    float *p, *last;
+    while (m < ds->batch)
+    {
+        if (ds->buffer == 0)
+        {
+            r = ds->drained ? 0
+              : ds->src.read(ds->state, ds->in[i] + (size_t)m * ni,
+                             ds->out[i] + (size_t)m * no);
+            if (r < 0) return r;
+            if (r == 0) { ds->drained = 1; break; }
+            m++;
+            continue;
+        }
+        while (!ds->drained && ds->pooled < ds->buffer)
+        {
+            p = ds->pool + (size_t)ds->pooled * stride;
+            r = ds->src.read(ds->state, p, p + ni);
+            if (r < 0) return r;
+            if (r == 0) ds->drained = 1; else ds->pooled++;
+        }
+        if (ds->pooled == 0) break;
+        j    = (int)nerve_rng_below(&ds->rng, (unsigned long)ds->pooled);
+        p    = ds->pool + (size_t)j * stride;
+        last = ds->pool + (size_t)--ds->pooled * stride;
+        memcpy(ds->in[i]  + (size_t)m * ni, p,      (size_t)ni * sizeof(float));
+        memcpy(ds->out[i] + (size_t)m * no, p + ni, (size_t)no * sizeof(float));
+        if (p != last) memcpy(p, last, (size_t)stride * sizeof(float));
+        m++;
+    }
+    if (m == 0)
+    {
+        ds->drained = 0;
+        if (ds->src.rewind(ds->state) != 0) return NERVENET_ERROR_IO;
+    }
+    return m;
+}
+
+#if defined(NERVE__THREADS)
+static void *nerve__dataset_main(void *arg)
+{
+    nerve_dataset_t *ds = (nerve_dataset_t *)arg;
+    int i, m;
+    pthread_mutex_lock(&ds->mu);
+    for (;;)
+    {
+        while (!ds->quit && (!ds->running || ds->done || ds->ready[ds->fill]))
+            pthread_cond_wait(&ds->cv, &ds->mu);
+        if (ds->quit) break;
+        i = ds->fill;
+        pthread_mutex_unlock(&ds->mu);
+        m = nerve__dataset_fill(ds, i);
+        pthread_mutex_lock(&ds->mu);
+        ds->count[i] = m;
+        ds->ready[i] = 1;
+        ds->fill ^= 1;
+        if (m <= 0) ds->done = 1;
+        pthread_cond_broadcast(&ds->cv);
+    }
+    pthread_mutex_unlock(&ds->mu);
+    return NULL;
+}
+#endif
+
+nerve_dataset_t *nerve_dataset_new(const nerve_source_t *source, void *state,
+                                   int n_inputs, int n_outputs)
+{
+    nerve_dataset_t *ds;
+    assert(source && source->read && source->rewind && source->close);
+    assert(n_inputs > 0 && n_outputs > 0);
+    ds = (nerve_dataset_t *)calloc(1, sizeof(nerve_dataset_t));
+    if (!ds) { source->close(state); return NULL; }
+    ds->src       = *source;
+    ds->state     = state;
+    ds->n_inputs  = n_inputs;
+    ds->n_outputs = n_outputs;
+    nerve_rng_seed(&ds->rng, 1);
+#if defined(NERVE__THREADS)
+    ds->held = -1;
+    if (pthread_mutex_init(&ds->mu, NULL) != 0)
+    { source->close(state); free(ds); return NULL; }
+    if (pthread_cond_init(&ds->cv, NULL) != 0)
+    {
+        pthread_mutex_destroy(&ds->mu);
+        source->close(state); free(ds);
+        return NULL;
+    }
+    if (pthread_create(&ds->thread, NULL, nerve__dataset_main, ds) != 0)
+    {
+        pthread_cond_destroy(&ds->cv);
+        pthread_mutex_destroy(&ds->mu);
+        source->close(state); free(ds);
+        return NULL;
+    }
+#endif
+    return ds;
+}
+
+void nerve_dataset_free(nerve_dataset_t *ds)
+{
+    if (!ds) return;
+#if defined(NERVE__THREADS)
+    pthread_mutex_lock(&ds->mu);
+    ds->quit = 1;
+    pthread_cond_broadcast(&ds->cv);
+    pthread_mutex_unlock(&ds->mu);
+    pthread_join(ds->thread, NULL);
+    pthread_cond_destroy(&ds->cv);
+    pthread_mutex_destroy(&ds->mu);
+#endif
+    ds->src.close(ds->state);
+    free(ds->pool);
+    free(ds->in[0]); free(ds->in[1]); free(ds->out[0]); free(ds->out[1]);
+    free(ds);
+}
+
+void nerve_dataset_shuffle(nerve_dataset_t *ds, int buffer, unsigned long seed)
+{
+    float *pool = NULL;
+    assert(ds && buffer >= 0 && ds->batch == 0 && ds->pooled == 0);
+    if (buffer > 0)
+    {
+        pool = (float *)malloc((size_t)buffer *
+                               (size_t)(ds->n_inputs + ds->n_outputs) *
+                               sizeof(float));
+        if (!pool) return;              /* keeps the previous setting */
+    }
+    free(ds->pool);
+    ds->pool   = pool;
+    ds->buffer = buffer;
+    nerve_rng_seed(&ds->rng, seed);
+}
+
+int nerve_dataset_inputs(const nerve_dataset_t *ds)  { return ds->n_inputs; }
+int nerve_dataset_outputs(const nerve_dataset_t *ds) { return ds->n_outputs; }
+
+int nerve_dataset_next(nerve_dataset_t *ds, int batch_size,
+                       const float **inputs, const float **targets)
+{
+    int i, k, m;
+    assert(ds && inputs && targets && batch_size > 0);
+    if (ds->batch == 0)
+    {
+        /* Between passes the producer is idle: the slots can grow. */
+        if (batch_size > ds->cap)
+            for (k = 0; k < 2; k++)
+            {
+                free(ds->in[k]); free(ds->out[k]);
+                ds->in[k]  = (float *)malloc((size_t)batch_size *
+                                             (size_t)ds->n_inputs * sizeof(float));
+                ds->out[k] = (float *)malloc((size_t)batch_size *
+                                             (size_t)ds->n_outputs * sizeof(float));
+                ds->cap = batch_size;
+                if (!ds->in[k] || !ds->out[k]) ds->cap = 0;
+            }
+        if (ds->cap < batch_size) return NERVENET_ERROR_MEMORY;
+        ds->batch = batch_size;
+    }
+    assert(batch_size == ds->batch);
+#if defined(NERVE__THREADS)
+    pthread_mutex_lock(&ds->mu);
+    if (ds->held >= 0) { ds->ready[ds->held] = 0; ds->held = -1; }
+    if (!ds->running) { ds->running = 1; ds->done = 0; }
+    pthread_cond_broadcast(&ds->cv);
+    while (!ds->ready[ds->take]) pthread_cond_wait(&ds->cv, &ds->mu);
+    i = ds->take;
+    ds->take ^= 1;
+    m = ds->count[i];
+    if (m > 0) ds->held = i;
+    else { ds->ready[i] = 0; ds->running = 0; }
+    pthread_mutex_unlock(&ds->mu);
+#else
+    i = ds->take;
+    m = ds->count[i] = nerve__dataset_fill(ds, i);
+#endif
+    if (m <= 0) ds->batch = 0;
+    *inputs  = ds->in[i];
+    *targets = ds->out[i];
+    return m;
+}
+
+float net_train_dataset(network_t *net, nerve_dataset_t *ds, int batch_size)
+{
+    return net_train_dataset_r(net, ds, batch_size, &nerve__rng);
+}
+
+float net_train_dataset_r(network_t *net, nerve_dataset_t *ds,
+                          int batch_size, nerve_rng_t *rng)
+{
+    int *idx, i, m, nt, n = 0;
+    float loss = 0.0f;
+    const float *x, *tg;
+    nerve__rows_t in;
+    nerve__trainer_t **tr;
+    assert(net && ds && batch_size > 0 && rng);
+    assert(ds->n_inputs  == net->input_layer->no_of_neurons &&
+           ds->n_outputs == net->output_layer->no_of_neurons);
+
+    /* Each batch arrives contiguous: the trainer reads it in order. */
+    idx = (int *)malloc((size_t)batch_size * sizeof(int));
+    if (!idx) return (float)NERVENET_ERROR_MEMORY;
+    for (i = 0; i < batch_size; i++) idx[i] = i;
+    tr = nerve__shards_for(net, batch_size, &nt);
+    while ((m = nerve_dataset_next(ds, batch_size, &x, &tg)) > 0)
+    {
+        in    = nerve__float_rows(x, ds->n_inputs);
+        loss += nerve__train_step(net, tr, nt, &in, tg, idx, m,
+                                  ds->n_outputs, rng);
+        n += m;
+    }
+    nerve__shards_free(tr, nt);
+    free(idx);
+    if (m < 0) return (float)m;
+    nerve__prune_step(net);
+    return n ? loss / (float)n : 0.0f;
+}
+
+/* IDX (LeCun): 0, 0, a type byte (0x08 is unsigned byte), a dimension
+ * count, then each dimension as a big-endian 32-bit int. The first
+ * dimension counts the items. */
+typedef struct
+{
+    FILE          *f;
+    unsigned char *labels, *row;
+    int            n, dim, classes, pos;
+    long           data;
+} nerve__idx_t;
+
+static int nerve__idx_header(FILE *f, int *items, int *dim)
+{
+    unsigned char b[4];
+    int d, nd;
+    long v;
+    if (fread(b, 1, 4, f) < 4 || b[0] || b[1] || b[2] != 0x08 || b[3] < 1)
+        return -1;
+    nd = b[3];
+    *dim = 1;
+    for (d = 0; d < nd; d++)
+    {
+        if (fread(b, 1, 4, f) < 4) return -1;
+        v = ((long)b[0] << 24) | ((long)b[1] << 16) | ((long)b[2] << 8) | b[3];
+        if (v <= 0 || v > 0x7FFFFFFFL) return -1;
+        if (d == 0) *items = (int)v;
+        else if (v > NERVENET_MAX_NEURONS / *dim) return -1;  /* no overflow */
+        else *dim *= (int)v;
+    }
+    return 0;
+}
+
+static int nerve__idx_read(void *state, float *input, float *target)
+{
+    nerve__idx_t *s = (nerve__idx_t *)state;
+    int j;
+    if (s->pos == s->n) return 0;
+    if (fread(s->row, 1, (size_t)s->dim, s->f) < (size_t)s->dim)
+        return NERVENET_ERROR_CORRUPT;
+    for (j = 0; j < s->dim; j++) input[j] = s->row[j] / 255.0f;
+    memset(target, 0, (size_t)s->classes * sizeof(float));
+    target[s->labels[s->pos++]] = 1.0f;
+    return 1;
+}
+
+static int nerve__idx_rewind(void *state)
+{
+    nerve__idx_t *s = (nerve__idx_t *)state;
+    s->pos = 0;
+    return fseek(s->f, s->data, SEEK_SET);
+}
+
+static void nerve__idx_close(void *state)
+{
+    nerve__idx_t *s = (nerve__idx_t *)state;
+    if (s->f) fclose(s->f);
+    free(s->labels); free(s->row); free(s);
+}
+
+nerve_dataset_t *nerve_dataset_idx(const char *images, const char *labels)
+{
+    static const nerve_source_t src = {
+        nerve__idx_read, nerve__idx_rewind, nerve__idx_close };
+    nerve__idx_t *s;
+    FILE *lf;
+    int i, n = 0, one = 0;
+    assert(images && labels);
+    s = (nerve__idx_t *)calloc(1, sizeof(nerve__idx_t));
+    if (!s) return NULL;
+
+    /* Labels are a byte a sample: read them whole and count the classes. */
+    lf = fopen(labels, "rb");
+    if (!lf || nerve__idx_header(lf, &n, &one) != 0 || one != 1 ||
+        !(s->labels = (unsigned char *)malloc((size_t)n)) ||
+        fread(s->labels, 1, (size_t)n, lf) < (size_t)n)
+    { if (lf) fclose(lf); nerve__idx_close(s); return NULL; }
+    fclose(lf);
+    for (i = 0; i < n; i++)
+        if (s->labels[i] >= s->classes) s->classes = s->labels[i] + 1;
+
+    s->f = fopen(images, "rb");
+    if (!s->f || nerve__idx_header(s->f, &s->n, &s->dim) != 0 || s->n != n ||
+        !(s->row = (unsigned char *)malloc((size_t)s->dim)))
+    { nerve__idx_close(s); return NULL; }
+    s->data = ftell(s->f);
+    return nerve_dataset_new(&src, s, s->dim, s->classes);
+}
+
+/* The whole file is mapped read-only and shared, so any number of
+ * processes training on it share one copy in the page cache. */
+int nerve_idx_map(nerve_idx_t *idx, const char *filename)
+{
+    FILE *f;
+    long head, end;
+    int ok;
+    assert(idx && filename);
+    memset(idx, 0, sizeof(nerve_idx_t));
+    f = fopen(filename, "rb");
+    if (!f) return NERVENET_ERROR_IO;
+    ok   = nerve__idx_header(f, &idx->count, &idx->width) == 0;
+    head = ftell(f);
+    if (!ok || head < 0 || fseek(f, 0L, SEEK_END) != 0 || (end = ftell(f)) < 0 ||
+        (size_t)(end - head) < (size_t)idx->count * (size_t)idx->width)
+    { fclose(f); return NERVENET_ERROR_CORRUPT; }
+    idx->bytes = (size_t)end;
+
+#if defined(NERVE__MMAP)
+    {
+        int fd = open(filename, O_RDONLY);
+        void *base = fd < 0 ? MAP_FAILED
+                   : mmap(NULL, idx->bytes, PROT_READ, MAP_SHARED, fd, 0);
+        if (fd >= 0) close(fd);
+        if (base != MAP_FAILED)
+        {
+            fclose(f);
+            idx->base   = base;
+            idx->mapped = 1;
+            idx->data   = (const unsigned char *)base + head;
+            return NERVENET_SUCCESS;
+        }
+    }
+#endif
+    idx->base = malloc(idx->bytes);
+    if (!idx->base) { fclose(f); return NERVENET_ERROR_MEMORY; }
+    rewind(f);
+    ok = fread(idx->base, 1, idx->bytes, f) == idx->bytes;
+    fclose(f);
+    if (!ok) { nerve_idx_unmap(idx); return NERVENET_ERROR_IO; }
+    idx->data = (const unsigned char *)idx->base + head;
+    return NERVENET_SUCCESS;
+}
+
+void nerve_idx_unmap(nerve_idx_t *idx)
+{
+    assert(idx != NULL);
+    if (idx->mapped) nerve__unmap(idx->base, idx->bytes);
+    else             free(idx->base);
+    memset(idx, 0, sizeof(nerve_idx_t));
+}
+
+/* CSV: one growing line buffer, parsed in place with strtod. */
+typedef struct
+{
+    FILE  *f;
+    char  *line;
+    size_t cap;
+    int    n_inputs, n_outputs, first;
+} nerve__csv_t;
+
+/* Read one line, however long; 0 at the end of the file. */
+static int nerve__csv_line(nerve__csv_t *s)
+{
+    size_t len = 0;
+    char *grown;
+    for (;;)
+    {
+        if (!fgets(s->line + len, (int)(s->cap - len), s->f)) return len > 0;
+        len += strlen(s->line + len);
+        if (s->line[len - 1] == '\n' || len + 1 < s->cap) return 1;
+        grown = (char *)realloc(s->line, s->cap * 2);
+        if (!grown) return NERVENET_ERROR_MEMORY;
+        s->line = grown;
+        s->cap *= 2;
+    }
+}
+
+static int nerve__csv_read(void *state, float *input, float *target)
+{
+    nerve__csv_t *s = (nerve__csv_t *)state;
+    int k, r, n = s->n_inputs + s->n_outputs;
+    char *p, *e;
+    double v;
+    for (;;)
+    {
+        if ((r = nerve__csv_line(s)) <= 0) return r;
+        for (p = s->line; *p == ' ' || *p == '\t' || *p == '\r'; p++) {}
+        if (*p == '\n' || *p == '\0') continue;          /* blank line */
+        for (k = 0; k < n; k++)
+        {
+            v = strtod(p, &e);
+            if (e == p) break;
+            if (k < s->n_inputs) input[k] = (float)v;
+            else target[k - s->n_inputs] = (float)v;
+            for (p = e; *p == ',' || *p == ';' || *p == ' ' || *p == '\t'; p++) {}
+        }
+        if (k == n) { s->first = 0; return 1; }
+        if (k > 0 || !s->first) return NERVENET_ERROR_CORRUPT;
+        s->first = 0;                                    /* a header */
+    }
+}
+
+static int nerve__csv_rewind(void *state)
+{
+    nerve__csv_t *s = (nerve__csv_t *)state;
+    s->first = 1;
+    return fseek(s->f, 0L, SEEK_SET);
+}
+
+static void nerve__csv_close(void *state)
+{
+    nerve__csv_t *s = (nerve__csv_t *)state;
+    if (s->f) fclose(s->f);
+    free(s->line); free(s);
+}
+
+nerve_dataset_t *nerve_dataset_csv(const char *filename,
+                                   int n_inputs, int n_outputs)
+{
+    static const nerve_source_t src = {
+        nerve__csv_read, nerve__csv_rewind, nerve__csv_close };
+    nerve__csv_t *s;
+    assert(filename && n_inputs > 0 && n_outputs > 0);
+    s = (nerve__csv_t *)calloc(1, sizeof(nerve__csv_t));
+    if (!s) return NULL;
+    s->cap  = 4096;
+    s->line = (char *)malloc(s->cap);
+    s->f    = fopen(filename, "r");
+    if (!s->line || !s->f) { nerve__csv_close(s); return NULL; }
+    s->n_inputs  = n_inputs;
+    s->n_outputs = n_outputs;
+    s->first     = 1;
+    return nerve_dataset_new(&src, s, n_inputs, n_outputs);
+}
+
+/* Raw: fixed-size records, one fread each. */
+typedef struct
+{
+    FILE          *f;
+    unsigned char *rec;
+    int            n_inputs, n_outputs, type;
+    size_t         bytes;
+} nerve__raw_t;
+
+static int nerve__raw_read(void *state, float *input, float *target)
+{
+    nerve__raw_t *s = (nerve__raw_t *)state;
+    size_t got = fread(s->rec, 1, s->bytes, s->f);
+    int k;
+    if (got == 0) return 0;
+    if (got < s->bytes) return NERVENET_ERROR_CORRUPT;
+    if (s->type == NERVENET_DATA_F32)
+    {
+        memcpy(input, s->rec, (size_t)s->n_inputs * sizeof(float));
+        memcpy(target, s->rec + (size_t)s->n_inputs * sizeof(float),
+               (size_t)s->n_outputs * sizeof(float));
+        return 1;
+    }
+    for (k = 0; k < s->n_inputs; k++) input[k] = s->rec[k] / 255.0f;
+    for (k = 0; k < s->n_outputs; k++) target[k] = (float)s->rec[s->n_inputs + k];
+    return 1;
+}
+
+static int nerve__raw_rewind(void *state)
+{
+    return fseek(((nerve__raw_t *)state)->f, 0L, SEEK_SET);
+}
+
+static void nerve__raw_close(void *state)
+{
+    nerve__raw_t *s = (nerve__raw_t *)state;
+    if (s->f) fclose(s->f);
+    free(s->rec); free(s);
+}
+
+nerve_dataset_t *nerve_dataset_raw(const char *filename,
+                                   int n_inputs, int n_outputs,
+                                   nervenet_data_t type)
+{
+    static const nerve_source_t src = {
+        nerve__raw_read, nerve__raw_rewind, nerve__raw_close };
+    nerve__raw_t *s;
+    assert(filename && n_inputs > 0 && n_outputs > 0);
+    assert(type == NERVENET_DATA_F32 || type == NERVENET_DATA_U8);
+    s = (nerve__raw_t *)calloc(1, sizeof(nerve__raw_t));
+    if (!s) return NULL;
+    s->n_inputs  = n_inputs;
+    s->n_outputs = n_outputs;
+    s->type      = (int)type;
+    s->bytes     = (size_t)(n_inputs + n_outputs) *
+                   (type == NERVENET_DATA_F32 ? sizeof(float) : 1);
+    s->rec       = (unsigned char *)malloc(s->bytes);
+    s->f         = fopen(filename, "rb");
+    if (!s->rec || !s->f) { nerve__raw_close(s); return NULL; }
+    return nerve_dataset_new(&src, s, n_inputs, n_outputs);
+}
+
+/* ── Metrics ──────────────────────────────────────────────────────────── */
+static int nerve__classify_row(network_t *net, const nerve__rows_t *in,
+                               size_t r)
+{
+    int n, best = 0;
+    float bv;
+    nerve__set_input_row(net, in, r);
+    nerve__forward(net, NULL, NULL);
+    bv = net->output_layer->neuron[0].output;
+    for (n = 1; n < net->output_layer->no_of_neurons; n++)
+        if (net->output_layer->neuron[n].output > bv)
+        { bv = net->output_layer->neuron[n].output; best = n; }
+    return best;
+}
+
+int net_classify(network_t *net, const float *input)
+{
+    nerve__rows_t in;
+    assert(net && input);
+    in = nerve__float_rows(input, 0);
+    return nerve__classify_row(net, &in, 0);
+}
+
+static int nerve__argmax(const float *v, int n)
+{
+    int i, best = 0;
+    for (i = 1; i < n; i++)
+        if (v[i] > v[best]) best = i;
+    return best;
+}
+
+/* Both metrics score the dataset in chunks through the batched forward pass,
+ * counting hits and, when `matrix` is given, (true, predicted) pairs. */
+#define NERVE__METRIC_CHUNK (4 * NERVENET_BATCH_TILE)
+
+static int nerve__predict_classes(network_t *net, const nerve__rows_t *in,
+                                  const float *targets,
+                                  int n_pairs, int n_outputs,
+                                  int n_classes, int *matrix)
+{
+    int i, k, m, pred, tc, ok = 0, n_net = net->output_layer->no_of_neurons;
+    nerve__rows_t chunk = *in;
+    float *out = (float *)malloc((size_t)NERVE__METRIC_CHUNK *
+                                 (size_t)n_net * sizeof(float));
+    for (i = 0; i < n_pairs; i += m)
+    {
+        m = n_pairs - i < NERVE__METRIC_CHUNK ? n_pairs - i : NERVE__METRIC_CHUNK;
+        chunk.data = (const char *)in->data + (size_t)i * in->stride *
+                     (in->type == NERVENET_DATA_U8  ? 1 :
+                      in->type == NERVENET_DATA_I16 ? sizeof(short)
+                                                    : sizeof(float));
+        if (out)
+            nerve__compute_batch(net, &chunk, m, out);
+        else
+            m = 1;   /* no room for a chunk: classify one sample at a time */
+        for (k = 0; k < m; k++)
+        {
+            pred = out ? nerve__argmax(out + (size_t)k * n_net, n_net)
+                       : nerve__classify_row(net, &chunk, 0);
+            tc   = nerve__argmax(targets + (size_t)(i + k) * n_outputs,
+                                 n_outputs);
+            if (pred == tc) ok++;
+            if (matrix && pred < n_classes && tc < n_classes)
+                matrix[tc * n_classes + pred]++;
+        }
+    }
+    free(out);
+    return ok;
+}
+
+float net_compute_accuracy(network_t *net,
+                           const float *inputs, const float *targets,
+                           int n_pairs, int n_inputs, int n_outputs)
+{
+    int ok;
+    nerve__rows_t in;
+    assert(net && inputs && targets && n_pairs > 0);
+    in = nerve__float_rows(inputs, n_inputs);
+    ok = nerve__predict_classes(net, &in, targets, n_pairs, n_outputs,
+                                0, NULL);
+    return (float)ok / (float)n_pairs;
+}
+
+float net_compute_accuracy_raw(network_t *net, const nerve_input_t *fmt,
+                               const void *inputs, const float *targets,
+                               int n_pairs, int n_inputs, int n_outputs)
+{
+    int ok;
+    nerve__rows_t in;
+    assert(net && fmt && inputs && targets && n_pairs > 0);
+    in = nerve__raw_rows(fmt, inputs, n_inputs);
+    ok = nerve__predict_classes(net, &in, targets, n_pairs, n_outputs,
+                                0, NULL);
+    return (float)ok / (float)n_pairs;
+}
+
+void net_confusion_matrix(network_t *net,
+                          const float *inputs, const float *targets,
+                          int n_pairs, int n_inputs, int n_outputs,
+                          int n_classes, int *matrix)
+{
+    nerve__rows_t in;
+    assert(net && inputs && targets && matrix && n_pairs > 0);
+    in = nerve__float_rows(inputs, n_inputs);
+    nerve__predict_classes(net, &in, targets, n_pairs, n_outputs,
+                           n_classes, matrix);
+}
+
+/* ── int8 quantization ────────────────────────────────────────────────────
+ * The same per-row symmetric scheme as studies/infer: the forward pass dots
+ * int8 weights against float activations in eight lanes and applies the row
+ * scale once at the end, so only a quarter of the weight bytes cross the
+ * memory bus. File layout (native endianness, like net_bsave): the magic
+ * "NRVQ", an int version, the layer count and sizes, the two activations,
+ * then per layer its scales, biases and int8 rows.
+ */
+#define NERVE__QMAGIC   "NRVQ"
+#define NERVE__QVERSION 1
+
+/* Read the header the int8, sparse and half-precision files share: magic,
+ * version, layer count, sizes and the two activations, each checked.
+ * Returns the malloc'ed sizes, or NULL on a short read or a bad field. */
+static int *nerve__read_header(FILE *f, const char *magic, int version,
+                               int *no_of_layers, int act[2])
+{
+    char m[4];
+    int l, hdr[2], *sizes;
+    if (fread(m, 1, 4, f) < 4 || memcmp(m, magic, 4) != 0 ||
+        fread(hdr, sizeof(int), 2, f) < 2 || hdr[0] != version ||
+        hdr[1] < 2 || hdr[1] > NERVENET_MAX_LAYERS)
+        return NULL;
+    sizes = (int *)malloc((size_t)hdr[1] * sizeof(int));
+    if (!sizes || fread(sizes, sizeof(int), (size_t)hdr[1], f) < (size_t)hdr[1])
+    { free(sizes); return NULL; }
+    for (l = 0; l < hdr[1]; l++)
+        if (sizes[l] <= 0 || sizes[l] > NERVENET_MAX_NEURONS)
+        { free(sizes); return NULL; }
+    if (fread(act, sizeof(int), 2, f) < 2 ||
+        act[0] < 0 || act[0] > NERVENET_ACTIVATION_SOFTMAX ||
+        act[1] < 0 || act[1] > NERVENET_ACTIVATION_SOFTMAX)
+    { free(sizes); return NULL; }
+    *no_of_layers = hdr[1];
+    return sizes;
+}
+
+static qnetwork_t *nerve__qalloc(int no_of_layers, const int *sizes)
+{
+    int l, rows = 0, width = 0;
+    size_t weights = 0;
+    qnetwork_t *q = (qnetwork_t *)calloc(1, sizeof(qnetwork_t));
+    if (!q) return NULL;
+    for (l = 0; l < no_of_layers; l++)
+    {
+        if (sizes[l] > width) width = sizes[l];
+        if (l == 0) continue;
+        rows    += sizes[l];
+        weights += (size_t)sizes[l] * (size_t)sizes[l - 1];
+    }
+    q->no_of_layers = no_of_layers;
+    q->sizes  = (int *)malloc((size_t)no_of_layers * sizeof(int));
+    q->weight = (signed char *)malloc(weights ? weights : 1);
+    q->scale  = (float *)malloc((size_t)rows * sizeof(float));
+    q->bias   = (float *)malloc((size_t)rows * sizeof(float));
+    q->act[0] = (float *)malloc(2 * (size_t)width * sizeof(float));
+    if (!q->sizes || !q->weight || !q->scale || !q->bias || !q->act[0])
+    { net_qfree(q); return NULL; }
+    q->act[1] = q->act[0] + width;
+    memcpy(q->sizes, sizes, (size_t)no_of_layers * sizeof(int));
+    return q;
+}
+
+void net_qfree(qnetwork_t *q)
+{
+    if (!q) return;
+    free(q->sizes); free(q->weight); free(q->scale); free(q->bias);
+    free(q->act[0]);
+    free(q);
+}
+
+qnetwork_t *net_quantize(const network_t *net)
+{
+    int l, u, j, nl, *sizes;
+    float m, a, r;
+    const float *row;
+    signed char *qw;
+    float *scale, *bias;
+    qnetwork_t *q;
+    assert(net != NULL);
+
+    sizes = (int *)malloc((size_t)net->no_of_layers * sizeof(int));
+    if (!sizes) return NULL;
+    for (l = 0; l < net->no_of_layers; l++)
+        sizes[l] = net->layer[l].no_of_neurons;
+    q = nerve__qalloc(net->no_of_layers, sizes);
+    free(sizes);
+    if (!q) return NULL;
+    q->activation        = net->activation;
+    q->output_activation = net->output_activation;
+
+    qw = q->weight; scale = q->scale; bias = q->bias;
+    for (l = 1; l < net->no_of_layers; l++)
+    {
+        nl = net->layer[l - 1].no_of_neurons;
+        for (u = 0; u < net->layer[l].no_of_neurons; u++)
+        {
+            row = net->layer[l].weight + (size_t)u * (nl + 1);
+            m = 0.0f;
+            for (j = 0; j < nl; j++)
+            {
+                a = (float)fabs((double)row[j]);
+                if (a > m) m = a;
+            }
+            *scale = m / 127.0f;
+            for (j = 0; j < nl; j++)
+            {
+                /* Round half away from zero; |r| <= 127 by construction. */
+                r = m > 0.0f ? row[j] / *scale : 0.0f;
+                r = r >= 0.0f ? (float)floor((double)r + 0.5)
+                              : -(float)floor(0.5 - (double)r);
+                if (r >  127.0f) r =  127.0f;
+                if (r < -127.0f) r = -127.0f;
+                *qw++ = (signed char)r;
+            }
+            /* The bias input is the lower layer's bias neuron (1, or 0
+             * after net_use_bias(net, 0)); fold it in now. */
+            *bias++ = row[nl] * net->layer[l - 1].neuron[nl].output;
+            scale++;
+        }
+    }
+    return q;
+}
+
+void net_qcompute(qnetwork_t *q, const float *input, float *output)
+{
+    int l, u, j, k, nl, nu;
+    float acc[8], *a, *c, *tmp;
+    const signed char *qw, *row;
+    const float *scale, *bias;
+    assert(q && input && output);
+
+    qw = q->weight; scale = q->scale; bias = q->bias;
+    a = q->act[0];
+    c = q->act[1];
+    memcpy(a, input, (size_t)q->sizes[0] * sizeof(float));
+    for (l = 1; l < q->no_of_layers; l++)
+    {
+        nl = q->sizes[l - 1];
+        nu = q->sizes[l];
+        for (u = 0; u < nu; u++)
+        {
+            row = qw + (size_t)u * nl;
+            for (k = 0; k < 8; k++) acc[k] = 0.0f;
+            for (j = 0; j + 8 <= nl; j += 8)
+                for (k = 0; k < 8; k++) acc[k] += (float)row[j + k] * a[j + k];
+            for (k = 0; j < nl; j++, k++) acc[k] += (float)row[j] * a[j];
+            c[u] = (((acc[0] + acc[1]) + (acc[2] + acc[3])) +
+                    ((acc[4] + acc[5]) + (acc[6] + acc[7]))) * scale[u]
+                 + bias[u];
+        }
+        if (l < q->no_of_layers - 1)
+            nerve__activate_rows(c, nu, q->activation);
+        else if (q->output_activation == NERVENET_ACTIVATION_SOFTMAX)
+            nerve__softmax_cols(c, nu, 1);
+        else
+            nerve__activate_rows(c, nu, q->output_activation);
+        qw += (size_t)nu * nl; scale += nu; bias += nu;
+        tmp = a; a = c; c = tmp;
+    }
+    memcpy(output, a, (size_t)q->sizes[q->no_of_layers - 1] * sizeof(float));
+}
+
+float net_qcompute_accuracy(qnetwork_t *q,
+                            const float *inputs, const float *targets,
+                            int n_pairs, int n_inputs, int n_outputs)
+{
+    int i, ok = 0, n_out;
+    float *out;
+    assert(q && inputs && targets && n_pairs > 0);
+    n_out = q->sizes[q->no_of_layers - 1];
+    out   = (float *)malloc((size_t)n_out * sizeof(float));
+    if (!out) return 0.0f;
+    for (i = 0; i < n_pairs; i++)
+    {
+        net_qcompute(q, inputs + (size_t)i * n_inputs, out);
+        if (nerve__argmax(out, n_out) ==
+            nerve__argmax(targets + (size_t)i * n_outputs, n_outputs)) ok++;
+    }
+    free(out);
+    return (float)ok / (float)n_pairs;
+}
+
+int net_qsave(const char *fn, const qnetwork_t *q)
+{
+    FILE *f;
+    int l, rows = 0, hdr[2];
+    size_t weights = 0;
+    assert(fn && q);
+    for (l = 1; l < q->no_of_layers; l++)
+    {
+        rows    += q->sizes[l];
+        weights += (size_t)q->sizes[l] * (size_t)q->sizes[l - 1];
+    }
+    f = fopen(fn, "wb");
+    if (!f) return EOF;
+    hdr[0] = NERVE__QVERSION;
+    hdr[1] = q->no_of_layers;
+    if (fwrite(NERVE__QMAGIC, 1, 4, f) < 4 ||
+        fwrite(hdr, sizeof(int), 2, f) < 2 ||
+        fwrite(q->sizes, sizeof(int), (size_t)q->no_of_layers, f) <
+            (size_t)q->no_of_layers ||
+        fwrite(&q->activation, sizeof(int), 1, f) < 1 ||
+        fwrite(&q->output_activation, sizeof(int), 1, f) < 1 ||
+        fwrite(q->scale, sizeof(float), (size_t)rows, f) < (size_t)rows ||
+        fwrite(q->bias, sizeof(float), (size_t)rows, f) < (size_t)rows ||
+        fwrite(q->weight, 1, weights, f) < weights)
+    { fclose(f); return -1; }
+    fclose(f);
+    return 0;
+}
+
+qnetwork_t *net_qload(const char *fn)
+{
+    FILE *f;
+    int l, rows = 0, layers, act[2], *sizes;
+    size_t weights = 0;
+    qnetwork_t *q = NULL;
+    assert(fn != NULL);
+    f = fopen(fn, "rb");
+    if (!f) return NULL;
+    sizes = nerve__read_header(f, NERVE__QMAGIC, NERVE__QVERSION,
+                               &layers, act);
+    if (!sizes) { fclose(f); return NULL; }
+    q = nerve__qalloc(layers, sizes);
+    free(sizes);
+    if (!q) { fclose(f); return NULL; }
+    q->activation        = act[0];
+    q->output_activation = act[1];
+    for (l = 1; l < q->no_of_layers; l++)
+    {
+        rows    += q->sizes[l];
+        weights += (size_t)q->sizes[l] * (size_t)q->sizes[l - 1];
+    }
+    if (fread(q->scale, sizeof(float), (size_t)rows, f) < (size_t)rows ||
+        fread(q->bias, sizeof(float), (size_t)rows, f) < (size_t)rows ||
+        fread(q->weight, 1, weights, f) < weights)
+    { net_qfree(q); q = NULL; }
+    fclose(f);
+    return q;
+}
+
+/* ── Pruning and sparse inference ─────────────────────────────────────────
+ * Magnitude pruning per layer: sort a copy of the layer's |w|, take the
+ * k-th smallest as the threshold and prune everything below it, then just
+ * enough of the ties to make k. Pruned weights are the smallest by
+ * construction, so pruning again to a higher sparsity keeps them.
+ *
+ * The CSR forward pass walks each row's non-zeros with four accumulators;
+ * the gather a[col[k]] is what replaces the dense row, so the work is
+ * proportional to the weights that are left. File layout (native
+ * endianness, like net_bsave): the magic "NRVS", an int version, the layer
+ * count and sizes, the two activations, the non-zero count, then row_ptr,
+ * the biases, the columns and the values.
+ */
+#define NERVE__SMAGIC   "NRVS"
+#define NERVE__SVERSION 1
+
+static int nerve__cmp_float(const void *a, const void *b)
+{
+    float x = *(const float *)a, y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+int net_prune(network_t *net, float sparsity)
+{
+    int l, u, j, nl, nu, n, k, below, ties, pruned = 0;
+    size_t off;
+    float *mag, t, a;
+    assert(net && sparsity >= 0.0f && sparsity < 1.0f);
+
+    if (!net->prune_mask)
+    {
+        net->prune_mask = (unsigned long *)calloc(
+            (size_t)(net->block_floats + 31) / 32, sizeof(unsigned long));
+        if (!net->prune_mask) return NERVENET_ERROR_MEMORY;
+    }
+    for (l = 1; l < net->no_of_layers; l++)
+    {
+        nl  = net->layer[l - 1].no_of_neurons;
+        nu  = net->layer[l].no_of_neurons;
+        n   = nu * nl;
+        k   = (int)(sparsity * (float)n);
+        off = (size_t)(net->layer[l].weight - net->weight_block);
+        if (k > 0)
+        {
+            mag = (float *)malloc((size_t)n * sizeof(float));
+            if (!mag) return NERVENET_ERROR_MEMORY;
+            for (u = 0; u < nu; u++)
+                for (j = 0; j < nl; j++)
+                    mag[u * nl + j] = (float)fabs(
+                        (double)net->layer[l].weight[(size_t)u * (nl + 1) + j]);
+            qsort(mag, (size_t)n, sizeof(float), nerve__cmp_float);
+            t = mag[k - 1];
+            for (below = 0; below < k && mag[below] < t; below++) ;
+            free(mag);
+
+            ties = k - below;
+            for (u = 0; u < nu; u++)
+                for (j = 0; j < nl; j++)
+                {
+                    size_t i = (size_t)u * (nl + 1) + j;
+                    a = (float)fabs((double)net->layer[l].weight[i]);
+                    if (a < t || (a == t && ties-- > 0))
+                        net->prune_mask[(off + i) >> 5] |=
+                            1UL << ((off + i) & 31);
+                }
+        }
+        for (u = 0; u < nu; u++)
+            for (j = 0; j < nl; j++)
+                if (NERVE__BIT(net->prune_mask,
+                                off + (size_t)u * (nl + 1) + j)) pruned++;
+    }
+    nerve__hold_pruned(net);
+    return pruned;
+}
+
+void net_set_prune_schedule(network_t *net, float sparsity, int epochs)
+{
+    assert(net && sparsity >= 0.0f && sparsity < 1.0f && epochs > 0);
+    net->prune_target = sparsity;
+    net->prune_epochs = epochs;
+    net->prune_epoch  = 0;
+}
+
+static snetwork_t *nerve__salloc(int no_of_layers, const int *sizes,
+                                 int nnz)
+{
+    int l, rows = 0, width = 0;
+    snetwork_t *s = (snetwork_t *)calloc(1, sizeof(snetwork_t));
+    if (!s) return NULL;
+    for (l = 0; l < no_of_layers; l++)
+    {
+        if (sizes[l] > width) width = sizes[l];
+        if (l > 0) rows += sizes[l];
+    }
+    s->no_of_layers = no_of_layers;
+    s->sizes   = (int *)malloc((size_t)no_of_layers * sizeof(int));
+    s->row_ptr = (int *)malloc((size_t)(rows + 1) * sizeof(int));
+    s->col     = (int *)malloc((size_t)(nnz ? nnz : 1) * sizeof(int));
+    s->val     = (float *)malloc((size_t)(nnz ? nnz : 1) * sizeof(float));
+    s->bias    = (float *)malloc((size_t)rows * sizeof(float));
+    s->act[0]  = (float *)malloc(2 * (size_t)width * sizeof(float));
+    if (!s->sizes || !s->row_ptr || !s->col || !s->val || !s->bias ||
+        !s->act[0])
+    { net_sfree(s); return NULL; }
+    s->act[1] = s->act[0] + width;
+    memcpy(s->sizes, sizes, (size_t)no_of_layers * sizeof(int));
+    return s;
+}
+
+void net_sfree(snetwork_t *s)
+{
+    if (!s) return;
+    free(s->sizes); free(s->row_ptr); free(s->col); free(s->val);
+    free(s->bias); free(s->act[0]);
+    free(s);
+}
+
+snetwork_t *net_sparsify(const network_t *net)
+{
+    int l, u, j, nl, r, nnz = 0, *sizes;
+    const float *row;
+    snetwork_t *s;
+    assert(net != NULL);
+
+    sizes = (int *)malloc((size_t)net->no_of_layers * sizeof(int));
+    if (!sizes) return NULL;
+    for (l = 0; l < net->no_of_layers; l++)
+        sizes[l] = net->layer[l].no_of_neurons;
+    for (l = 1; l < net->no_of_layers; l++)
+    {
+        nl = sizes[l - 1];
+        for (u = 0; u < sizes[l]; u++)
+        {
+            row = net->layer[l].weight + (size_t)u * (nl + 1);
+            for (j = 0; j < nl; j++) if (row[j] != 0.0f) nnz++;
+        }
+    }
+    s = nerve__salloc(net->no_of_layers, sizes, nnz);
+    free(sizes);
+    if (!s) return NULL;
+    s->activation        = net->activation;
+    s->output_activation = net->output_activation;
+
+    r = 0; nnz = 0;
+    s->row_ptr[0] = 0;
+    for (l = 1; l < net->no_of_layers; l++)
+    {
+        nl = s->sizes[l - 1];
+        for (u = 0; u < s->sizes[l]; u++, r++)
+        {
+            row = net->layer[l].weight + (size_t)u * (nl + 1);
+            for (j = 0; j < nl; j++)
+                if (row[j] != 0.0f)
+                {
+                    s->col[nnz] = j;
+                    s->val[nnz] = row[j];
+                    nnz++;
+                }
+            s->row_ptr[r + 1] = nnz;
+            /* Fold the bias neuron's output in, as net_quantize does. */
+            s->bias[r] = row[nl] * net->layer[l - 1].neuron[nl].output;
+        }
+    }
+    return s;
+}
+
+void net_scompute(snetwork_t *s, const float *input, float *output)
+{
+    int l, u, k, e, nu;
+    float a0, a1, a2, a3, *a, *c, *tmp;
+    const int *rp, *col;
+    const float *val, *bias;
+    assert(s && input && output);
+
+    col = s->col; val = s->val; bias = s->bias;
+    a  = s->act[0];
+    c  = s->act[1];
+    rp = s->row_ptr;
+    memcpy(a, input, (size_t)s->sizes[0] * sizeof(float));
+    for (l = 1; l < s->no_of_layers; l++)
+    {
+        nu = s->sizes[l];
+        for (u = 0; u < nu; u++)
+        {
+            a0 = a1 = a2 = a3 = 0.0f;
+            k = rp[u]; e = rp[u + 1];
+            for (; k + 4 <= e; k += 4)
+            {
+                a0 += val[k]     * a[col[k]];
+                a1 += val[k + 1] * a[col[k + 1]];
+                a2 += val[k + 2] * a[col[k + 2]];
+                a3 += val[k + 3] * a[col[k + 3]];
+            }
+            for (; k < e; k++) a0 += val[k] * a[col[k]];
+            c[u] = ((a0 + a1) + (a2 + a3)) + bias[u];
+        }
+        if (l < s->no_of_layers - 1)
+            nerve__activate_rows(c, nu, s->activation);
+        else if (s->output_activation == NERVENET_ACTIVATION_SOFTMAX)
+            nerve__softmax_cols(c, nu, 1);
+        else
+            nerve__activate_rows(c, nu, s->output_activation);
+        rp += nu; bias += nu;
+        tmp = a; a = c; c = tmp;
+    }
+    memcpy(output, a, (size_t)s->sizes[s->no_of_layers - 1] * sizeof(float));
+}
+
+float net_scompute_accuracy(snetwork_t *s,
+                            const float *inputs, const float *targets,
+                            int n_pairs, int n_inputs, int n_outputs)
+{
+    int i, ok = 0, n_out;
+    float *out;
+    assert(s && inputs && targets && n_pairs > 0);
+    n_out = s->sizes[s->no_of_layers - 1];
+    out   = (float *)malloc((size_t)n_out * sizeof(float));
+    if (!out) return 0.0f;
+    for (i = 0; i < n_pairs; i++)
+    {
+        net_scompute(s, inputs + (size_t)i * n_inputs, out);
+        if (nerve__argmax(out, n_out) ==
+            nerve__argmax(targets + (size_t)i * n_outputs, n_outputs)) ok++;
+    }
+    free(out);
+    return (float)ok / (float)n_pairs;
+}
+
+int net_ssave(const char *fn, const snetwork_t *s)
+{
+    FILE *f;
+    int l, rows = 0, hdr[2];
+    size_t nnz;
+    assert(fn && s);
+    for (l = 1; l < s->no_of_layers; l++) rows += s->sizes[l];
+    nnz = (size_t)s->row_ptr[rows];
+    f = fopen(fn, "wb");
+    if (!f) return EOF;
+    hdr[0] = NERVE__SVERSION;
+    hdr[1] = s->no_of_layers;
+    if (fwrite(NERVE__SMAGIC, 1, 4, f) < 4 ||
+        fwrite(hdr, sizeof(int), 2, f) < 2 ||
+        fwrite(s->sizes, sizeof(int), (size_t)s->no_of_layers, f) <
+            (size_t)s->no_of_layers ||
+        fwrite(&s->activation, sizeof(int), 1, f) < 1 ||
+        fwrite(&s->output_activation, sizeof(int), 1, f) < 1 ||
+        fwrite(&s->row_ptr[rows], sizeof(int), 1, f) < 1 ||
+        fwrite(s->row_ptr, sizeof(int), (size_t)rows + 1, f) <
+            (size_t)rows + 1 ||
+        fwrite(s->bias, sizeof(float), (size_t)rows, f) < (size_t)rows ||
+        fwrite(s->col, sizeof(int), nnz, f) < nnz ||
+        fwrite(s->val, sizeof(float), nnz, f) < nnz)
+    { fclose(f); return -1; }
+    fclose(f);
+    return 0;
+}
+
+snetwork_t *net_sload(const char *fn)
+{
+    FILE *f;
+    int l, r, k, rows = 0, layers, act[2], nnz, *sizes;
+    snetwork_t *s = NULL;
+    assert(fn != NULL);
+    f = fopen(fn, "rb");
+    if (!f) return NULL;
+    sizes = nerve__read_header(f, NERVE__SMAGIC, NERVE__SVERSION,
+                               &layers, act);
+    if (!sizes) { fclose(f); return NULL; }
+    if (fread(&nnz, sizeof(int), 1, f) < 1 || nnz < 0)
+    { free(sizes); fclose(f); return NULL; }
+    s = nerve__salloc(layers, sizes, nnz);
+    free(sizes);
+    if (!s) { fclose(f); return NULL; }
+    s->activation        = act[0];
+    s->output_activation = act[1];
+    for (l = 1; l < s->no_of_layers; l++) rows += s->sizes[l];
+    if (fread(s->row_ptr, sizeof(int), (size_t)rows + 1, f) <
+            (size_t)rows + 1 ||
+        fread(s->bias, sizeof(float), (size_t)rows, f) < (size_t)rows ||
+        fread(s->col, sizeof(int), (size_t)nnz, f) < (size_t)nnz ||
+        fread(s->val, sizeof(float), (size_t)nnz, f) < (size_t)nnz)
+    { net_sfree(s); fclose(f); return NULL; }
+    fclose(f);
+
+    /* A file that lies about its offsets or columns would send the forward
+     * pass outside its arrays: check every one before trusting it. */
+    r = 0;
+    if (s->row_ptr[0] != 0 || s->row_ptr[rows] != nnz)
+    { net_sfree(s); return NULL; }
+    for (l = 1; l < s->no_of_layers; l++)
+        for (k = 0; k < s->sizes[l]; k++, r++)
+        {
+            int e;
+            if (s->row_ptr[r + 1] < s->row_ptr[r])
+            { net_sfree(s); return NULL; }
+            for (e = s->row_ptr[r]; e < s->row_ptr[r + 1]; e++)
+                if (s->col[e] < 0 || s->col[e] >= s->sizes[l - 1])
+                { net_sfree(s); return NULL; }
+        }
+    return s;
+}
+
+/* ── Half-precision storage ───────────────────────────────────────────────
+ * The same shape as the int8 copy: each matrix row-major without its bias
+ * column, the bias folded and kept float. Each row is widened into a float
+ * scratch row and dotted with the portable or SIMD dot kernel, so the sum
+ * runs in float32 exactly as net_compute_batch's does. File layout (native
+ * endianness, like net_bsave): the magic "NRVH", an int version, the layer
+ * count and sizes, the two activations and the format, then the biases and
+ * the 16-bit weights.
+ */
+#define NERVE__HMAGIC   "NRVH"
+#define NERVE__HVERSION 1
+
+static hnetwork_t *nerve__halloc(int no_of_layers, const int *sizes)
+{
+    int l, rows = 0, width = 0;
+    size_t weights = 0;
+    hnetwork_t *h = (hnetwork_t *)calloc(1, sizeof(hnetwork_t));
+    if (!h) return NULL;
+    for (l = 0; l < no_of_layers; l++)
+    {
+        if (sizes[l] > width) width = sizes[l];
+        if (l == 0) continue;
+        rows    += sizes[l];
+        weights += (size_t)sizes[l] * (size_t)sizes[l - 1];
+    }
+    h->no_of_layers = no_of_layers;
+    h->sizes  = (int *)malloc((size_t)no_of_layers * sizeof(int));
+    h->weight = (unsigned short *)malloc((weights ? weights : 1) *
+                                         sizeof(unsigned short));
+    h->bias   = (float *)malloc((size_t)rows * sizeof(float));
+    h->act[0] = (float *)malloc(3 * (size_t)width * sizeof(float));
+    if (!h->sizes || !h->weight || !h->bias || !h->act[0])
+    { net_hfree(h); return NULL; }
+    h->act[1] = h->act[0] + width;
+    h->row    = h->act[1] + width;
+    memcpy(h->sizes, sizes, (size_t)no_of_layers * sizeof(int));
+    return h;
+}
+
+void net_hfree(hnetwork_t *h)
+{
+    if (!h) return;
+    free(h->sizes); free(h->weight); free(h->bias); free(h->act[0]);
+    free(h);
+}
+
+hnetwork_t *net_half(const network_t *net, nervenet_half_t format)
+{
+    int l, u, j, nl, *sizes;
+    const float *row;
+    unsigned short *hw;
+    float *bias;
+    hnetwork_t *h;
+    assert(net && (format == NERVENET_HALF_FP16 ||
+                   format == NERVENET_HALF_BF16));
+
+    sizes = (int *)malloc((size_t)net->no_of_layers * sizeof(int));
+    if (!sizes) return NULL;
+    for (l = 0; l < net->no_of_layers; l++)
+        sizes[l] = net->layer[l].no_of_neurons;
+    h = nerve__halloc(net->no_of_layers, sizes);
+    free(sizes);
+    if (!h) return NULL;
+    h->activation        = net->activation;
+    h->output_activation = net->output_activation;
+    h->format            = (int)format;
+
+    hw = h->weight; bias = h->bias;
+    for (l = 1; l < net->no_of_layers; l++)
+    {
+        nl = net->layer[l - 1].no_of_neurons;
+        for (u = 0; u < net->layer[l].no_of_neurons; u++)
+        {
+            row = net->layer[l].weight + (size_t)u * (nl + 1);
+            for (j = 0; j < nl; j++)
+                *hw++ = format == NERVENET_HALF_BF16
+                      ? nerve__f32_to_bf16(row[j]) : nerve__f32_to_f16(row[j]);
+            *bias++ = row[nl] * net->layer[l - 1].neuron[nl].output;
         }
+    }
+    return h;
 }
 
-/* ── Online training ──────────────────────────────────────────────────── */
-static void nerve__forward_train(network_t *net)
+void net_hcompute(hnetwork_t *h, const float *input, float *output)
 {
-    nerve__forward(net, 1);
+    int l, u, nl, nu;
+    float *a, *c, *tmp;
+    const unsigned short *hw = h->weight;
+    const float *bias = h->bias;
+    const nerve__kernels_t *k = nerve__kernels();
+    assert(h && input && output);
+
+    a = h->act[0];
+    c = h->act[1];
+    memcpy(a, input, (size_t)h->sizes[0] * sizeof(float));
+    for (l = 1; l < h->no_of_layers; l++)
+    {
+        nl = h->sizes[l - 1];
+        nu = h->sizes[l];
+        for (u = 0; u < nu; u++, hw += nl)
+        {
+            k->widen(h->row, hw, nl, h->format);
+            c[u] = k->dot(h->row, a, nl) + bias[u];
+        }
+        if (l < h->no_of_layers - 1)
+            nerve__activate_rows(c, nu, h->activation);
+        else if (h->output_activation == NERVENET_ACTIVATION_SOFTMAX)
+            nerve__softmax_cols(c, nu, 1);
+        else
+            nerve__activate_rows(c, nu, h->output_activation);
+        bias += nu;
+        tmp = a; a = c; c = tmp;
+    }
+    memcpy(output, a, (size_t)h->sizes[h->no_of_layers - 1] * sizeof(float));
 }
 
-void net_train(network_t *net)
+float net_hcompute_accuracy(hnetwork_t *h,
+                            const float *inputs, const float *targets,
+                            int n_pairs, int n_inputs, int n_outputs)
 {
-    assert(net != NULL);
-    nerve__backward(net);
-    nerve__adjust(net);
+    int i, ok = 0, n_out;
+    float *out;
+    assert(h && inputs && targets && n_pairs > 0);
+    n_out = h->sizes[h->no_of_layers - 1];
+    out   = (float *)malloc((size_t)n_out * sizeof(float));
+    if (!out) return 0.0f;
+    for (i = 0; i < n_pairs; i++)
+    {
+        net_hcompute(h, inputs + (size_t)i * n_inputs, out);
+        if (nerve__argmax(out, n_out) ==
+            nerve__argmax(targets + (size_t)i * n_outputs, n_outputs)) ok++;
+    }
+    free(out);
+    return (float)ok / (float)n_pairs;
 }
 
-/* ── Batch training ───────────────────────────────────────────────────── */
-static void nerve__accum_deltas(network_t *net)
+int net_hsave(const char *fn, const hnetwork_t *h)
 {
-    int l, nu, nl;
-    float err;
-    for (l = 1; l < net->no_of_layers; l++)
-        for (nu = 0; nu < net->layer[l].no_of_neurons; nu++)
-        {
-            err = net->layer[l].neuron[nu].error;
-            for (nl = 0; nl <= net->layer[l - 1].no_of_neurons; nl++)
-                net->layer[l].neuron[nu].delta[nl] +=
-                    net->learning_rate * err *
-                    net->layer[l - 1].neuron[nl].output;
-        }
+    FILE *f;
+    int l, rows = 0, hdr[2];
+    size_t weights = 0;
+    assert(fn && h);
+    for (l = 1; l < h->no_of_layers; l++)
+    {
+        rows    += h->sizes[l];
+        weights += (size_t)h->sizes[l] * (size_t)h->sizes[l - 1];
+    }
+    f = fopen(fn, "wb");
+    if (!f) return EOF;
+    hdr[0] = NERVE__HVERSION;
+    hdr[1] = h->no_of_layers;
+    if (fwrite(NERVE__HMAGIC, 1, 4, f) < 4 ||
+        fwrite(hdr, sizeof(int), 2, f) < 2 ||
+        fwrite(h->sizes, sizeof(int), (size_t)h->no_of_layers, f) <
+            (size_t)h->no_of_layers ||
+        fwrite(&h->activation, sizeof(int), 1, f) < 1 ||
+        fwrite(&h->output_activation, sizeof(int), 1, f) < 1 ||
+        fwrite(&h->format, sizeof(int), 1, f) < 1 ||
+        fwrite(h->bias, sizeof(float), (size_t)rows, f) < (size_t)rows ||
+        fwrite(h->weight, sizeof(unsigned short), weights, f) < weights)
+    { fclose(f); return -1; }
+    fclose(f);
+    return 0;
 }
 
-static void nerve__apply_deltas(network_t *net)
+hnetwork_t *net_hload(const char *fn)
 {
-    int l, nu, nl;
-    float d = (net->no_of_patterns > 0) ? (float)net->no_of_patterns : 1.0f;
-    for (l = 1; l < net->no_of_layers; l++)
-        for (nu = 0; nu < net->layer[l].no_of_neurons; nu++)
-            for (nl = 0; nl <= net->layer[l - 1].no_of_neurons; nl++)
-                net->layer[l].neuron[nu].weight[nl] +=
-                    net->layer[l].neuron[nu].delta[nl] / d;
+    FILE *f;
+    int l, rows = 0, layers, act[2], *sizes;
+    size_t weights = 0;
+    hnetwork_t *h = NULL;
+    assert(fn != NULL);
+    f = fopen(fn, "rb");
+    if (!f) return NULL;
+    sizes = nerve__read_header(f, NERVE__HMAGIC, NERVE__HVERSION,
+                               &layers, act);
+    if (!sizes) { fclose(f); return NULL; }
+    h = nerve__halloc(layers, sizes);
+    free(sizes);
+    if (!h) { fclose(f); return NULL; }
+    h->activation        = act[0];
+    h->output_activation = act[1];
+    for (l = 1; l < h->no_of_layers; l++)
+    {
+        rows    += h->sizes[l];
+        weights += (size_t)h->sizes[l] * (size_t)h->sizes[l - 1];
+    }
+    if (fread(&h->format, sizeof(int), 1, f) < 1 ||
+        (h->format != NERVENET_HALF_FP16 && h->format != NERVENET_HALF_BF16) ||
+        fread(h->bias, sizeof(float), (size_t)rows, f) < (size_t)rows ||
+        fread(h->weight, sizeof(unsigned short), weights, f) < weights)
+    { net_hfree(h); h = NULL; }
+    fclose(f);
+    return h;
 }
 
-void net_begin_batch(network_t *net)
-{ assert(net); net->no_of_patterns = 0; net_reset_deltas(net); }
-
-void net_train_batch(network_t *net)
-{ assert(net); net->no_of_patterns++; nerve__backward(net); nerve__accum_deltas(net); }
-
-void net_end_batch(network_t *net)
-{ assert(net); nerve__apply_deltas(net); }
+/* ── Neuroevolution population ──────────────────────────────────────────── */
+void net_population_free(net_population_t *pop)
+{
+    if (!pop) return;
+    free(pop->sizes);
+    nerve__aligned_free(pop->genome);
+    nerve__aligned_free(pop->spare);
+    nerve__aligned_free(pop->act[0]);
+    free(pop);
+}
 
-/* ── Mini-batch / shuffled-online epoch helper ────────────────────────── */
-/*
- * Shuffles the dataset, then iterates in mini-batches of `batch_size`.
- *
- * When optimizer == ADAM  (recommended): each sample triggers one Adam step
- *   — fully online with shuffle, which is the standard stochastic approach.
- *   The batch_size parameter is ignored in this mode.
- *
- * When optimizer == SGD: accumulates gradients over each mini-batch before
- *   applying the update (classic mini-batch SGD).
- *
- * Returns the mean MSE over all samples in the epoch.
- */
-float net_train_epoch(network_t *net,
-                      const float *inputs, const float *targets,
-                      int n_pairs, int n_inputs, int n_outputs,
-                      int batch_size)
+net_population_t *net_population_allocate(const network_t *net, int size)
 {
-    int *order, i, j, tmp, b_start, b_end, k;
-    float total_err = 0.0f;
-    int use_adam = (net->optimizer == NERVENET_OPTIMIZER_ADAM);
-    assert(net && inputs && targets && n_pairs > 0 && batch_size > 0);
+    int l, m, u, j, g, width, stride;
+    size_t floats;
+    float range;
+    net_population_t *pop;
+    assert(net && size > 0);
+
+    pop = (net_population_t *)calloc(1, sizeof(net_population_t));
+    if (!pop) return NULL;
+    pop->size              = size;
+    pop->genes             = net_get_no_of_weights(net);
+    pop->no_of_layers      = net->no_of_layers;
+    pop->activation        = net->activation;
+    pop->output_activation = net->output_activation;
+    pop->bias = net->layer[0].neuron[net->layer[0].no_of_neurons].output;
+    width  = nerve__widest_layer(net) + 1;
+    floats = (size_t)pop->genes * (size_t)size;
+    pop->sizes  = (int *)malloc((size_t)net->no_of_layers * sizeof(int));
+    pop->genome = (float *)nerve__aligned_alloc(floats * sizeof(float));
+    pop->spare  = (float *)nerve__aligned_alloc(floats * sizeof(float));
+    pop->act[0] = (float *)nerve__aligned_alloc(2 * (size_t)width * (size_t)size *
+                                                sizeof(float));
+    if (!pop->sizes || !pop->genome || !pop->spare || !pop->act[0])
+    { net_population_free(pop); return NULL; }
+    pop->act[1] = pop->act[0] + (size_t)width * (size_t)size;
+    for (l = 0; l < net->no_of_layers; l++)
+        pop->sizes[l] = net->layer[l].no_of_neurons;
 
-    order = (int *)malloc((size_t)n_pairs * sizeof(int));
-    for (i = 0; i < n_pairs; i++) order[i] = i;
-    for (i = n_pairs - 1; i > 0; i--)
-    {
-        j = (int)nerve_rand_below((unsigned long)(i + 1));
-        tmp = order[i]; order[i] = order[j]; order[j] = tmp;
-    }
+    /* Member by member, in net_initialize_xavier's draw order. */
+    for (m = 0; m < size; m++)
+        for (g = 0, l = 1; l < pop->no_of_layers; l++)
+        {
+            stride = pop->sizes[l - 1] + 1;
+            range  = (float)sqrt(6.0 / (double)(pop->sizes[l - 1] + pop->sizes[l]));
+            for (u = 0; u < pop->sizes[l]; u++)
+                for (j = 0; j < stride; j++, g++)
+                    pop->genome[(size_t)g * size + m] =
+                        2.0f * range * (nerve_rand_float() - 0.5f);
+        }
+    return pop;
+}
 
-    if (use_adam)
+/* Each layer is C = W . A with a different W per member, so the product
+ * runs member-wise: for every (row, input) pair, one elementwise
+ * multiply-add across the members. Both operands are contiguous rows of
+ * `size` floats, and the activations use the batched pass's feature-major
+ * layout, so its activation and softmax helpers apply unchanged. */
+void net_population_compute(net_population_t *pop,
+                            const float *inputs, float *outputs)
+{
+    int l, u, j, m, N, nl, nu, n_in, n_out;
+    float *a, *c, *tmp, *cu;
+    const float *w, *aj;
+    assert(pop && inputs && outputs);
+
+    N     = pop->size;
+    n_in  = pop->sizes[0];
+    n_out = pop->sizes[pop->no_of_layers - 1];
+    a = pop->act[0];
+    c = pop->act[1];
+    for (j = 0; j < n_in; j++)
+        for (m = 0; m < N; m++)
+            a[(size_t)j * N + m] = inputs[(size_t)m * n_in + j];
+    for (m = 0; m < N; m++) a[(size_t)n_in * N + m] = pop->bias;
+
+    w = pop->genome;
+    for (l = 1; l < pop->no_of_layers; l++)
     {
-        /* One Adam step per sample (stochastic Adam) */
-        for (k = 0; k < n_pairs; k++)
+        nl = pop->sizes[l - 1];
+        nu = pop->sizes[l];
+        for (u = 0; u < nu; u++)
         {
-            i = order[k];
-            nerve__set_input(net, inputs + i * n_inputs);
-            nerve__forward_train(net);
-            total_err += net_compute_output_error(net, targets + i * n_outputs);
-            nerve__backward(net);
-            nerve__adjust(net);
+            cu = c + (size_t)u * N;
+            memset(cu, 0, (size_t)N * sizeof(float));
+            for (j = 0; j <= nl; j++, w += N)
+                for (aj = a + (size_t)j * N, m = 0; m < N; m++)
+                    cu[m] += w[m] * aj[m];
         }
+        if (l < pop->no_of_layers - 1)
+            nerve__activate_rows(c, nu * N, pop->activation);
+        else if (pop->output_activation == NERVENET_ACTIVATION_SOFTMAX)
+            nerve__softmax_cols(c, nu, N);
+        else
+            nerve__activate_rows(c, nu * N, pop->output_activation);
+        for (m = 0; m < N; m++) c[(size_t)nu * N + m] = pop->bias;
+        tmp = a; a = c; c = tmp;
     }
-    else
+    for (u = 0; u < n_out; u++)
+        for (m = 0; m < N; m++)
+            outputs[(size_t)m * n_out + u] = a[(size_t)u * N + m];
+}
+
+void net_population_breed(net_population_t *pop,
+                          const int *parent_a, const int *parent_b,
+                          int n_elite, float rate, float sigma)
+{
+    net_population_breed_r(pop, parent_a, parent_b, n_elite, rate, sigma,
+                           &nerve__rng);
+}
+
+void net_population_breed_r(net_population_t *pop,
+                            const int *parent_a, const int *parent_b,
+                            int n_elite, float rate, float sigma,
+                            nerve_rng_t *rng)
+{
+    int g, m, N;
+    float *row, *next, *tmp, v;
+    double r, t;
+    assert(pop && parent_a && parent_b && rng);
+    assert(0 <= n_elite && n_elite <= pop->size);
+
+    N = pop->size;
+    for (g = 0; g < pop->genes; g++)
     {
-        /* Mini-batch SGD gradient accumulation */
-        for (b_start = 0; b_start < n_pairs; b_start += batch_size)
+        row  = pop->genome + (size_t)g * N;
+        next = pop->spare  + (size_t)g * N;
+        for (m = 0; m < n_elite; m++)
+            next[m] = row[parent_a[m]];
+        for (m = n_elite; m < N; m++)
         {
-            b_end = b_start + batch_size;
-            if (b_end > n_pairs) b_end = n_pairs;
-            net_begin_batch(net);
-            for (k = b_start; k < b_end; k++)
+            v = nerve_rng_float(rng) < 0.5f ? row[parent_a[m]] : row[parent_b[m]];
+            if (nerve_rng_float(rng) < rate)
             {
-                i = order[k];
-                nerve__set_input(net, inputs + i * n_inputs);
-                nerve__forward_train(net);
-                total_err += net_compute_output_error(net, targets + i * n_outputs);
-                net_train_batch(net);
+                /* Box-Muller; 1 - u keeps the log argument in (0, 1]. */
+                r = sqrt(-2.0 * log(1.0 - (double)nerve_rng_float(rng)));
+                t = 6.28318530717958647692 * (double)nerve_rng_float(rng);
+                v += sigma * (float)(r * cos(t));
             }
-            net_end_batch(net);
+            next[m] = v;
         }
     }
-
-    free(order);
-    return total_err / (float)n_pairs;
-}
-
-/* ── Metrics ──────────────────────────────────────────────────────────── */
-int net_classify(network_t *net, const float *input)
-{
-    int n, best = 0;
-    float bv;
-    assert(net && input);
-    net_compute(net, input, NULL);
-    bv = net->output_layer->neuron[0].output;
-    for (n = 1; n < net->output_layer->no_of_neurons; n++)
-        if (net->output_layer->neuron[n].output > bv)
-        { bv = net->output_layer->neuron[n].output; best = n; }
-    return best;
+    tmp = pop->genome; pop->genome = pop->spare; pop->spare = tmp;
 }
 
-float net_compute_accuracy(network_t *net,
-                           const float *inputs, const float *targets,
-                           int n_pairs, int n_inputs, int n_outputs)
+void net_population_get(const net_population_t *pop, int member,
+                        network_t *net)
 {
-    int i, n, ok = 0, pred, tc;
-    float bv;
-    assert(net && inputs && targets && n_pairs > 0);
-    for (i = 0; i < n_pairs; i++)
+    int l, i, n;
+    const float *g;
+    assert(pop && net && 0 <= member && member < pop->size);
+    assert(net_get_no_of_weights(net) == pop->genes);
+    g = pop->genome + member;
+    for (l = 1; l < net->no_of_layers; l++)
     {
-        pred = net_classify(net, inputs + i * n_inputs);
-        tc = 0; bv = targets[i * n_outputs];
-        for (n = 1; n < n_outputs; n++)
-            if (targets[i * n_outputs + n] > bv)
-            { bv = targets[i * n_outputs + n]; tc = n; }
-        if (pred == tc) ok++;
+        n = net->layer[l].no_of_neurons * (net->layer[l - 1].no_of_neurons + 1);
+        for (i = 0; i < n; i++, g += pop->size)
+            net->layer[l].weight[i] = *g;
     }
-    return (float)ok / (float)n_pairs;
+    net->activation        = pop->activation;
+    net->output_activation = pop->output_activation;
+    net_use_bias(net, pop->bias != 0.0f);
 }
 
-void net_confusion_matrix(network_t *net,
-                          const float *inputs, const float *targets,
-                          int n_pairs, int n_inputs, int n_outputs,
-                          int n_classes, int *matrix)
+void net_population_set(net_population_t *pop, int member,
+                        const network_t *net)
 {
-    int i, n, pred, tc;
-    float bv;
-    assert(net && inputs && targets && matrix && n_pairs > 0);
-    for (i = 0; i < n_pairs; i++)
+    int l, i, n;
+    float *g;
+    assert(pop && net && 0 <= member && member < pop->size);
+    assert(net_get_no_of_weights(net) == pop->genes);
+    g = pop->genome + member;
+    for (l = 1; l < net->no_of_layers; l++)
     {
-        pred = net_classify(net, inputs + i * n_inputs);
-        tc = 0; bv = targets[i * n_outputs];
-        for (n = 1; n < n_outputs; n++)
-            if (targets[i * n_outputs + n] > bv)
-            { bv = targets[i * n_outputs + n]; tc = n; }
-        if (pred < n_classes && tc < n_classes)
-            matrix[tc * n_classes + pred]++;
+        n = net->layer[l].no_of_neurons * (net->layer[l - 1].no_of_neurons + 1);
+        for (i = 0; i < n; i++, g += pop->size)
+            *g = net->layer[l].weight[i];
     }
 }
 
 /* ── Structural modification ──────────────────────────────────────────── */
 void net_jolt(network_t *net, float factor, float range)
 {
-    int l, nu, nl;
+    int l, i, n;
+    float *w;
     assert(net && factor >= 0.0f && range >= 0.0f);
     for (l = 1; l < net->no_of_layers; l++)
-        for (nu = 0; nu < net->layer[l].no_of_neurons; nu++)
-            for (nl = 0; nl <= net->layer[l - 1].no_of_neurons; nl++)
-            {
-                float *w = &net->layer[l].neuron[nu].weight[nl];
-                if (fabs(*w) < (double)range)
-                    *w = 2.0f * range * (nerve_rand_float() - 0.5f);
-                else
-                    *w *= 1.0f + 2.0f*factor*(nerve_rand_float() - 0.5f);
-            }
+    {
+        n = net->layer[l].no_of_neurons * (net->layer[l - 1].no_of_neurons + 1);
+        w = net->layer[l].weight;
+        for (i = 0; i < n; i++)
+        {
+            if (fabs(w[i]) < (double)range)
+                w[i] = 2.0f * range * (nerve_rand_float() - 0.5f);
+            else
+                w[i] *= 1.0f + 2.0f*factor*(nerve_rand_float() - 0.5f);
+        }
+    }
 }
 
-network_t *net_copy(const network_t *net)
+/* Copy everything but the topology from net into n2, which has the same
+ * layer sizes and so the same block layout: each block is a single copy.
+ * n2's Adam moments and prune mask are allocated the first time net has
+ * them, reused after that, and freed once net no longer has them, so a
+ * reused destination (a checkpoint slot) never carries stale state. n2 is
+ * never an arena network: its blocks are its own to free. */
+static int nerve__copy_state(network_t *n2, const network_t *net)
 {
-    int l, nu, nl, nw, *a;
-    network_t *n2;
-    assert(net != NULL);
-    a = (int *)calloc((size_t)net->no_of_layers, sizeof(int));
-    for (l = 0; l < net->no_of_layers; l++) a[l] = net->layer[l].no_of_neurons;
-    n2 = net_allocate_l(net->no_of_layers, a);
-    free(a);
-    if (!n2) return NULL;
-    for (l = 1; l < net->no_of_layers; l++)
-        for (nu = 0; nu < net->layer[l].no_of_neurons; nu++)
-            for (nl = 0; nl <= net->layer[l - 1].no_of_neurons; nl++)
-            {
-                n2->layer[l].neuron[nu].weight[nl] = net->layer[l].neuron[nu].weight[nl];
-                n2->layer[l].neuron[nu].delta[nl]  = net->layer[l].neuron[nu].delta[nl];
-            }
+    int l;
+    size_t bytes, mask;
+    assert(n2->block_floats == net->block_floats && !n2->arena_bytes);
+    bytes = (size_t)net->block_floats * sizeof(float);
+    memcpy(n2->weight_block, net->weight_block, bytes);
+    memcpy(n2->delta_block,  net->delta_block,  bytes);
+    for (l = 0; l < net->no_of_layers; l++)
+        n2->layer[l].neuron[n2->layer[l].no_of_neurons].output =
+            net->layer[l].neuron[net->layer[l].no_of_neurons].output;
     n2->momentum       = net->momentum;
     n2->learning_rate  = net->learning_rate;
     n2->global_error   = net->global_error;
@@ -1337,45 +6682,417 @@ network_t *net_copy(const network_t *net)
     n2->optimizer      = net->optimizer;
     n2->l2_lambda      = net->l2_lambda;
     n2->dropout_rate   = net->dropout_rate;
+    n2->threads        = net->threads;
     n2->adam_t         = net->adam_t;
     n2->adam_beta1     = net->adam_beta1;
     n2->adam_beta2     = net->adam_beta2;
     n2->adam_epsilon   = net->adam_epsilon;
+    n2->adam_beta1_t   = net->adam_beta1_t;
+    n2->adam_beta2_t   = net->adam_beta2_t;
+    n2->weight_decay   = net->weight_decay;
+    n2->prune_target   = net->prune_target;
+    n2->prune_epochs   = net->prune_epochs;
+    n2->prune_epoch    = net->prune_epoch;
+    if (net->prune_mask)
+    {
+        mask = (size_t)(net->block_floats + 31) / 32 * sizeof(unsigned long);
+        if (!n2->prune_mask) n2->prune_mask = (unsigned long *)malloc(mask);
+        if (!n2->prune_mask) return NERVENET_ERROR_MEMORY;
+        memcpy(n2->prune_mask, net->prune_mask, mask);
+    }
+    else
+    {
+        free(n2->prune_mask);
+        n2->prune_mask = NULL;
+    }
     if (net->adam_m && net->adam_v)
     {
-        nw = net_get_no_of_weights(net);
-        n2->adam_m = (float *)malloc((size_t)nw * sizeof(float));
-        n2->adam_v = (float *)malloc((size_t)nw * sizeof(float));
-        if (n2->adam_m) memcpy(n2->adam_m, net->adam_m, (size_t)nw * sizeof(float));
-        if (n2->adam_v) memcpy(n2->adam_v, net->adam_v, (size_t)nw * sizeof(float));
+        if (!n2->adam_m)
+        {
+            n2->adam_m = nerve__alloc_block(n2->block_floats);
+            n2->adam_v = nerve__alloc_block(n2->block_floats);
+            nerve__bind_blocks(n2);
+        }
+        if (!n2->adam_m || !n2->adam_v) return NERVENET_ERROR_MEMORY;
+        memcpy(n2->adam_m, net->adam_m, bytes);
+        memcpy(n2->adam_v, net->adam_v, bytes);
+    }
+    else if (n2->adam_m || n2->adam_v)
+    {
+        nerve__aligned_free(n2->adam_m); n2->adam_m = NULL;
+        nerve__aligned_free(n2->adam_v); n2->adam_v = NULL;
+        nerve__bind_blocks(n2);
     }
+    return NERVENET_SUCCESS;
+}
+
+network_t *net_copy(const network_t *net)
+{
+    int l, *a;
+    network_t *n2;
+    assert(net != NULL);
+    a = (int *)calloc((size_t)net->no_of_layers, sizeof(int));
+    if (!a) return NULL;
+    for (l = 0; l < net->no_of_layers; l++) a[l] = net->layer[l].no_of_neurons;
+    n2 = net_allocate_l(net->no_of_layers, a);
+    free(a);
+    if (!n2) return NULL;
+    if (nerve__copy_state(n2, net) != NERVENET_SUCCESS)
+    { net_free(n2); return NULL; }
     return n2;
 }
 
-void net_overwrite(network_t *dest, const network_t *src)
+/* dest takes a heap copy of src and frees its old blocks, so an arena
+ * dest, whose blocks are not its own to free, is refused. */
+int net_overwrite(network_t *dest, const network_t *src)
 {
     network_t *n2, *tmp;
     assert(dest && src);
-    n2  = net_copy(src);
+    if (dest->arena_bytes) return NERVENET_ERROR_INVALID_PARAM;
+    n2 = net_copy(src);
+    if (!n2) return NERVENET_ERROR_MEMORY;
     tmp = (network_t *)malloc(sizeof(network_t));
+    if (!tmp) { net_free(n2); return NERVENET_ERROR_MEMORY; }
     memcpy(tmp, n2,   sizeof(network_t));
     memcpy(n2,  dest, sizeof(network_t));
     memcpy(dest, tmp, sizeof(network_t));
     free(tmp);
     net_free(n2);
+    return NERVENET_SUCCESS;
+}
+
+/* ── Checkpoints ──────────────────────────────────────────────────────────
+ * After the NRVB image comes the training state:
+ *
+ *   "NRVT"  int hdr[NERVE__TH_INTS]  float cfg[NERVE__TC_FLOATS]
+ *   unsigned int rng[4]  delta_block  [adam_m adam_v]  [prune mask words]
+ *
+ * each block block_floats floats, the mask one 32-bit word per 32 floats.
+ */
+#define NERVE__TMAGIC   "NRVT"
+#define NERVE__TVERSION 1
+#define NERVE__T_ADAM   1
+#define NERVE__T_PRUNE  2
+
+enum
+{
+    NERVE__TH_VERSION, NERVE__TH_FLAGS, NERVE__TH_ADAM_T,
+    NERVE__TH_PRUNE_EPOCHS, NERVE__TH_PRUNE_EPOCH, NERVE__TH_INTS
+};
+enum
+{
+    NERVE__TC_BETA1_T, NERVE__TC_BETA2_T, NERVE__TC_PRUNE_TARGET,
+    NERVE__TC_FLOATS
+};
+
+static int nerve__fbprint_state(FILE *file, const network_t *net,
+                                const nerve_rng_t *rng)
+{
+    int i, hdr[NERVE__TH_INTS];
+    float cfg[NERVE__TC_FLOATS];
+    unsigned int w[4];
+    size_t n = (size_t)net->block_floats;
+    hdr[NERVE__TH_VERSION]      = NERVE__TVERSION;
+    hdr[NERVE__TH_FLAGS]        = (net->adam_m ? NERVE__T_ADAM : 0) |
+                                  (net->prune_mask ? NERVE__T_PRUNE : 0);
+    hdr[NERVE__TH_ADAM_T]       = net->adam_t;
+    hdr[NERVE__TH_PRUNE_EPOCHS] = net->prune_epochs;
+    hdr[NERVE__TH_PRUNE_EPOCH]  = net->prune_epoch;
+    cfg[NERVE__TC_BETA1_T]      = net->adam_beta1_t;
+    cfg[NERVE__TC_BETA2_T]      = net->adam_beta2_t;
+    cfg[NERVE__TC_PRUNE_TARGET] = net->prune_target;
+    for (i = 0; i < 4; i++) w[i] = (unsigned int)rng->s[i];
+    if (fwrite(NERVE__TMAGIC, 1, 4, file) < 4 ||
+        fwrite(hdr, sizeof(int), NERVE__TH_INTS, file) < NERVE__TH_INTS ||
+        fwrite(cfg, sizeof(float), NERVE__TC_FLOATS, file) < NERVE__TC_FLOATS ||
+        fwrite(w, sizeof(unsigned int), 4, file) < 4 ||
+        fwrite(net->delta_block, sizeof(float), n, file) < n)
+        return -1;
+    if (net->adam_m &&
+        (fwrite(net->adam_m, sizeof(float), n, file) < n ||
+         fwrite(net->adam_v, sizeof(float), n, file) < n))
+        return -1;
+    for (i = 0; net->prune_mask && i < (net->block_floats + 31) / 32; i++)
+    {
+        w[0] = (unsigned int)net->prune_mask[i];
+        if (fwrite(w, sizeof(unsigned int), 1, file) < 1) return -1;
+    }
+    return 0;
+}
+
+static int nerve__fbscan_state(FILE *file, network_t *net, nerve_rng_t *rng)
+{
+    int i, hdr[NERVE__TH_INTS];
+    float cfg[NERVE__TC_FLOATS];
+    unsigned int w[4];
+    char magic[4];
+    size_t n = (size_t)net->block_floats;
+    if (fread(magic, 1, 4, file) < 4 || memcmp(magic, NERVE__TMAGIC, 4) != 0 ||
+        fread(hdr, sizeof(int), NERVE__TH_INTS, file) < NERVE__TH_INTS ||
+        hdr[NERVE__TH_VERSION] != NERVE__TVERSION ||
+        fread(cfg, sizeof(float), NERVE__TC_FLOATS, file) < NERVE__TC_FLOATS ||
+        fread(w, sizeof(unsigned int), 4, file) < 4 ||
+        fread(net->delta_block, sizeof(float), n, file) < n)
+        return NERVENET_ERROR_CORRUPT;
+    for (i = 0; i < 4; i++) rng->s[i] = (unsigned long)w[i];
+    net->adam_t       = hdr[NERVE__TH_ADAM_T];
+    net->prune_epochs = hdr[NERVE__TH_PRUNE_EPOCHS];
+    net->prune_epoch  = hdr[NERVE__TH_PRUNE_EPOCH];
+    net->adam_beta1_t = cfg[NERVE__TC_BETA1_T];
+    net->adam_beta2_t = cfg[NERVE__TC_BETA2_T];
+    net->prune_target = cfg[NERVE__TC_PRUNE_TARGET];
+    if (hdr[NERVE__TH_FLAGS] & NERVE__T_ADAM)
+    {
+        if (!net->adam_m)
+        {
+            net->adam_m = nerve__alloc_block(net->block_floats);
+            net->adam_v = nerve__alloc_block(net->block_floats);
+            nerve__bind_blocks(net);
+        }
+        if (!net->adam_m || !net->adam_v) return NERVENET_ERROR_MEMORY;
+        if (fread(net->adam_m, sizeof(float), n, file) < n ||
+            fread(net->adam_v, sizeof(float), n, file) < n)
+            return NERVENET_ERROR_CORRUPT;
+    }
+    if (hdr[NERVE__TH_FLAGS] & NERVE__T_PRUNE)
+    {
+        net->prune_mask = (unsigned long *)malloc(
+            (size_t)(net->block_floats + 31) / 32 * sizeof(unsigned long));
+        if (!net->prune_mask) return NERVENET_ERROR_MEMORY;
+        for (i = 0; i < (net->block_floats + 31) / 32; i++)
+        {
+            if (fread(w, sizeof(unsigned int), 1, file) < 1)
+                return NERVENET_ERROR_CORRUPT;
+            net->prune_mask[i] = (unsigned long)w[0];
+        }
+    }
+    return NERVENET_SUCCESS;
+}
+
+network_t *net_checkpoint_load(const char *fn, nerve_rng_t *rng)
+{
+    FILE *f;
+    network_t *net;
+    assert(fn != NULL);
+    f = fopen(fn, "rb");
+    if (!f) return NULL;
+    net = net_fbscan(f);
+    if (net && nerve__fbscan_state(f, net, rng ? rng : &nerve__rng) < 0)
+    { net_free(net); net = NULL; }
+    fclose(f);
+    return net;
+}
+
+/* Two snapshot slots. The training thread fills the slot the writer is not
+ * on, then queues it as `pending`; the writer moves it to `writing`. */
+struct nerve_checkpoint_s
+{
+    char        *prefix;
+    char        *name, *tmp;    /* the writer's file-name scratch          */
+    int          keep;
+    long         seq;           /* number of the last snapshot taken       */
+    network_t   *snap[2];
+    nerve_rng_t  rng[2];
+    long         snap_seq[2];
+    int          status;        /* first failed write since the last wait  */
+#if defined(NERVE__THREADS)
+    int          pending, writing, quit;    /* slot indices, or -1         */
+    pthread_t       thread;
+    pthread_mutex_t mu;
+    pthread_cond_t  cv;
+#endif
+};
+
+/* Write slot i to "<prefix>-<n>.nrvb" through "<...>.tmp", then drop the
+ * checkpoint `keep` numbers back. */
+static int nerve__checkpoint_emit(nerve_checkpoint_t *ck, int i)
+{
+    FILE *f;
+    int r;
+    sprintf(ck->name, "%s-%06ld.nrvb", ck->prefix, ck->snap_seq[i]);
+    sprintf(ck->tmp, "%s.tmp", ck->name);
+    f = fopen(ck->tmp, "wb");
+    if (!f) return NERVENET_ERROR_IO;
+    r = net_fbprint(f, ck->snap[i]);
+    if (r == 0) r = nerve__fbprint_state(f, ck->snap[i], &ck->rng[i]);
+    if (fclose(f) != 0) r = -1;
+    if (r == 0 && rename(ck->tmp, ck->name) != 0) r = -1;
+    if (r != 0) { remove(ck->tmp); return NERVENET_ERROR_IO; }
+    if (ck->keep > 0 && ck->snap_seq[i] > ck->keep)
+    {
+        sprintf(ck->name, "%s-%06ld.nrvb", ck->prefix,
+                ck->snap_seq[i] - ck->keep);
+        remove(ck->name);
+    }
+    return NERVENET_SUCCESS;
+}
+
+#if defined(NERVE__THREADS)
+static void *nerve__checkpoint_main(void *arg)
+{
+    nerve_checkpoint_t *ck = (nerve_checkpoint_t *)arg;
+    int i, r;
+    pthread_mutex_lock(&ck->mu);
+    for (;;)
+    {
+        while (ck->pending < 0 && !ck->quit)
+            pthread_cond_wait(&ck->cv, &ck->mu);
+        if (ck->pending < 0) break;             /* quit, and nothing queued */
+        i = ck->writing = ck->pending;
+        ck->pending = -1;
+        pthread_cond_broadcast(&ck->cv);
+        pthread_mutex_unlock(&ck->mu);
+        r = nerve__checkpoint_emit(ck, i);
+        pthread_mutex_lock(&ck->mu);
+        if (r < 0 && ck->status == 0) ck->status = r;
+        ck->writing = -1;
+        pthread_cond_broadcast(&ck->cv);
+    }
+    pthread_mutex_unlock(&ck->mu);
+    return NULL;
+}
+#endif
+
+static void nerve__checkpoint_free(nerve_checkpoint_t *ck)
+{
+    if (ck->snap[0]) net_free(ck->snap[0]);
+    if (ck->snap[1]) net_free(ck->snap[1]);
+    free(ck->prefix); free(ck->name); free(ck->tmp);
+    free(ck);
+}
+
+nerve_checkpoint_t *net_checkpoint_open(const char *prefix, int keep)
+{
+    nerve_checkpoint_t *ck;
+    size_t len;
+    assert(prefix != NULL);
+    ck = (nerve_checkpoint_t *)calloc(1, sizeof(nerve_checkpoint_t));
+    if (!ck) return NULL;
+    len = strlen(prefix);
+    ck->prefix = (char *)malloc(len + 1);
+    ck->name   = (char *)malloc(len + 32);
+    ck->tmp    = (char *)malloc(len + 40);
+    if (!ck->prefix || !ck->name || !ck->tmp)
+    { nerve__checkpoint_free(ck); return NULL; }
+    memcpy(ck->prefix, prefix, len + 1);
+    ck->keep = keep;
+#if defined(NERVE__THREADS)
+    ck->pending = ck->writing = -1;
+    if (pthread_mutex_init(&ck->mu, NULL) != 0)
+    { nerve__checkpoint_free(ck); return NULL; }
+    if (pthread_cond_init(&ck->cv, NULL) != 0)
+    {
+        pthread_mutex_destroy(&ck->mu);
+        nerve__checkpoint_free(ck);
+        return NULL;
+    }
+    if (pthread_create(&ck->thread, NULL, nerve__checkpoint_main, ck) != 0)
+    {
+        pthread_cond_destroy(&ck->cv);
+        pthread_mutex_destroy(&ck->mu);
+        nerve__checkpoint_free(ck);
+        return NULL;
+    }
+#endif
+    return ck;
+}
+
+int net_checkpoint_save(nerve_checkpoint_t *ck, const network_t *net,
+                        const nerve_rng_t *rng)
+{
+    int i = 0, r;
+    assert(ck && net);
+#if defined(NERVE__THREADS)
+    pthread_mutex_lock(&ck->mu);
+    while (ck->pending >= 0) pthread_cond_wait(&ck->cv, &ck->mu);
+    i = ck->writing == 0;               /* the slot the writer is not on */
+    pthread_mutex_unlock(&ck->mu);
+#endif
+    if (ck->snap[i] && ck->snap[i]->block_floats != net->block_floats)
+    { net_free(ck->snap[i]); ck->snap[i] = NULL; }   /* net was resized */
+    if (!ck->snap[i])
+    {
+        ck->snap[i] = net_copy(net);
+        if (!ck->snap[i]) return NERVENET_ERROR_MEMORY;
+    }
+    r = nerve__copy_state(ck->snap[i], net);
+    if (r < 0) return r;
+    ck->rng[i]      = rng ? *rng : nerve__rng;
+    ck->snap_seq[i] = ++ck->seq;
+#if defined(NERVE__THREADS)
+    pthread_mutex_lock(&ck->mu);
+    ck->pending = i;
+    pthread_cond_broadcast(&ck->cv);
+    pthread_mutex_unlock(&ck->mu);
+#else
+    r = nerve__checkpoint_emit(ck, i);
+    if (r < 0) return r;
+#endif
+    return (int)ck->seq;
+}
+
+int net_checkpoint_wait(nerve_checkpoint_t *ck)
+{
+    int r;
+    assert(ck != NULL);
+#if defined(NERVE__THREADS)
+    pthread_mutex_lock(&ck->mu);
+    while (ck->pending >= 0 || ck->writing >= 0)
+        pthread_cond_wait(&ck->cv, &ck->mu);
+    r = ck->status;
+    ck->status = 0;
+    pthread_mutex_unlock(&ck->mu);
+#else
+    r = ck->status;
+    ck->status = 0;
+#endif
+    return r;
+}
+
+void net_checkpoint_close(nerve_checkpoint_t *ck)
+{
+    if (!ck) return;
+#if defined(NERVE__THREADS)
+    pthread_mutex_lock(&ck->mu);
+    ck->quit = 1;
+    pthread_cond_broadcast(&ck->cv);
+    pthread_mutex_unlock(&ck->mu);
+    pthread_join(ck->thread, NULL);
+    pthread_cond_destroy(&ck->cv);
+    pthread_mutex_destroy(&ck->mu);
+#endif
+    nerve__checkpoint_free(ck);
+}
+
+/* Swap the contents of a resized copy into the caller's network_t, then free
+ * the old contents through the copy's handle. */
+static int nerve__swap_resized(network_t *net, network_t *n2)
+{
+    network_t *tmp = (network_t *)malloc(sizeof(network_t));
+    if (!tmp) { net_free(n2); return NERVENET_ERROR_MEMORY; }
+    n2->momentum = net->momentum; n2->learning_rate = net->learning_rate;
+    n2->activation = net->activation; n2->optimizer = net->optimizer;
+    n2->output_activation = net->output_activation; n2->loss = net->loss;
+    n2->l2_lambda = net->l2_lambda; n2->weight_decay = net->weight_decay;
+    memcpy(tmp, n2, sizeof(network_t)); memcpy(n2, net, sizeof(network_t));
+    memcpy(net, tmp, sizeof(network_t)); free(tmp); net_free(n2);
+    return NERVENET_SUCCESS;
 }
 
-void net_add_neurons(network_t *net, int layer, int neuron, int number, float range)
+int net_add_neurons(network_t *net, int layer, int neuron, int number, float range)
 {
     int l, nu, nl, nnu, nnl, *a;
-    network_t *n2, *tmp;
+    network_t *n2;
     assert(net && 0 <= layer && layer < net->no_of_layers && number >= 0);
+    if (net->arena_bytes) return NERVENET_ERROR_INVALID_PARAM;
     if (neuron == -1) neuron = net->layer[layer].no_of_neurons;
     a = (int *)calloc((size_t)net->no_of_layers, sizeof(int));
+    if (!a) return NERVENET_ERROR_MEMORY;
     for (l = 0; l < net->no_of_layers; l++) a[l] = net->layer[l].no_of_neurons;
     a[layer] += number;
     n2 = net_allocate_l(net->no_of_layers, a);
     free(a);
+    if (!n2) return NERVENET_ERROR_MEMORY;
     net_randomize(n2, range);
     for (l = 1; l < net->no_of_layers; l++)
         for (nu = 0; nu < net->layer[l].no_of_neurons; nu++)
@@ -1388,24 +7105,21 @@ void net_add_neurons(network_t *net, int layer, int neuron, int number, float ra
                 n2->layer[l].neuron[nnu].delta[nnl]  = net->layer[l].neuron[nu].delta[nl];
             }
         }
-    n2->momentum = net->momentum; n2->learning_rate = net->learning_rate;
-    n2->activation = net->activation; n2->optimizer = net->optimizer;
-    n2->output_activation = net->output_activation; n2->loss = net->loss;
-    n2->l2_lambda = net->l2_lambda;
-    tmp = (network_t *)malloc(sizeof(network_t));
-    memcpy(tmp, n2, sizeof(network_t)); memcpy(n2, net, sizeof(network_t));
-    memcpy(net, tmp, sizeof(network_t)); free(tmp); net_free(n2);
+    return nerve__swap_resized(net, n2);
 }
 
-void net_remove_neurons(network_t *net, int layer, int neuron, int number)
+int net_remove_neurons(network_t *net, int layer, int neuron, int number)
 {
     int l, nu, nl, onu, onl, *a;
-    network_t *n2, *tmp;
+    network_t *n2;
     assert(net && 0 <= layer && layer < net->no_of_layers && number >= 0);
+    if (net->arena_bytes) return NERVENET_ERROR_INVALID_PARAM;
     a = (int *)calloc((size_t)net->no_of_layers, sizeof(int));
+    if (!a) return NERVENET_ERROR_MEMORY;
     for (l = 0; l < net->no_of_layers; l++) a[l] = net->layer[l].no_of_neurons;
     a[layer] -= number;
     n2 = net_allocate_l(net->no_of_layers, a); free(a);
+    if (!n2) return NERVENET_ERROR_MEMORY;
     for (l = 1; l < n2->no_of_layers; l++)
         for (nu = 0; nu < n2->layer[l].no_of_neurons; nu++)
         {
@@ -1417,30 +7131,22 @@ void net_remove_neurons(network_t *net, int layer, int neuron, int number)
                 n2->layer[l].neuron[nu].delta[nl]  = net->layer[l].neuron[onu].delta[onl];
             }
         }
-    n2->momentum = net->momentum; n2->learning_rate = net->learning_rate;
-    n2->activation = net->activation; n2->optimizer = net->optimizer;
-    n2->output_activation = net->output_activation; n2->loss = net->loss;
-    n2->l2_lambda = net->l2_lambda;
-    tmp = (network_t *)malloc(sizeof(network_t));
-    memcpy(tmp, n2, sizeof(network_t)); memcpy(n2, net, sizeof(network_t));
-    memcpy(net, tmp, sizeof(network_t)); free(tmp); net_free(n2);
+    return nerve__swap_resized(net, n2);
 }
 
 /* ── Utility ──────────────────────────────────────────────────────────── */
 int net_validate(const network_t *net)
 {
-    int l, n;
+    int l;
     if (!net || net->no_of_layers < 2 || !net->layer) return 0;
     if (net->learning_rate <= 0.0f || net->momentum < 0.0f) return 0;
     for (l = 0; l < net->no_of_layers; l++)
     {
         if (net->layer[l].no_of_neurons <= 0 || !net->layer[l].neuron) return 0;
-        if (l > 0)
-            for (n = 0; n < net->layer[l].no_of_neurons; n++)
-                if (!net->layer[l].neuron[n].weight ||
-                    !net->layer[l].neuron[n].delta) return 0;
+        if (l > 0 && (!net->layer[l].weight || !net->layer[l].delta)) return 0;
     }
-    if (net->optimizer == NERVENET_OPTIMIZER_ADAM &&
+    if (!net->weight_block || !net->delta_block) return 0;
+    if (nerve__is_adam(net) &&
         (!net->adam_m || !net->adam_v)) return 0;
     return 1;
 }
@@ -36,7 +36,7 @@
  *  If the network reproduces these signs — and ranks φ/β/c as the heavy
  *  hitters — it captured the physics, not just the table.
  *
- *  Build:  gcc -O2 slope_sensitivity.c -o slope_sensitivity -lm
+ *  Build:  gcc -O2 slope_sensitivity.c -o slope_sensitivity -lm -pthread
  *  Run:    ./slope_sensitivity         (run from this folder)
  */
 
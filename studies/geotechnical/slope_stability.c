@@ -45,7 +45,7 @@
  *
  *  Architecture: 10-24-16-1 | Adam + Tanh | Xavier init | L2 = 1e-4
  *
- *  Build:  gcc -O2 slope_stability.c -o slope_stability -lm
+ *  Build:  gcc -O2 slope_stability.c -o slope_stability -lm -pthread
  *  Run:    ./slope_stability            (expects dataset/ alongside the exe)
  */
 
@@ -25,7 +25,7 @@
  *   float W1[n_hid*n_in], b1[n_hid]     (hidden, ReLU)
  *   float W2[n_out*n_hid], b2[n_out]    (output, softmax)
  *
- * Build:  gcc -O3 -march=native export_mlp.c -o export_mlp -lm
+ * Build:  gcc -O3 -march=native export_mlp.c -o export_mlp -lm -pthread
  * Run:    ./export_mlp [epochs] [train_cap]
  */
 #define NERVE_IMPLEMENTATION
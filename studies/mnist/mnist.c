@@ -24,7 +24,9 @@
  *
  *  This trains a plain fully-connected Nerve network — no convolutions, no
  *  external math libraries, no Python — straight on the raw pixels and
- *  reports test accuracy on the 10 000-image hold-out set.
+ *  reports test accuracy on the 10 000-image hold-out set. The training
+ *  images are mapped in place and read as bytes (nerve_idx_map and
+ *  net_train_epoch_raw): 47 MB of pixels instead of a 188 MB float copy.
  *
  *  Architecture: 784-128-10 | Adam + ReLU(He) | softmax + cross-entropy
  *
@@ -32,7 +34,7 @@
  *     train-images-idx3-ubyte   train-labels-idx1-ubyte
  *     t10k-images-idx3-ubyte    t10k-labels-idx1-ubyte
  *
- *  Build:  gcc -O2 mnist.c -o mnist -lm
+ *  Build:  gcc -O2 mnist.c -o mnist -lm -pthread
  *  Run:    ./mnist [epochs] [train_cap]      (defaults: 10  60000)
  */
 
@@ -135,7 +137,10 @@ int main(int argc, char **argv)
 {
     int   epochs    = (argc > 1) ? atoi(argv[1]) : 10;
     int   train_cap = (argc > 2) ? atoi(argv[2]) : 60000;
-    float *Xtr, *Ytr, *Xte, *Yte;
+    float *Ytr, *Xte, *Yte;
+    float px_scale[IMG];
+    nerve_input_t px = { NERVENET_DATA_U8, px_scale, NULL };
+    nerve_idx_t Xtr;
     int   *lbl_te;
     int   ntr, nte, e;
 
@@ -144,8 +149,13 @@ int main(int argc, char **argv)
            HID);
 
     /* 1. Load --------------------------------------------------------------*/
-    ntr = load_images(TRAIN_IMG, &Xtr);
+    if (nerve_idx_map(&Xtr, TRAIN_IMG) != NERVENET_SUCCESS || Xtr.width != IMG) {
+        fprintf(stderr, "ERROR: cannot map %s\n", TRAIN_IMG); return 1;
+    }
+    for (e = 0; e < IMG; e++) px_scale[e] = 1.0f / 255.0f;
+    ntr = Xtr.count;
     nte = load_images(TEST_IMG,  &Xte);
+    if (nte <= 0) return 1;
     if (load_labels(TRAIN_LBL, &Ytr, NULL) != ntr) return 1;
     lbl_te = (int *)malloc((size_t)nte * sizeof(int));
     if (load_labels(TEST_LBL,  &Yte, lbl_te) != nte) return 1;
@@ -169,7 +179,8 @@ int main(int argc, char **argv)
     printf("  --------------------------------------\n");
     for (e = 1; e <= epochs; e++) {
         clock_t t0 = clock();
-        float loss = net_train_epoch(net, Xtr, Ytr, ntr, IMG, CLS, 1);
+        float loss = net_train_epoch_raw(net, &px, Xtr.data, Ytr, ntr,
+                                         IMG, CLS, 1);
         float acc = net_compute_accuracy(net, Xte, Yte, nte, IMG, CLS);
         double secs = (double)(clock() - t0) / CLOCKS_PER_SEC;
         printf("  %4d     %.5f     %6.2f%%   %5.1f\n",
@@ -201,6 +212,7 @@ int main(int argc, char **argv)
     }
 
     net_free(net);
-    free(Xtr); free(Ytr); free(Xte); free(Yte); free(lbl_te);
+    nerve_idx_unmap(&Xtr);
+    free(Ytr); free(Xte); free(Yte); free(lbl_te);
     return 0;
 }
@@ -21,7 +21,7 @@
  * Zero dependencies, one translation unit, no test framework: it compiles
  * with the same one-line gcc invocation as everything else in this project.
  *
- *     gcc -O2 -std=c99 -Wall -Wextra tests/test_nerve.c -o test_nerve -lm
+ *     gcc -O2 -std=c99 -Wall -Wextra tests/test_nerve.c -o test_nerve -lm -pthread
  *     ./test_nerve
  *
  * Exit status is 0 only when every check passes, so CI can gate on it.
@@ -123,6 +123,19 @@ static uint32_t ref_next(void)
     return result;
 }
 
+static void ref_jump(const uint32_t *poly)
+{
+    uint32_t t[4] = { 0, 0, 0, 0 };
+    int i, b, k;
+    for (i = 0; i < 4; i++)
+        for (b = 0; b < 32; b++) {
+            if (poly[i] & (UINT32_C(1) << b))
+                for (k = 0; k < 4; k++) t[k] ^= ref_s[k];
+            ref_next();
+        }
+    for (k = 0; k < 4; k++) ref_s[k] = t[k];
+}
+
 /* ── RNG tests ──────────────────────────────────────────────────────────── */
 
 static void test_rng_matches_reference(void)
@@ -301,6 +314,97 @@ static void test_rand_below_is_unbiased(void)
            chi2);
 }
 
+static void test_rng_streams_and_jumps(void)
+{
+    /* Blackman & Vigna's constants for xoshiro128. A jump is a polynomial in
+     * the one-step map, so it must also commute with a single step — which a
+     * masking slip on LP64 would break even where the constants are right. */
+    static const uint32_t jump[4] = {
+        0x8764000Bu, 0xF542D2D3u, 0x6FA035C3u, 0x77F2DB5Bu
+    };
+    static const uint32_t long_jump[4] = {
+        0xB523952Eu, 0x0B6F099Fu, 0xCCF5A0EFu, 0x1C580662u
+    };
+    nerve_rng_t r, a, b;
+    int i, k, same = 1;
+
+    begin("rng streams match the global one and jump ahead");
+    nerve_rng_seed(&r, 42);
+    nerve_seed(42);
+    for (i = 0; i < 1000; i++)
+        if (nerve_rng_u32(&r) != nerve_rand_u32()) same = 0;
+    CHECK(same, "a stream seeded 42 diverged from the global generator");
+
+    nerve_rng_seed(&r, 7);
+    ref_seed(7);
+    nerve_rng_jump(&r);
+    ref_jump(jump);
+    for (i = 0; i < 100; i++)
+        CHECK(nerve_rng_u32(&r) == (unsigned long)ref_next(),
+              "draw %d after jump differs from the reference", i);
+    nerve_rng_long_jump(&r);
+    ref_jump(long_jump);
+    for (i = 0; i < 100; i++)
+        CHECK(nerve_rng_u32(&r) == (unsigned long)ref_next(),
+              "draw %d after long jump differs from the reference", i);
+
+    nerve_rng_seed(&a, 99);
+    b = a;
+    nerve_rng_jump(&a);   nerve_rng_u32(&a);
+    nerve_rng_u32(&b);    nerve_rng_jump(&b);
+    for (k = 0; k < 4; k++)
+        CHECK(a.s[k] == b.s[k], "jump does not commute with a step (word %d)", k);
+    CHECK(nerve_rng_u32(&a) != nerve_rng_u32(&r),
+          "jumped streams from different seeds coincide");
+    end();
+}
+
+static void test_explicit_streams_leave_global_alone(void)
+{
+    /* The _r calls must be the plain calls on a stream of their own: same
+     * weights as the global path from the same seed, and the global stream
+     * untouched by them. */
+    enum { N = 64, NI = 4, NO = 2 };
+    float x[N * NI], t[N * NO];
+    network_t *a, *b;
+    nerve_rng_t r;
+    unsigned long before, after;
+    int i, same = 1;
+
+    begin("explicit-stream init and training match the global");
+    nerve_seed(3);
+    for (i = 0; i < N * NI; i++) x[i] = 2.0f * nerve_rand_float() - 1.0f;
+    for (i = 0; i < N * NO; i++) t[i] = (i % NO == (i / NO) % NO) ? 1.0f : 0.0f;
+
+    a = net_allocate(4, NI, 12, 8, NO);
+    b = net_allocate(4, NI, 12, 8, NO);
+    net_set_dropout(a, 0.25f);
+    net_set_dropout(b, 0.25f);
+    net_set_threads(a, 2);
+    net_set_threads(b, 2);
+
+    nerve_seed(11);
+    net_initialize_xavier(a);
+    net_train_epoch(a, x, t, N, NI, NO, 16);
+    net_train_epoch(a, x, t, N, NI, NO, 16);
+
+    nerve_seed(500);
+    before = nerve_rand_u32();
+    nerve_seed(500);
+    nerve_rng_seed(&r, 11);
+    net_initialize_xavier_r(b, &r);
+    net_train_epoch_r(b, x, t, N, NI, NO, 16, &r);
+    net_train_epoch_r(b, x, t, N, NI, NO, 16, &r);
+    after = nerve_rand_u32();
+
+    for (i = 0; i < a->block_floats; i++)
+        if (a->weight_block[i] != b->weight_block[i]) same = 0;
+    CHECK(same, "stream training differs from the global path");
+    CHECK(before == after, "the _r calls drew from the global generator");
+    net_free(a); net_free(b);
+    end();
+}
+
 /* ── Initialisation tests ───────────────────────────────────────────────── */
 
 static int weights_equal(const network_t *a, const network_t *b)
@@ -554,6 +658,616 @@ static void test_softmax_is_a_distribution(void)
     end();
 }
 
+/* The bounds documented for NERVENET_FAST_MATH; libm meets them too, so
+ * this runs in both builds. A one-layer net with weight 1 and bias 0 puts
+ * its output activation straight onto the input. */
+static void test_activations_within_bounds(void)
+{
+    enum { K = 10 };
+    static const int acts[2] = { NERVENET_ACTIVATION_SIGMOID,
+                                 NERVENET_ACTIVATION_TANH };
+    static const double tol[2] = { 1e-7, 2e-7 };
+    network_t *net;
+    float x, y, in[K], out[K];
+    double ref[K], sum, err, worst = 0.0;
+    int a, i, k;
+
+    begin("activations and softmax stay within their bounds");
+    for (a = 0; a < 2; a++) {
+        net = net_allocate(2, 1, 1);
+        net_set_output_activation(net, (nervenet_activation_t)acts[a]);
+        net_set_weight(net, 1, 0, 0, 1.0f);
+        net_set_weight(net, 1, 1, 0, 0.0f);         /* bias column */
+        err = 0.0;
+        for (i = -40000; i <= 40000; i++) {
+            x = (float)i * 5e-4f;
+            net_compute(net, &x, &y);
+            ref[0] = acts[a] == NERVENET_ACTIVATION_TANH
+                   ? tanh((double)x) : 1.0 / (1.0 + exp(-(double)x));
+            if (fabs((double)y - ref[0]) > err) err = fabs((double)y - ref[0]);
+        }
+        CHECK(err <= tol[a], "activation %d is off by %g", acts[a], err);
+        net_free(net);
+    }
+
+    nerve_seed(20);
+    net = net_allocate(2, K, K);
+    net_set_classification(net);
+    for (k = 0; k < K; k++) {
+        for (i = 0; i < K; i++) net_set_weight(net, 1, i, k, i == k ? 1.0f : 0.0f);
+        net_set_weight(net, 1, K, k, 0.0f);
+    }
+    for (i = 0; i < 10000; i++) {
+        for (k = 0; k < K; k++) in[k] = 40.0f * nerve_rand_float() - 20.0f;
+        net_compute(net, in, out);
+        for (sum = 0.0, k = 0; k < K; k++) sum += ref[k] = exp((double)in[k]);
+        for (k = 0; k < K; k++)
+            if (fabs((double)out[k] - ref[k] / sum) > worst)
+                worst = fabs((double)out[k] - ref[k] / sum);
+    }
+    CHECK(worst <= 4e-7, "softmax is off by %g", worst);
+    net_free(net);
+    end();
+}
+
+static void test_batch_matches_single(void)
+{
+    /* 150 samples: two full tiles plus a ragged one; 13 and 5 hidden rows
+     * exercise the 4-row blocking remainder. */
+    enum { N = 150, NI = 7, NO = 5 };
+    static float x[N * NI], t[N * NO], batch[N * NO];
+    static const int acts[4] = {
+        NERVENET_ACTIVATION_SIGMOID, NERVENET_ACTIVATION_TANH,
+        NERVENET_ACTIVATION_RELU,    NERVENET_ACTIVATION_LEAKY_RELU
+    };
+    network_t *net;
+    float single[NO], worst = 0.0f, acc;
+    int i, j, k, ok;
+
+    begin("net_compute_batch matches net_compute per sample");
+    nerve_seed(8);
+    for (i = 0; i < N * NI; i++) x[i] = 2.0f * nerve_rand_float() - 1.0f;
+    for (i = 0; i < N; i++)
+        for (j = 0; j < NO; j++) t[i * NO + j] = (j == i % NO) ? 1.0f : 0.0f;
+
+    for (k = 0; k < 5; k++) {
+        net = net_allocate(4, NI, 13, 6, NO);
+        net_initialize_xavier(net);
+        if (k < 4) net_set_activation(net, (nervenet_activation_t)acts[k]);
+        else       net_set_classification(net);
+        net_compute_batch(net, x, N, batch);
+        for (i = 0; i < N; i++) {
+            net_compute(net, x + i * NI, single);
+            for (j = 0; j < NO; j++) {
+                float d = (float)fabs((double)(single[j] - batch[i * NO + j]));
+                if (d > worst) worst = d;
+            }
+        }
+        ok = 0;
+        for (i = 0; i < N; i++)
+            if (net_classify(net, x + i * NI) == i % NO) ok++;
+        acc = net_compute_accuracy(net, x, t, N, NI, NO);
+        CHECK(acc == (float)ok / (float)N,
+              "batched accuracy %f differs from per-sample %f",
+              (double)acc, (double)ok / N);
+        net_free(net);
+    }
+    CHECK(worst <= 1e-6f, "batched output differs by %g", (double)worst);
+    end();
+}
+
+static void test_sparse_matches_dense(void)
+{
+    /* Plain SGD without momentum or L2 leaves untouched columns alone even
+     * on the dense path, so there the lazy sparse update must agree with
+     * it exactly, up to summation order. */
+    enum { NI = 40, NO = 3, NNZ = 4 };
+    const int   idx[NNZ] = { 3, 17, 18, 39 };
+    const float val[NNZ] = { 0.5f, -1.25f, 2.0f, 0.75f };
+    const float t[NO]    = { 0.0f, 1.0f, 0.0f };
+    float x[NI], ya[NO], yb[NO], worst = 0.0f, d;
+    network_t *a, *b;
+    int i, k, pass;
+
+    begin("sparse inputs match the dense path");
+    for (i = 0; i < NI; i++) x[i] = 0.0f;
+    for (k = 0; k < NNZ; k++) x[idx[k]] = val[k];
+
+    nerve_seed(15);
+    a = net_allocate(4, NI, 12, 6, NO);
+    net_set_activation(a, NERVENET_ACTIVATION_TANH);
+    net_set_classification(a);
+    net_set_optimizer(a, NERVENET_OPTIMIZER_SGD);
+    net_set_momentum(a, 0.0f);
+    net_set_learning_rate(a, 0.1f);
+    net_initialize_xavier(a);
+    b = net_copy(a);
+
+    net_compute(a, x, ya);
+    net_compute_sparse(b, idx, val, NNZ, yb);
+    for (k = 0; k < NO; k++)
+        CHECK(close_enough(ya[k], yb[k], 1e-6f),
+              "output %d: dense %f, sparse %f", k, (double)ya[k], (double)yb[k]);
+
+    for (pass = 0; pass < 2; pass++) {
+        if (pass) { net_begin_batch(a); net_begin_batch(b); }
+        for (i = 0; i < 3; i++) {
+            net_compute(a, x, NULL);
+            net_compute_output_error(a, t);
+            net_compute_sparse(b, idx, val, NNZ, NULL);
+            net_compute_output_error(b, t);
+            if (pass) { net_train_batch(a); net_train_batch_sparse(b, idx, val, NNZ); }
+            else      { net_train(a);       net_train_sparse(b, idx, val, NNZ); }
+        }
+        if (pass) { net_end_batch(a); net_end_batch(b); }
+    }
+    for (i = 0; i < a->block_floats; i++) {
+        d = (float)fabs((double)(a->weight_block[i] - b->weight_block[i]));
+        if (d > worst) worst = d;
+    }
+    CHECK(worst <= 1e-5f, "sparse training drifts from dense by %g",
+          (double)worst);
+
+    /* val = NULL: a one-hot input. */
+    for (i = 0; i < NI; i++) x[i] = 0.0f;
+    x[idx[2]] = 1.0f;
+    net_compute(a, x, ya);
+    net_compute_sparse(a, idx + 2, NULL, 1, yb);
+    for (k = 0; k < NO; k++)
+        CHECK(close_enough(ya[k], yb[k], 1e-6f),
+              "one-hot output %d: dense %f, sparse %f",
+              k, (double)ya[k], (double)yb[k]);
+    net_free(a); net_free(b);
+    end();
+}
+
+static void test_context_matches_compute(void)
+{
+    /* Four contexts share one network, each taking every fourth sample — on
+     * four threads when the suite is built with -fopenmp. The network's own
+     * neurons must not be written to. */
+    enum { N = 64, NI = 9, NO = 4, NCTX = 4 };
+    static const int acts[4] = {
+        NERVENET_ACTIVATION_SIGMOID, NERVENET_ACTIVATION_TANH,
+        NERVENET_ACTIVATION_RELU,    NERVENET_ACTIVATION_LEAKY_RELU
+    };
+    static float x[N * NI], got[N * NO], want[N * NO];
+    net_context_t *ctx[NCTX];
+    network_t *net;
+    int i, k, c, mismatches = 0, touched = 0;
+
+    begin("net_compute_ctx matches net_compute, net untouched");
+    nerve_seed(31);
+    for (i = 0; i < N * NI; i++) x[i] = 2.0f * nerve_rand_float() - 1.0f;
+
+    for (k = 0; k < 5; k++) {
+        net = net_allocate(4, NI, 17, 6, NO);
+        net_set_activation(net, (nervenet_activation_t)acts[k % 4]);
+        if (k == 4) net_set_classification(net);
+        net_initialize_xavier(net);
+        for (i = 0; i < N; i++) net_compute(net, x + i * NI, want + i * NO);
+        net->layer[1].neuron[0].output = -42.0f;
+        for (c = 0; c < NCTX; c++) ctx[c] = net_context_allocate(net);
+
+#if defined(_OPENMP)
+#       pragma omp parallel for num_threads(NCTX)
+#endif
+        for (c = 0; c < NCTX; c++) {
+            int s;
+            for (s = c; s < N; s += NCTX)
+                net_compute_ctx(net, ctx[c], x + s * NI, got + s * NO);
+        }
+
+        /* Exact with the portable kernels; FMA ones round differently. */
+        for (i = 0; i < N * NO; i++)
+            if (net_simd_level() <= NERVENET_SIMD_SSE2
+                    ? got[i] != want[i] : !close_enough(got[i], want[i], 1e-6f))
+                mismatches++;
+        if (net->layer[1].neuron[0].output != -42.0f) touched++;
+        for (c = 0; c < NCTX; c++) net_context_free(ctx[c]);
+        net_free(net);
+    }
+    CHECK(mismatches == 0, "%d outputs differ from net_compute", mismatches);
+    CHECK(touched == 0, "net_compute_ctx wrote into the network");
+    end();
+}
+
+static void test_simd_kernels_match_reference(void)
+{
+    /* Every level the build and the CPU offer, from the widest down; a
+     * capped level must never report anything wider than the cap. */
+    int cap, level;
+
+    begin("every SIMD level matches the portable kernels");
+    for (cap = NERVENET_SIMD_AVX512; cap >= NERVENET_SIMD_SCALAR; cap--) {
+        level = net_simd_set_level((nervenet_simd_t)cap);
+        CHECK(level <= cap, "cap %d selected level %d", cap, level);
+        CHECK(net_simd_self_check(), "level %d kernels disagree", level);
+    }
+    net_simd_set_level(NERVENET_SIMD_AVX512);
+    end();
+}
+
+static void test_batched_sgd_matches_accumulation(void)
+{
+    /* Full-batch SGD: the shuffle cannot change the summed gradient, so the
+     * batched trainer must land where per-sample accumulation does. 300
+     * samples also make the trainer walk more than one tile. */
+    enum { N = 300, NI = 5, NO = 3 };
+    static float x[N * NI], t[N * NO];
+    static const int losses[2] = { NERVENET_LOSS_MSE, NERVENET_LOSS_CROSS_ENTROPY };
+    network_t *a, *b;
+    float worst = 0.0f, ea, eb = 0.0f;
+    int i, k, l, nu, nl;
+
+    begin("batched SGD trainer matches per-sample sums");
+    nerve_seed(13);
+    for (i = 0; i < N * NI; i++) x[i] = 2.0f * nerve_rand_float() - 1.0f;
+    for (i = 0; i < N * NO; i++) t[i] = (i % NO == (i / NO) % NO) ? 1.0f : 0.0f;
+
+    for (k = 0; k < 2; k++) {
+        a = net_allocate(4, NI, 9, 6, NO);
+        net_set_activation(a, NERVENET_ACTIVATION_TANH);
+        if (losses[k] == NERVENET_LOSS_CROSS_ENTROPY) net_set_classification(a);
+        net_set_learning_rate(a, 0.1f);
+        net_initialize_xavier(a);
+        b = net_copy(a);
+
+        ea = net_train_epoch(a, x, t, N, NI, NO, N);
+        net_begin_batch(b);
+        eb = 0.0f;
+        for (i = 0; i < N; i++) {
+            net_compute(b, x + i * NI, NULL);
+            eb += net_compute_output_error(b, t + i * NO);
+            net_train_batch(b);
+        }
+        net_end_batch(b);
+        CHECK(close_enough(ea, eb / N, 1e-4f),
+              "epoch loss %f, per-sample loss %f", (double)ea, (double)eb / N);
+
+        for (l = 1; l < a->no_of_layers; l++)
+            for (nu = 0; nu < a->layer[l].no_of_neurons; nu++)
+                for (nl = 0; nl <= a->layer[l - 1].no_of_neurons; nl++) {
+                    float d = (float)fabs((double)(a->layer[l].neuron[nu].weight[nl] -
+                                                   b->layer[l].neuron[nu].weight[nl]));
+                    if (d > worst) worst = d;
+                }
+        net_free(a); net_free(b);
+    }
+    CHECK(worst <= 1e-5f, "weights differ by %g after one batch",
+          (double)worst);
+    end();
+}
+
+static void test_batched_adam_matches_reference(void)
+{
+    /* Three full-batch epochs must take exactly three Adam steps on the
+     * batch-mean gradient. The reference reads that gradient from an SGD
+     * copy at lr = 1, whose delta block is left holding it, and applies the
+     * textbook update with pow() bias correction in double. */
+    enum { N = 120, NI = 4, NO = 3, STEPS = 3 };
+    static float x[N * NI], t[N * NO];
+    static const int opts[2] = { NERVENET_OPTIMIZER_ADAM, NERVENET_OPTIMIZER_ADAMW };
+    network_t *a, *r, *g;
+    double *m, *v, mh, vh, gi;
+    float lr = 0.01f, worst = 0.0f, d;
+    int i, k, step;
+
+    begin("batched Adam/AdamW take one textbook step per batch");
+    nerve_seed(21);
+    for (i = 0; i < N * NI; i++) x[i] = 2.0f * nerve_rand_float() - 1.0f;
+    for (i = 0; i < N * NO; i++) t[i] = (i % NO == (i / NO) % NO) ? 1.0f : 0.0f;
+
+    for (k = 0; k < 2; k++) {
+        a = net_allocate(3, NI, 7, NO);
+        net_set_activation(a, NERVENET_ACTIVATION_TANH);
+        net_set_classification(a);
+        net_set_optimizer(a, (nervenet_optimizer_t)opts[k]);
+        net_set_learning_rate(a, lr);
+        net_initialize_xavier(a);
+        r = net_copy(a);
+        m = (double *)calloc((size_t)a->block_floats, sizeof(double));
+        v = (double *)calloc((size_t)a->block_floats, sizeof(double));
+
+        for (step = 1; step <= STEPS; step++) {
+            g = net_copy(r);
+            net_set_optimizer(g, NERVENET_OPTIMIZER_SGD);
+            net_set_learning_rate(g, 1.0f);
+            net_train_epoch(g, x, t, N, NI, NO, N);
+            for (i = 0; i < a->block_floats; i++) {
+                gi   = (double)g->delta_block[i];
+                m[i] = 0.9 * m[i] + 0.1 * gi;
+                v[i] = 0.999 * v[i] + 0.001 * gi * gi;
+                mh   = m[i] / (1.0 - pow(0.9, step));
+                vh   = v[i] / (1.0 - pow(0.999, step));
+                r->weight_block[i] += (float)(lr * mh / (sqrt(vh) + 1e-8)
+                                    - lr * r->weight_decay * r->weight_block[i]);
+            }
+            net_free(g);
+            net_train_epoch(a, x, t, N, NI, NO, N);
+        }
+        CHECK(a->adam_t == STEPS, "optimizer %d took %d steps, expected %d",
+              opts[k], a->adam_t, STEPS);
+        for (i = 0; i < a->block_floats; i++) {
+            d = (float)fabs((double)(a->weight_block[i] - r->weight_block[i]));
+            if (d > worst) worst = d;
+        }
+        free(m); free(v);
+        net_free(a); net_free(r);
+    }
+    CHECK(worst <= 1e-5f, "weights differ from the reference by %g",
+          (double)worst);
+    end();
+}
+
+static void test_sharded_training_is_deterministic(void)
+{
+    /* Shards change only the summation order, so three of them must agree
+     * with one to rounding; and with dropout drawing from per-shard streams,
+     * the same seed and shard count must reproduce the weights bit for bit. */
+    enum { N = 200, NI = 6, NO = 3 };
+    static float x[N * NI], t[N * NO];
+    network_t *a, *b, *c;
+    float worst = 0.0f, d;
+    int i, e, same = 1;
+
+    begin("sharded epochs are deterministic per thread count");
+    nerve_seed(5);
+    for (i = 0; i < N * NI; i++) x[i] = 2.0f * nerve_rand_float() - 1.0f;
+    for (i = 0; i < N * NO; i++) t[i] = (i % NO == (i / NO) % NO) ? 1.0f : 0.0f;
+
+    a = net_allocate(4, NI, 16, 8, NO);
+    net_set_activation(a, NERVENET_ACTIVATION_RELU);
+    net_set_classification(a);
+    net_set_learning_rate(a, 0.05f);
+    net_initialize_he(a);
+    b = net_copy(a);
+    net_set_threads(b, 3);
+    for (e = 0; e < 3; e++) {
+        nerve_seed(100 + e); net_train_epoch(a, x, t, N, NI, NO, 32);
+        nerve_seed(100 + e); net_train_epoch(b, x, t, N, NI, NO, 32);
+    }
+    for (i = 0; i < a->block_floats; i++) {
+        d = (float)fabs((double)(a->weight_block[i] - b->weight_block[i]));
+        if (d > worst) worst = d;
+    }
+    CHECK(worst <= 1e-5f, "3 shards drift from 1 by %g", (double)worst);
+
+    net_set_optimizer(b, NERVENET_OPTIMIZER_ADAM);
+    net_set_dropout(b, 0.3f);
+    c = net_copy(b);
+    for (e = 0; e < 3; e++) {
+        nerve_seed(7 + e); net_train_epoch(b, x, t, N, NI, NO, 50);
+        nerve_seed(7 + e); net_train_epoch(c, x, t, N, NI, NO, 50);
+    }
+    for (i = 0; i < b->block_floats; i++)
+        if (b->weight_block[i] != c->weight_block[i]) same = 0;
+    CHECK(same, "same seed and shard count gave different weights");
+    net_free(a); net_free(b); net_free(c);
+    end();
+}
+
+static void test_dropout_is_inverted(void)
+{
+    /* 1-H-1 ReLU net, every hidden unit outputs exactly 1 and the output
+     * averages them. Inverted dropout scales survivors by 1/(1-p), so the
+     * training-time output still averages 1 and the MSE loss against 0 is
+     * ~0.5; plain dropout would give ~0.125. Inference must see exactly 1.
+     * A tile shares one mask, so H is wide enough to keep its mean tight. */
+    enum { H = 16384, N = 64 };
+    float x[N], t[N], y, loss;
+    network_t *net;
+    int i;
+
+    begin("dropout scales survivors so inference needs none");
+    nerve_seed(21);
+    net = net_allocate(3, 1, H, 1);
+    net_set_activation(net, NERVENET_ACTIVATION_RELU);
+    net_set_output_activation(net, NERVENET_ACTIVATION_RELU);
+    net_set_optimizer(net, NERVENET_OPTIMIZER_SGD);
+    net_set_learning_rate(net, 0.0f);
+    net_set_momentum(net, 0.0f);
+    for (i = 0; i < H; i++) {
+        net->layer[1].weight[i * 2 + 0] = 1.0f;
+        net->layer[1].weight[i * 2 + 1] = 0.0f;
+        net->layer[2].weight[i] = 1.0f / (float)H;
+    }
+    net->layer[2].weight[H] = 0.0f;
+    for (i = 0; i < N; i++) { x[i] = 1.0f; t[i] = 0.0f; }
+
+    net_set_dropout(net, 0.5f);
+    loss = net_train_epoch(net, x, t, N, 1, 1, 16);
+    CHECK(close_enough(loss, 0.5f, 0.01f),
+          "training loss %f, expected ~0.5 with inverted scaling",
+          (double)loss);
+    net_compute(net, x, &y);
+    CHECK(close_enough(y, 1.0f, 1e-5f), "inference output %f, expected 1",
+          (double)y);
+
+    net_set_dropout(net, 0.25f);
+    loss = net_train_epoch(net, x, t, N, 1, 1, 16);
+    CHECK(close_enough(loss, 0.5f, 0.01f),
+          "training loss %f at p=0.25, expected ~0.5", (double)loss);
+    net_free(net);
+    end();
+}
+
+static void test_dropout_mask_is_per_tile(void)
+{
+    /* One batch is one tile and shares one mask: a dropped hidden unit has
+     * no error for any sample, so its incoming weights come back untouched.
+     * Per-sample masks would leave next to none of them. */
+    enum { NI = 2, H = 256, N = 16 };
+    float x[N * NI], t[N], before[H * (NI + 1)];
+    network_t *net;
+    int i, j, same, idle = 0;
+
+    begin("a tile's dropped units get no update");
+    nerve_seed(17);
+    net = net_allocate(3, NI, H, 1);
+    net_set_optimizer(net, NERVENET_OPTIMIZER_SGD);
+    net_set_momentum(net, 0.0f);
+    net_set_dropout(net, 0.5f);
+    for (i = 0; i < N * NI; i++) x[i] = 0.25f + 0.5f * nerve_rand_float();
+    for (i = 0; i < N; i++) t[i] = (float)(i & 1);
+    memcpy(before, net->layer[1].weight, sizeof(before));
+    net_train_epoch(net, x, t, N, NI, 1, N);
+    for (i = 0; i < H; i++) {
+        same = 0;
+        for (j = 0; j <= NI; j++)
+            same += net->layer[1].weight[i * (NI + 1) + j] ==
+                    before[i * (NI + 1) + j];
+        if (same == NI + 1) idle++;
+    }
+    CHECK(idle > H / 2 - H / 8 && idle < H / 2 + H / 8,
+          "%d of %d units left untouched at p=0.5", idle, H);
+    net_free(net);
+    end();
+}
+
+static void test_profile_counts_the_work(void)
+{
+    /* Built with NERVENET_PROFILE, the counters follow the shapes exactly
+     * and sharded batches fold into the network's totals; without it there
+     * are none. */
+    enum { N = 96, NI = 4, NH = 8, NO = 3 };
+    static float x[N * NI], t[N * NO], out[N * NO];
+    network_t *net;
+    const nerve_stats_t *st;
+    int i;
+
+    begin("profiling counters follow the shapes");
+    nerve_seed(11);
+    for (i = 0; i < N * NI; i++) x[i] = 2.0f * nerve_rand_float() - 1.0f;
+    for (i = 0; i < N * NO; i++) t[i] = (i % NO == (i / NO) % NO) ? 1.0f : 0.0f;
+    net = net_allocate(3, NI, NH, NO);
+    st  = net_get_stats(net);
+#if defined(NERVENET_PROFILE)
+    {
+        const double m1 = NH * (NI + 1), m2 = NO * (NH + 1);
+        char buf[4096];
+        size_t len;
+        int lines = 0, open = 0, shut = 0;
+        net_context_t *ctx;
+        FILE *f;
+
+        CHECK(st && st->no_of_layers == 3, "no counters on a fresh network");
+        net_compute(net, x, out);
+        CHECK(st->layer[1].forward.calls == 1 &&
+              st->layer[2].forward.calls == 1, "net_compute not counted");
+        CHECK(st->layer[1].forward.flops == 2.0 * m1 &&
+              st->layer[2].forward.bytes == 4.0 * (m2 + NH + 1 + NO),
+              "one-sample forward counted %g flops, %g bytes",
+              st->layer[1].forward.flops, st->layer[2].forward.bytes);
+
+        net_reset_stats(net);
+        CHECK(st->layer[1].forward.calls == 0, "net_reset_stats kept counts");
+        ctx = net_context_allocate(net);
+        if (ctx) net_compute_ctx(net, ctx, x, out);
+        net_context_free(ctx);
+        CHECK(st->layer[1].forward.calls == 0 && st->activation.calls == 0,
+              "net_compute_ctx counted into a network it may share");
+        net_compute_batch(net, x, N, out);  /* tiles of 64 and 32 */
+        CHECK(st->layer[1].forward.calls == 2 && st->activation.calls == 4,
+              "batched forward: %lu tiles, %lu activation sweeps",
+              st->layer[1].forward.calls, st->activation.calls);
+        CHECK(st->layer[2].forward.flops == 2.0 * m2 * N,
+              "batched forward counted %g flops", st->layer[2].forward.flops);
+
+        net_reset_stats(net);
+        net_train_epoch(net, x, t, N, NI, NO, 32);
+        for (i = 1; i < 3; i++)
+            CHECK(st->layer[i].forward.calls == 3 &&
+                  st->layer[i].backward.calls == 3 &&
+                  st->layer[i].update.calls == 3,
+                  "layer %d: %lu/%lu/%lu passes for three batches", i,
+                  st->layer[i].forward.calls, st->layer[i].backward.calls,
+                  st->layer[i].update.calls);
+        CHECK(st->layer[1].backward.flops == 2.0 * m1 * N &&
+              st->layer[2].backward.flops == 4.0 * m2 * N,
+              "backward counted %g and %g flops",
+              st->layer[1].backward.flops, st->layer[2].backward.flops);
+        CHECK(st->optimizer.calls == 3 && st->rng.calls == 1 &&
+              st->rng.flops == N - 1, "optimizer %lu, rng %lu (%g draws)",
+              st->optimizer.calls, st->rng.calls, st->rng.flops);
+
+        /* Two shards of 16 samples per batch, each drawing one mask of NH
+         * units for its tile: two bit-sliced draws at p = 0.25. */
+        net_reset_stats(net);
+        net_set_threads(net, 2);
+        net_set_dropout(net, 0.25f);
+        net_train_epoch(net, x, t, N, NI, NO, 32);
+        CHECK(st->layer[1].forward.calls == 6 &&
+              st->layer[1].forward.flops == 2.0 * m1 * N,
+              "shards not folded in: %lu passes, %g flops",
+              st->layer[1].forward.calls, st->layer[1].forward.flops);
+        CHECK(st->rng.calls == 7 && st->rng.flops == N - 1 + 6 * 2,
+              "rng %lu calls, %g draws", st->rng.calls, st->rng.flops);
+        for (i = 1; i < 3; i++)
+            CHECK(st->layer[i].forward.seconds >= 0.0 &&
+                  st->layer[i].backward.seconds >= 0.0 &&
+                  st->layer[i].update.seconds >= 0.0, "negative time");
+
+        /* Online: errors reach back to layer 2 only, both layers step. */
+        net_reset_stats(net);
+        net_set_dropout(net, 0.0f);
+        net_compute(net, x, out);
+        net_compute_output_error(net, t);
+        net_train(net);
+        CHECK(st->layer[1].backward.calls == 0 &&
+              st->layer[2].backward.calls == 1 &&
+              st->layer[1].update.calls == 1 &&
+              st->layer[2].update.calls == 1 && st->optimizer.calls == 1,
+              "net_train counted %lu/%lu backward, %lu optimizer",
+              st->layer[1].backward.calls, st->layer[2].backward.calls,
+              st->optimizer.calls);
+
+        f = tmpfile();
+        CHECK(net_fprint_stats(f, net, NERVENET_STATS_CSV) == NERVENET_SUCCESS,
+              "CSV dump failed");
+        rewind(f);
+        len = fread(buf, 1, sizeof(buf) - 1, f);
+        buf[len] = '\0';
+        for (i = 0; i < (int)len; i++) lines += buf[i] == '\n';
+        CHECK(lines == 1 + 3 * 2 + 3 &&
+              strncmp(buf, "counter,layer,calls,seconds,flops,bytes\n", 40) == 0,
+              "CSV has %d lines:\n%s", lines, buf);
+        CHECK(strstr(buf, "\nupdate,2,1,") && strstr(buf, "\noptimizer,,1,"),
+              "CSV rows missing:\n%s", buf);
+        fclose(f);
+
+        f = tmpfile();
+        CHECK(net_fprint_stats(f, net, NERVENET_STATS_JSON) == NERVENET_SUCCESS,
+              "JSON dump failed");
+        rewind(f);
+        len = fread(buf, 1, sizeof(buf) - 1, f);
+        buf[len] = '\0';
+        for (i = 0; i < (int)len; i++) {
+            open += buf[i] == '{' || buf[i] == '[';
+            shut += buf[i] == '}' || buf[i] == ']';
+        }
+        CHECK(open == shut && open == 2 + 2 * 4 + 3 &&
+              strstr(buf, "\"layer\": 2, \"inputs\": 8, \"neurons\": 3") &&
+              strstr(buf, "\"optimizer\": {\"calls\": 1,"),
+              "JSON malformed:\n%s", buf);
+        fclose(f);
+        CHECK(net_fprint_stats(NULL, net, NERVENET_STATS_CSV) ==
+                  NERVENET_ERROR_NULL_POINTER &&
+              net_fprint_stats(stdout, net, (nervenet_stats_format_t)7) ==
+                  NERVENET_ERROR_INVALID_PARAM, "bad arguments accepted");
+    }
+#else
+    net_train_epoch(net, x, t, N, NI, NO, 32);
+    net_compute(net, x, out);
+    CHECK(st == NULL && net_get_stats(net) == NULL,
+          "counters without NERVENET_PROFILE");
+    CHECK(net_fprint_stats(stdout, net, NERVENET_STATS_JSON) ==
+              NERVENET_ERROR_INVALID_PARAM, "printed counters that are not kept");
+#endif
+    net_free(net);
+    end();
+}
+
 /* ── Persistence tests ──────────────────────────────────────────────────── */
 
 static void test_save_load_roundtrip(void)
@@ -608,6 +1322,1015 @@ static void test_save_load_roundtrip(void)
     end();
 }
 
+static void test_text_v2_roundtrip(void)
+{
+    static const float odd[] = { 0.0f, -0.0f, 1e-45f, -1.17549435e-38f,
+                                 3.4028235e38f, 0.1f, -1e-5f, 123456792.0f };
+    network_t *net, *back, *two;
+    const char *txt = "test_v2.net";
+    char line[16];
+    float w;
+    int i, ok;
+    FILE *f;
+
+    begin("text v2 round-trips weights and config exactly");
+    nerve_seed(31);
+    net = net_allocate(4, 5, 7, 6, 3);
+    net_set_activation(net, NERVENET_ACTIVATION_LEAKY_RELU);
+    net_set_classification(net);
+    net_set_optimizer(net, NERVENET_OPTIMIZER_ADAMW);
+    net_set_l2_lambda(net, 1e-4f);
+    net_set_weight_decay(net, 0.01f);
+    net_set_dropout(net, 0.3f);
+    net_set_learning_rate(net, 0.00123f);
+    net_use_bias(net, 0);
+    net_initialize_he(net);
+    for (i = 0; i < (int)(sizeof(odd) / sizeof(odd[0])); i++)
+        net->layer[1].weight[i] = odd[i];
+    CHECK(net_save(txt, net) == 0, "net_save failed");
+    back = net_load(txt);
+    CHECK(back != NULL, "net_load returned NULL");
+    if (back) {
+        CHECK(back->block_floats == net->block_floats &&
+              memcmp(back->weight_block, net->weight_block,
+                     (size_t)net->block_floats * sizeof(float)) == 0,
+              "weights are not bit-exact");
+        CHECK(back->activation == net->activation &&
+              back->output_activation == net->output_activation &&
+              back->loss == net->loss && back->optimizer == net->optimizer &&
+              back->adam_m != NULL,
+              "activations, loss or optimizer lost");
+        CHECK(back->learning_rate == net->learning_rate &&
+              back->l2_lambda == net->l2_lambda &&
+              back->weight_decay == net->weight_decay &&
+              back->dropout_rate == net->dropout_rate &&
+              back->momentum == net->momentum,
+              "hyper-parameters lost");
+        CHECK(back->input_layer->neuron[5].output == 0.0f,
+              "the bias switch was lost");
+        net_free(back);
+    }
+    end();
+
+    begin("net_fscan reads v1, skips unknown keys, stops");
+    f = fopen(txt, "w");
+    fprintf(f, "3\n2\n3\n1\n%f\n%f\n%f\n", 0.25, 0.5, 0.0);
+    for (i = 0; i < 3 * 3 + 4; i++) fprintf(f, "%f\n", (i - 6) * 0.125);
+    fclose(f);
+    back = net_load(txt);
+    CHECK(back != NULL, "a v1 file did not load");
+    if (back) {
+        for (ok = 1, i = 0; i < 3 * 3; i++)
+            if (back->layer[1].weight[i] != (i - 6) * 0.125f) ok = 0;
+        for (i = 0; i < 4; i++)
+            if (back->layer[2].weight[i] != (i + 3) * 0.125f) ok = 0;
+        CHECK(ok && back->learning_rate == 0.5f && back->momentum == 0.25f,
+              "v1 values differ");
+        net_free(back);
+    }
+
+    /* CRLF lines, then a second network, then text that is not ours: each
+     * net_fscan must stop at the end of its network's last line. */
+    f = fopen(txt, "wb");
+    fprintf(f, "nerve 2\r\nlayers 2 1 1\r\nfuture_key 1 2 3\r\nbias 1\r\n"
+               "weights\r\n0.75 -2\r\n");
+    CHECK(net_fprint(f, net) == 0, "net_fprint failed");
+    fprintf(f, "trailer\n");
+    fclose(f);
+    f = fopen(txt, "rb");
+    back = net_fscan(f);
+    two  = net_fscan(f);
+    CHECK(fgets(line, sizeof(line), f) && strcmp(line, "trailer\n") == 0,
+          "the stream was not left just past the second network");
+    fclose(f);
+    CHECK(back && net_get_no_of_weights(back) == 2, "the first network");
+    w = back ? back->layer[1].weight[0] : 0.0f;
+    CHECK(w == 0.75f, "first weight %g", (double)w);
+    CHECK(two && memcmp(two->weight_block, net->weight_block,
+                        (size_t)net->block_floats * sizeof(float)) == 0,
+          "the second network in the stream differs");
+    if (back) net_free(back);
+    if (two) net_free(two);
+    net_free(net);
+    remove(txt);
+    end();
+}
+
+static void test_binary_v2_and_map(void)
+{
+    network_t *net, *back, *mapped;
+    float x[4] = { 0.2f, 0.4f, -0.6f, 0.8f };
+    float a[3], b[3], c[3], w;
+    const char *bin = "test_v2.bin";
+    unsigned long before, after;
+    int l, ok, sizes[3] = { 4, 6, 3 }, layers = 3;
+    FILE *f;
+
+    begin("net_bsave keeps the config; net_map is bit-exact");
+    nerve_seed(13);
+    net = net_allocate(3, 4, 6, 3);
+    net_set_activation(net, NERVENET_ACTIVATION_TANH);
+    net_set_classification(net);
+    net_set_optimizer(net, NERVENET_OPTIMIZER_ADAMW);
+    net_set_l2_lambda(net, 0.125f);
+    net_initialize_xavier(net);
+    net_compute(net, x, a);
+    CHECK(net_bsave(bin, net) == 0, "net_bsave failed");
+    nerve_seed(99);
+    before = nerve_rand_u32();
+    nerve_seed(99);
+    back   = net_bload(bin);
+    mapped = net_map(bin);
+    after  = nerve_rand_u32();
+    CHECK(before == after, "loading a network drew from the RNG");
+    CHECK(back && mapped, "net_bload or net_map returned NULL");
+    if (back && mapped) {
+        CHECK(back->activation == NERVENET_ACTIVATION_TANH &&
+              back->output_activation == NERVENET_ACTIVATION_SOFTMAX &&
+              back->loss == NERVENET_LOSS_CROSS_ENTROPY &&
+              back->optimizer == NERVENET_OPTIMIZER_ADAMW &&
+              back->adam_m != NULL && back->l2_lambda == 0.125f,
+              "configuration did not survive the round-trip");
+        net_compute(back, x, b);
+        net_compute(mapped, x, c);
+        CHECK(memcmp(a, b, sizeof(a)) == 0 && memcmp(a, c, sizeof(a)) == 0,
+              "outputs differ after net_bload/net_map");
+        for (ok = 1, l = 1; l < mapped->no_of_layers; l++)
+            if ((size_t)mapped->layer[l].weight % 64) ok = 0;
+        CHECK(ok, "mapped layer weights are not 64-byte aligned");
+        net_set_weight(mapped, 1, 0, 0, 42.0f);   /* copy-on-write */
+    }
+    if (mapped) net_free(mapped);
+    if (back) net_free(back);
+    back = net_bload(bin);
+    CHECK(back && net_get_weight(back, 1, 0, 0) != 42.0f,
+          "writing a mapped network changed the file");
+    if (back) net_free(back);
+    end();
+
+    begin("net_bload rejects a corrupted weight block");
+    f = fopen(bin, "r+b");
+    CHECK(f != NULL, "cannot reopen %s", bin);
+    if (f) {
+        fseek(f, -4L, SEEK_END);
+        w = 3.0f;
+        fwrite(&w, sizeof(w), 1, f);
+        fclose(f);
+    }
+    back = net_bload(bin);
+    CHECK(back == NULL, "a corrupted file loaded");
+    if (back) net_free(back);
+    end();
+
+    begin("net_bload and net_map reject a corrupted header");
+    net_bsave(bin, net);
+    f = fopen(bin, "r+b");
+    CHECK(f != NULL, "cannot reopen %s", bin);
+    if (f) {                                      /* activation := 99 */
+        l = 99;
+        fseek(f, 4L + 4L * (long)sizeof(int), SEEK_SET);
+        fwrite(&l, sizeof(l), 1, f);
+        fclose(f);
+    }
+    back   = net_bload(bin);
+    mapped = net_map(bin);
+    CHECK(back == NULL && mapped == NULL, "an out-of-range activation loaded");
+    if (back) net_free(back);
+    if (mapped) net_free(mapped);
+    net_bsave(bin, net);
+    f = fopen(bin, "r+b");
+    if (f) {                                      /* learning rate := 3 */
+        w = 3.0f;
+        fseek(f, 4L + 11L * (long)sizeof(int), SEEK_SET);
+        fwrite(&w, sizeof(w), 1, f);
+        fclose(f);
+    }
+    back = net_bload(bin);
+    CHECK(back == NULL, "a corrupted learning rate passed the checksum");
+    if (back) net_free(back);
+    end();
+
+    begin("net_bload still reads version-1 files");
+    f = fopen(bin, "wb");
+    CHECK(f != NULL, "cannot rewrite %s", bin);
+    if (f) {
+        fwrite(&layers, sizeof(int), 1, f);
+        fwrite(sizes, sizeof(int), 3, f);
+        fwrite(&net->momentum, sizeof(float), 1, f);
+        fwrite(&net->learning_rate, sizeof(float), 1, f);
+        fwrite(&net->global_error, sizeof(float), 1, f);
+        for (l = 1; l < 3; l++)
+            fwrite(net->layer[l].weight, sizeof(float),
+                   (size_t)sizes[l] * (size_t)(sizes[l - 1] + 1), f);
+        fclose(f);
+    }
+    back = net_bload(bin);
+    CHECK(back != NULL, "version-1 file did not load");
+    if (back) {
+        back->activation = net->activation;
+        back->output_activation = net->output_activation;
+        net_compute(back, x, b);
+        CHECK(memcmp(a, b, sizeof(a)) == 0, "version-1 weights differ");
+        net_free(back);
+    }
+    remove(bin);
+    net_free(net);
+    end();
+}
+
+static int file_exists(const char *fn)
+{
+    FILE *f = fopen(fn, "rb");
+    if (f) fclose(f);
+    return f != NULL;
+}
+
+static void test_checkpoint_resumes_exactly(void)
+{
+    enum { N = 64, IN = 6, H = 12, OUT = 3 };
+    static float x[N * IN], y[N * OUT];
+    network_t *net, *back, *plain;
+    nerve_checkpoint_t *ck;
+    nerve_rng_t rng, rng2;
+    char fn[64];
+    int i, n, same;
+
+    begin("a checkpoint resumes training bit for bit");
+    nerve_seed(21);
+    for (i = 0; i < N * IN; i++) x[i] = 2.0f * nerve_rand_float() - 1.0f;
+    for (i = 0; i < N * OUT; i++) y[i] = (i % OUT == (i / OUT) % OUT) ? 1.0f : 0.0f;
+    net = net_allocate(3, IN, H, OUT);
+    net_set_optimizer(net, NERVENET_OPTIMIZER_ADAM);
+    net_set_classification(net);
+    net_set_dropout(net, 0.25f);
+    net_set_prune_schedule(net, 0.5f, 6);
+    net_set_learning_rate(net, 0.01f);
+    nerve_rng_seed(&rng, 7);
+    net_initialize_xavier_r(net, &rng);
+    for (i = 0; i < 3; i++) net_train_epoch_r(net, x, y, N, IN, OUT, 8, &rng);
+
+    ck = net_checkpoint_open("test_ckpt", 2);
+    CHECK(ck != NULL, "net_checkpoint_open failed");
+    if (!ck) { net_free(net); end(); return; }
+    n = net_checkpoint_save(ck, net, &rng);
+    CHECK(n == 1, "first checkpoint is number %d", n);
+    /* Training right away must not disturb the snapshot being written. */
+    for (i = 0; i < 3; i++) net_train_epoch_r(net, x, y, N, IN, OUT, 8, &rng);
+    CHECK(net_checkpoint_wait(ck) == 0, "checkpoint write failed");
+
+    back = net_checkpoint_load("test_ckpt-000001.nrvb", &rng2);
+    CHECK(back != NULL, "net_checkpoint_load returned NULL");
+    for (i = 0; back && i < 3; i++)
+        net_train_epoch_r(back, x, y, N, IN, OUT, 8, &rng2);
+    same = back && memcmp(back->weight_block, net->weight_block,
+                          (size_t)net->block_floats * sizeof(float)) == 0;
+    CHECK(same, "resumed training diverged from the uninterrupted run");
+    CHECK(back && rng2.s[0] == rng.s[0] && rng2.s[3] == rng.s[3],
+          "the RNG stream did not resume where it left off");
+
+    plain = net_bload("test_ckpt-000001.nrvb");
+    CHECK(plain != NULL, "net_bload cannot read a checkpoint");
+    if (plain) net_free(plain);
+
+    for (i = 0; i < 3; i++) n = net_checkpoint_save(ck, net, NULL);
+    CHECK(n == 4 && net_checkpoint_wait(ck) == 0, "later saves failed");
+    for (i = 1; i <= 4; i++) {
+        sprintf(fn, "test_ckpt-%06d.nrvb", i);
+        CHECK(file_exists(fn) == (i > 2), "checkpoint %d %s", i,
+              i > 2 ? "is missing" : "was not rotated out");
+        remove(fn);
+        strcat(fn, ".tmp");
+        CHECK(!file_exists(fn), "%s left behind", fn);
+    }
+
+    /* Both slots now hold Adam moments; once the net drops them, so must
+     * the snapshots, or the checkpoint would resume as Adam. */
+    net_set_optimizer(net, NERVENET_OPTIMIZER_SGD);
+    net_checkpoint_save(ck, net, NULL);
+    n = net_checkpoint_save(ck, net, NULL);
+    CHECK(n == 6 && net_checkpoint_wait(ck) == 0, "SGD saves failed");
+    if (back) net_free(back);
+    back = net_checkpoint_load("test_ckpt-000006.nrvb", NULL);
+    CHECK(back && !back->adam_m && back->optimizer == NERVENET_OPTIMIZER_SGD,
+          "stale Adam moments written after switching to SGD");
+    remove("test_ckpt-000005.nrvb");
+    remove("test_ckpt-000006.nrvb");
+    net_checkpoint_close(ck);
+    if (back) net_free(back);
+    net_free(net);
+    end();
+}
+
+static void put_be32(FILE *f, unsigned v)
+{
+    fputc((int)(v >> 24), f); fputc((int)(v >> 16) & 255, f);
+    fputc((int)(v >> 8) & 255, f); fputc((int)v & 255, f);
+}
+
+static void test_dataset_streams_samples(void)
+{
+    enum { N = 50, H = 3, W = 4, D = H * W, C = 3, B = 8 };
+    static unsigned char px[N * D], lab[N];
+    static float x[N * D], y[N * C];
+    const char *img = "test_ds.idx3", *lbl = "test_ds.idx1";
+    const char *csv = "test_ds.csv", *raw = "test_ds.raw";
+    nerve_dataset_t *ds, *dc;
+    const float *in, *tg, *in2, *tg2;
+    network_t *a, *b;
+    nerve_rng_t ra, rb;
+    int i, k, m, n, pass, ok, seen[N], moved;
+    float la, lb, err;
+    FILE *f;
+
+    for (i = 0; i < N * D; i++) px[i] = (unsigned char)(i * 37 + 11);
+    for (i = 0; i < N; i++) {
+        lab[i] = (unsigned char)(i % C);
+        px[i * D] = (unsigned char)i;               /* tags the sample */
+    }
+    for (i = 0; i < N * D; i++) x[i] = px[i] / 255.0f;
+    for (i = 0; i < N * C; i++) y[i] = i % C == lab[i / C] ? 1.0f : 0.0f;
+    f = fopen(img, "wb");
+    put_be32(f, 0x803); put_be32(f, N); put_be32(f, H); put_be32(f, W);
+    fwrite(px, 1, sizeof(px), f); fclose(f);
+    f = fopen(lbl, "wb");
+    put_be32(f, 0x801); put_be32(f, N);
+    fwrite(lab, 1, sizeof(lab), f); fclose(f);
+
+    begin("nerve_dataset_idx streams batches in file order");
+    ds = nerve_dataset_idx(img, lbl);
+    CHECK(ds != NULL, "nerve_dataset_idx returned NULL");
+    if (!ds) { end(); return; }
+    CHECK(nerve_dataset_inputs(ds) == D && nerve_dataset_outputs(ds) == C,
+          "dataset is %d -> %d", nerve_dataset_inputs(ds),
+          nerve_dataset_outputs(ds));
+    for (pass = 0; pass < 2; pass++) {
+        n = 0; ok = 1;
+        while ((m = nerve_dataset_next(ds, B, &in, &tg)) > 0) {
+            if (m != (N - n < B ? N - n : B)) ok = 0;
+            if (memcmp(in, x + n * D, (size_t)m * D * sizeof(float)) ||
+                memcmp(tg, y + n * C, (size_t)m * C * sizeof(float))) ok = 0;
+            n += m;
+        }
+        CHECK(m == 0 && n == N && ok, "pass %d: %d samples, ok %d", pass, n, ok);
+    }
+    end();
+
+    begin("the shuffle buffer yields a permutation");
+    nerve_dataset_shuffle(ds, 16, 5);
+    memset(seen, 0, sizeof(seen));
+    n = 0; moved = 0;
+    while ((m = nerve_dataset_next(ds, B, &in, &tg)) > 0)
+        for (k = 0; k < m; k++, n++) {
+            i = (int)(in[k * D] * 255.0f + 0.5f);
+            if (i >= 0 && i < N) seen[i]++;
+            if (i != n) moved++;
+            if (i < 0 || i >= N || tg[k * C + lab[i]] != 1.0f) seen[0] = -N;
+        }
+    for (ok = n == N, i = 0; i < N; i++) if (seen[i] != 1) ok = 0;
+    CHECK(ok, "every sample once, with its own label");
+    CHECK(moved > N / 2, "only %d of %d samples moved", moved, N);
+    nerve_dataset_free(ds);
+    end();
+
+    begin("CSV and raw sources read the same samples");
+    f = fopen(csv, "w");
+    fprintf(f, "a,b,c,d,e,f,g,h,i,j,k,l,y0,y1,y2\n\n");
+    for (i = 0; i < N; i++) {
+        for (k = 0; k < D + C; k++)
+            fprintf(f, k ? ", %.9g" : "%.9g",
+                    (double)(k < D ? x[i * D + k] : y[i * C + k - D]));
+        fputc('\n', f);
+    }
+    fclose(f);
+    f = fopen(raw, "wb");
+    for (i = 0; i < N; i++) {
+        fwrite(x + i * D, sizeof(float), D, f);
+        fwrite(y + i * C, sizeof(float), C, f);
+    }
+    fclose(f);
+    ds = nerve_dataset_csv(csv, D, C);
+    dc = nerve_dataset_raw(raw, D, C, NERVENET_DATA_F32);
+    CHECK(ds && dc, "nerve_dataset_csv or _raw returned NULL");
+    n = 0; ok = 1;
+    while (ds && dc && (m = nerve_dataset_next(ds, B, &in, &tg)) > 0) {
+        if (nerve_dataset_next(dc, B, &in2, &tg2) != m ||
+            memcmp(in, in2, (size_t)m * D * sizeof(float)) ||
+            memcmp(tg, tg2, (size_t)m * C * sizeof(float)) ||
+            memcmp(in, x + n * D, (size_t)m * D * sizeof(float))) ok = 0;
+        n += m;
+    }
+    CHECK(ok && n == N, "sources disagree after %d samples", n);
+    end();
+
+    begin("net_train_dataset matches net_train_epoch");
+    nerve_seed(22);
+    a = net_allocate(3, D, 6, C);
+    net_set_classification(a);
+    net_set_learning_rate(a, 0.1f);
+    b = net_copy(a);
+    nerve_rng_seed(&ra, 3);
+    rb = ra;
+    for (i = 0; i < 3; i++) {
+        la = net_train_epoch_r(a, x, y, N, D, C, N, &ra);
+        lb = ds ? net_train_dataset_r(b, ds, N, &rb) : 0.0f;
+    }
+    for (err = 0.0f, i = 0; i < a->block_floats; i++)
+        if (fabsf(a->weight_block[i] - b->weight_block[i]) > err)
+            err = fabsf(a->weight_block[i] - b->weight_block[i]);
+    CHECK(err < 1e-5f && fabsf(la - lb) < 1e-5f,
+          "full-batch weights differ by %g, loss %g vs %g",
+          (double)err, (double)la, (double)lb);
+    net_free(a); net_free(b);
+    nerve_dataset_free(ds);
+    nerve_dataset_free(dc);
+    end();
+
+    begin("nerve_dataset_idx rejects a sample too wide for an int");
+    f = fopen(img, "wb");
+    put_be32(f, 0x803); put_be32(f, N); put_be32(f, 65536); put_be32(f, 65536);
+    fclose(f);
+    ds = nerve_dataset_idx(img, lbl);
+    CHECK(ds == NULL, "a 65536 x 65536 sample was accepted");
+    if (ds) nerve_dataset_free(ds);
+    remove(img); remove(lbl); remove(csv); remove(raw);
+    end();
+}
+
+static void test_raw_input_matches_float(void)
+{
+    enum { N = 150, D = 12, C = 3 };
+    static unsigned char px[N * D];
+    static short sx[N * D];
+    static float x[N * D], y[N * C], oa[N * C], ob[N * C];
+    const char *img = "test_raw.idx3";
+    float scale[D], offset[D], err;
+    nerve_input_t u8 = { NERVENET_DATA_U8, NULL, NULL };
+    nerve_input_t i16 = { NERVENET_DATA_I16, NULL, NULL };
+    nerve_idx_t idx;
+    network_t *a, *b;
+    nerve_rng_t ra, rb;
+    int i, j, bias, ok;
+    FILE *f;
+
+    for (j = 0; j < D; j++) {
+        scale[j]  = (1.0f + (float)j / D) / 255.0f;
+        offset[j] = 0.25f - 0.05f * (float)j;
+    }
+    for (i = 0; i < N * D; i++) {
+        j = i % D;
+        px[i] = (unsigned char)(i * 73 + 5);
+        sx[i] = (short)((i * 7919) % 20001 - 10000);
+        x[i]  = (float)px[i] * scale[j] + offset[j];
+    }
+    for (i = 0; i < N * C; i++) y[i] = i % C == (i / C) % C ? 1.0f : 0.0f;
+    u8.scale = scale; u8.offset = offset;
+
+    begin("net_compute_raw reads bytes as scale*x+offset");
+    nerve_seed(23);
+    a = net_allocate(4, D, 9, 7, C);
+    net_set_classification(a);
+    net_initialize_xavier(a);
+    for (ok = 1, i = 0; i < N; i++) {
+        net_compute_raw(a, &u8, px + i * D, oa);
+        net_compute(a, x + i * D, ob);
+        if (memcmp(oa, ob, C * sizeof(float))) ok = 0;
+    }
+    CHECK(ok, "uint8 forward differs from the float forward");
+    for (ok = 1, i = 0; i < N; i++) {
+        float xs[D];
+        for (j = 0; j < D; j++) xs[j] = (float)sx[i * D + j];
+        net_compute_raw(a, &i16, sx + i * D, oa);
+        net_compute(a, xs, ob);
+        if (memcmp(oa, ob, C * sizeof(float))) ok = 0;
+    }
+    CHECK(ok, "int16 forward differs from the float forward");
+    end();
+
+    begin("batched raw inference folds into the first layer");
+    for (bias = 1; bias >= 0; bias--) {
+        net_use_bias(a, bias);
+        net_compute_batch_raw(a, &u8, px, N, oa);
+        net_compute_batch(a, x, N, ob);
+        for (err = 0.0f, i = 0; i < N * C; i++)
+            if (fabsf(oa[i] - ob[i]) > err) err = fabsf(oa[i] - ob[i]);
+        CHECK(err < 1e-5f, "bias %d: folded outputs differ by %g",
+              bias, (double)err);
+    }
+    net_use_bias(a, 1);
+    CHECK(net_compute_accuracy_raw(a, &u8, px, y, N, D, C) ==
+          net_compute_accuracy(a, x, y, N, D, C),
+          "raw accuracy differs from float accuracy");
+    end();
+
+    begin("net_train_epoch_raw matches net_train_epoch");
+    net_set_learning_rate(a, 0.05f);
+    net_set_threads(a, 2);
+    b = net_copy(a);
+    nerve_rng_seed(&ra, 9);
+    rb = ra;
+    for (i = 0; i < 3; i++) {
+        net_train_epoch_raw_r(a, &u8, px, y, N, D, C, 16, &ra);
+        net_train_epoch_r(b, x, y, N, D, C, 16, &rb);
+    }
+    CHECK(memcmp(a->weight_block, b->weight_block,
+                 (size_t)a->block_floats * sizeof(float)) == 0,
+          "weights differ after raw training");
+    net_free(a); net_free(b);
+    end();
+
+    begin("nerve_idx_map exposes the bytes in place");
+    f = fopen(img, "wb");
+    put_be32(f, 0x803); put_be32(f, N); put_be32(f, 3); put_be32(f, 4);
+    fwrite(px, 1, sizeof(px), f); fclose(f);
+    CHECK(nerve_idx_map(&idx, img) == NERVENET_SUCCESS, "nerve_idx_map failed");
+    CHECK(idx.count == N && idx.width == D, "mapped %d x %d",
+          idx.count, idx.width);
+    CHECK(idx.data && memcmp(idx.data, px, sizeof(px)) == 0,
+          "mapped bytes differ from the file");
+    nerve_idx_unmap(&idx);
+    CHECK(idx.data == NULL, "nerve_idx_unmap left data set");
+    f = fopen(img, "wb");
+    put_be32(f, 0x803); put_be32(f, N); put_be32(f, 3); put_be32(f, 4);
+    fwrite(px, 1, 10, f); fclose(f);
+    CHECK(nerve_idx_map(&idx, img) == NERVENET_ERROR_CORRUPT,
+          "a truncated file was accepted");
+    CHECK(nerve_idx_map(&idx, "no_such_file.idx3") == NERVENET_ERROR_IO,
+          "a missing file was not an I/O error");
+    remove(img);
+    end();
+}
+
+static void test_population_matches_networks(void)
+{
+    enum { N = 37, IN = 5, H = 7, OUT = 3 };
+    static float x[N * IN], y[N * OUT];
+    network_t *tmpl, *net[N], *got;
+    net_population_t *pop;
+    float o[OUT], err = 0.0f, w;
+    int pa[N], pb[N], i, k, g, ok;
+
+    begin("population members match net_initialize_xavier");
+    tmpl = net_allocate(3, IN, H, OUT);
+    net_set_activation(tmpl, NERVENET_ACTIVATION_TANH);
+    net_set_output_activation(tmpl, NERVENET_ACTIVATION_SOFTMAX);
+    for (i = 0; i < N; i++) {
+        net[i] = net_allocate(3, IN, H, OUT);
+        net_set_activation(net[i], NERVENET_ACTIVATION_TANH);
+        net_set_output_activation(net[i], NERVENET_ACTIVATION_SOFTMAX);
+    }
+    nerve_seed(41);
+    for (i = 0; i < N; i++) net_initialize_xavier(net[i]);
+    nerve_seed(41);
+    pop = net_population_allocate(tmpl, N);
+    CHECK(pop != NULL, "net_population_allocate returned NULL");
+    if (!pop) { end(); return; }
+    got = net_copy(tmpl);
+    for (ok = 1, i = 0; i < N; i++) {
+        net_population_get(pop, i, got);
+        for (g = 0; g < H; g++)
+            if (net_get_weight(got, 1, 0, g) != net_get_weight(net[i], 1, 0, g)) ok = 0;
+    }
+    CHECK(ok, "member weights differ from a Xavier-initialised network");
+    end();
+
+    begin("net_population_compute matches net_compute per member");
+    for (i = 0; i < N * IN; i++) x[i] = 2.0f * nerve_rand_float() - 1.0f;
+    net_population_compute(pop, x, y);
+    for (i = 0; i < N; i++) {
+        net_compute(net[i], x + i * IN, o);
+        for (k = 0; k < OUT; k++)
+            if (fabsf(o[k] - y[i * OUT + k]) > err) err = fabsf(o[k] - y[i * OUT + k]);
+    }
+    CHECK(err < 1e-6f, "population output off by %g", (double)err);
+    end();
+
+    begin("net_population_breed keeps elites, mixes parents");
+    for (i = 0; i < N; i++) { pa[i] = i % 3; pb[i] = 3 + i % 2; }
+    net_population_breed(pop, pa, pb, 3, 0.0f, 0.0f);
+    for (ok = 1, i = 0; i < N; i++) {
+        net_population_get(pop, i, got);
+        for (g = 0; g < H; g++) {
+            w = net_get_weight(got, 1, 0, g);
+            if (i < 3 ? w != net_get_weight(net[pa[i]], 1, 0, g)
+                      : w != net_get_weight(net[pa[i]], 1, 0, g) &&
+                        w != net_get_weight(net[pb[i]], 1, 0, g)) ok = 0;
+        }
+    }
+    CHECK(ok, "a child gene came from neither parent");
+    net_population_set(pop, 5, net[7]);
+    net_population_get(pop, 5, got);
+    net_compute(got, x, o);
+    net_compute(net[7], x, y);
+    CHECK(memcmp(o, y, sizeof(o)) == 0, "set/get did not round-trip member 5");
+    end();
+
+    begin("a bias-free template gives bias-free members");
+    net_population_free(pop);
+    net_use_bias(tmpl, 0);
+    nerve_seed(41);
+    pop = net_population_allocate(tmpl, N);
+    CHECK(pop != NULL, "net_population_allocate returned NULL");
+    if (!pop) { end(); return; }
+    net_population_compute(pop, x, y);
+    for (err = 0.0f, i = 0; i < N; i++) {
+        net_use_bias(net[i], 0);
+        net_compute(net[i], x + i * IN, o);
+        for (k = 0; k < OUT; k++)
+            if (fabsf(o[k] - y[i * OUT + k]) > err) err = fabsf(o[k] - y[i * OUT + k]);
+    }
+    CHECK(err < 1e-6f, "bias-free population output off by %g", (double)err);
+    end();
+
+    net_population_free(pop);
+    net_free(got);
+    net_free(tmpl);
+    for (i = 0; i < N; i++) net_free(net[i]);
+}
+
+static void test_quantized_tracks_float(void)
+{
+    enum { N = 200, IN = 8, H = 16, OUT = 4 };
+    static float x[N * IN], y[N * OUT];
+    network_t  *net;
+    qnetwork_t *q, *back;
+    float a[OUT], b[OUT], c[OUT], err = 0.0f, fa, qa;
+    const char *bin = "test_quantized.nrvq";
+    int i, k, exact = 1, bad = 99;
+    FILE *f;
+
+    begin("int8 net_qcompute stays close to net_compute");
+    nerve_seed(21);
+    net = net_allocate(4, IN, H, H, OUT);
+    net_set_activation(net, NERVENET_ACTIVATION_TANH);
+    net_set_output_activation(net, NERVENET_ACTIVATION_SOFTMAX);
+    net_initialize_xavier(net);
+    for (i = 0; i < N * IN; i++) x[i] = 2.0f * nerve_rand_float() - 1.0f;
+    for (i = 0; i < N; i++) {
+        net_compute(net, x + i * IN, a);
+        for (k = 0; k < OUT; k++) y[i * OUT + k] = a[k];
+    }
+    q = net_quantize(net);
+    CHECK(q != NULL, "net_quantize returned NULL");
+    for (i = 0; q && i < N; i++) {
+        net_compute(net, x + i * IN, a);
+        net_qcompute(q, x + i * IN, b);
+        for (k = 0; k < OUT; k++)
+            if (fabsf(a[k] - b[k]) > err) err = fabsf(a[k] - b[k]);
+    }
+    CHECK(err < 0.02f, "int8 output drifted by %g", (double)err);
+    end();
+
+    begin("int8 accuracy delta is small");
+    fa = net_compute_accuracy(net, x, y, N, IN, OUT);
+    qa = q ? net_qcompute_accuracy(q, x, y, N, IN, OUT) : 0.0f;
+    CHECK(fa == 1.0f && fa - qa <= 0.05f,
+          "float %.3f vs int8 %.3f", (double)fa, (double)qa);
+    end();
+
+    begin("net_qsave/net_qload round-trips exactly");
+    CHECK(q && net_qsave(bin, q) == 0, "net_qsave failed");
+    back = net_qload(bin);
+    CHECK(back != NULL, "net_qload returned NULL");
+    for (i = 0; q && back && i < N; i++) {
+        net_qcompute(q, x + i * IN, b);
+        net_qcompute(back, x + i * IN, c);
+        for (k = 0; k < OUT; k++) if (b[k] != c[k]) exact = 0;
+    }
+    CHECK(exact, "reloaded int8 network disagrees");
+    net_qfree(back);
+    end();
+
+    begin("net_qload rejects an unknown activation");
+    f = fopen(bin, "r+b");
+    CHECK(f != NULL, "cannot reopen %s", bin);
+    if (f) {
+        /* magic, version, layer count, four sizes, then the activation */
+        fseek(f, 4L + 6L * (long)sizeof(int), SEEK_SET);
+        fwrite(&bad, sizeof(bad), 1, f);
+        fclose(f);
+    }
+    back = net_qload(bin);
+    CHECK(back == NULL, "an out-of-range activation loaded");
+    remove(bin);
+    net_qfree(back);
+    net_qfree(q);
+    net_free(net);
+    end();
+}
+
+static int count_zero_weights(const network_t *net)
+{
+    int l, u, j, nl, zeros = 0;
+    for (l = 1; l < net->no_of_layers; l++) {
+        nl = net->layer[l - 1].no_of_neurons;
+        for (u = 0; u < net->layer[l].no_of_neurons; u++)
+            for (j = 0; j < nl; j++)
+                if (net->layer[l].weight[u * (nl + 1) + j] == 0.0f) zeros++;
+    }
+    return zeros;
+}
+
+static void test_pruned_sparse_matches_dense(void)
+{
+    enum { N = 100, IN = 20, H1 = 64, H2 = 32, OUT = 5 };
+    static float x[N * IN], y[N * OUT];
+    const int total = H1 * IN + H2 * H1 + OUT * H2;
+    const int want  = (int)(0.8f * (float)(H1 * IN)) +
+                      (int)(0.8f * (float)(H2 * H1)) +
+                      (int)(0.8f * (float)(OUT * H2));
+    network_t  *net;
+    snetwork_t *s, *back;
+    float a[OUT], b[OUT], c[OUT], err = 0.0f;
+    const char *bin = "test_sparse.nrvs";
+    int i, k, pruned, exact = 1, bad = -1;
+    FILE *f;
+
+    begin("net_prune + net_scompute match the dense pass");
+    nerve_seed(16);
+    net = net_allocate(4, IN, H1, H2, OUT);
+    net_set_activation(net, NERVENET_ACTIVATION_RELU);
+    net_set_classification(net);
+    net_initialize_he(net);
+    for (i = 0; i < N * IN; i++) x[i] = 2.0f * nerve_rand_float() - 1.0f;
+    for (i = 0; i < N * OUT; i++) y[i] = (i % OUT == (i / OUT) % OUT) ? 1.0f : 0.0f;
+
+    pruned = net_prune(net, 0.8f);
+    CHECK(pruned == want, "pruned %d of %d weights, expected %d",
+          pruned, total, want);
+    CHECK(count_zero_weights(net) == pruned, "%d zero weights, %d pruned",
+          count_zero_weights(net), pruned);
+    s = net_sparsify(net);
+    CHECK(s != NULL && s->row_ptr[H1 + H2 + OUT] == total - pruned,
+          "CSR holds the wrong number of weights");
+    for (i = 0; s && i < N; i++) {
+        net_compute(net, x + i * IN, a);
+        net_scompute(s, x + i * IN, b);
+        for (k = 0; k < OUT; k++)
+            if (fabsf(a[k] - b[k]) > err) err = fabsf(a[k] - b[k]);
+    }
+    CHECK(err < 1e-5f, "sparse output drifted by %g", (double)err);
+
+    CHECK(s && net_ssave(bin, s) == 0, "net_ssave failed");
+    back = net_sload(bin);
+    CHECK(back != NULL, "net_sload returned NULL");
+    for (i = 0; s && back && i < N; i++) {
+        net_scompute(s, x + i * IN, b);
+        net_scompute(back, x + i * IN, c);
+        for (k = 0; k < OUT; k++) if (b[k] != c[k]) exact = 0;
+    }
+    CHECK(exact, "reloaded sparse network disagrees");
+    net_sfree(back);
+    end();
+
+    begin("net_sload rejects an unknown activation");
+    f = fopen(bin, "r+b");
+    CHECK(f != NULL, "cannot reopen %s", bin);
+    if (f) {
+        /* magic, version, layer count, four sizes, activation, then the
+         * output activation */
+        fseek(f, 4L + 7L * (long)sizeof(int), SEEK_SET);
+        fwrite(&bad, sizeof(bad), 1, f);
+        fclose(f);
+    }
+    back = net_sload(bin);
+    CHECK(back == NULL, "an out-of-range output activation loaded");
+    remove(bin);
+    net_sfree(back);
+    net_sfree(s);
+    net_free(net);
+    end();
+
+    begin("pruned weights stay zero through retraining");
+    nerve_seed(17);
+    net = net_allocate(4, IN, H1, H2, OUT);
+    net_set_activation(net, NERVENET_ACTIVATION_RELU);
+    net_set_classification(net);
+    net_set_optimizer(net, NERVENET_OPTIMIZER_ADAM);
+    net_initialize_he(net);
+    net_set_prune_schedule(net, 0.8f, 3);
+    for (i = 0; i < 3; i++) net_train_epoch(net, x, y, N, IN, OUT, 10);
+    CHECK(count_zero_weights(net) == want,
+          "schedule reached %d zeros, expected %d",
+          count_zero_weights(net), want);
+    for (i = 0; i < 3; i++) net_train_epoch(net, x, y, N, IN, OUT, 10);
+    CHECK(count_zero_weights(net) >= want,
+          "retraining revived pruned weights: %d zeros",
+          count_zero_weights(net));
+    net_free(net);
+    end();
+}
+
+static void test_half_tracks_float(void)
+{
+    enum { N = 100, IN = 20, H1 = 64, H2 = 32, OUT = 5 };
+    static const float tol[2] = { 2e-3f, 3e-2f };
+    static float x[N * IN];
+    network_t  *net;
+    hnetwork_t *h, *back;
+    float a[OUT], b[OUT], c[OUT], err;
+    const char *bin = "test_half.nrvh";
+    int i, k, f, exact;
+
+    begin("half conversion rounds and saturates like IEEE");
+    net = net_allocate(3, 2, 2, 1);
+    net->layer[1].weight[0] = 1.0f;
+    net->layer[1].weight[1] = 65504.0f;
+    net->layer[1].weight[3] = 65520.0f;
+    net->layer[1].weight[4] = 5.9604645e-8f;     /* 2^-24 */
+    h = net_half(net, NERVENET_HALF_FP16);
+    CHECK(h != NULL, "net_half returned NULL");
+    CHECK(h && h->weight[0] == 0x3C00, "fp16(1) = %#x", h ? h->weight[0] : 0);
+    CHECK(h && h->weight[1] == 0x7BFF, "fp16(65504) = %#x", h ? h->weight[1] : 0);
+    CHECK(h && h->weight[2] == 0x7C00, "fp16(65520) = %#x", h ? h->weight[2] : 0);
+    CHECK(h && h->weight[3] == 0x0001, "fp16(2^-24) = %#x", h ? h->weight[3] : 0);
+    net_hfree(h);
+    h = net_half(net, NERVENET_HALF_BF16);
+    CHECK(h && h->weight[0] == 0x3F80, "bf16(1) = %#x", h ? h->weight[0] : 0);
+    CHECK(h && h->weight[2] == 0x4780, "bf16(65520) = %#x", h ? h->weight[2] : 0);
+    net_hfree(h);
+    net_free(net);
+    end();
+
+    begin("net_hcompute tracks net_compute for fp16 and bf16");
+    nerve_seed(18);
+    net = net_allocate(4, IN, H1, H2, OUT);
+    net_set_activation(net, NERVENET_ACTIVATION_RELU);
+    net_initialize_he(net);
+    for (i = 0; i < N * IN; i++) x[i] = 2.0f * nerve_rand_float() - 1.0f;
+    for (f = NERVENET_HALF_FP16; f <= NERVENET_HALF_BF16; f++) {
+        h = net_half(net, (nervenet_half_t)f);
+        CHECK(h != NULL, "net_half(%d) returned NULL", f);
+        err = 0.0f;
+        for (i = 0; h && i < N; i++) {
+            net_compute(net, x + i * IN, a);
+            net_hcompute(h, x + i * IN, b);
+            for (k = 0; k < OUT; k++)
+                if (fabsf(a[k] - b[k]) > err) err = fabsf(a[k] - b[k]);
+        }
+        CHECK(err < tol[f], "format %d drifted by %g", f, (double)err);
+
+        CHECK(h && net_hsave(bin, h) == 0, "net_hsave failed");
+        back = net_hload(bin);
+        CHECK(back != NULL && back->format == f, "net_hload lost the format");
+        exact = 1;
+        for (i = 0; h && back && i < N; i++) {
+            net_hcompute(h, x + i * IN, b);
+            net_hcompute(back, x + i * IN, c);
+            for (k = 0; k < OUT; k++) if (b[k] != c[k]) exact = 0;
+        }
+        CHECK(exact, "reloaded half network disagrees (format %d)", f);
+        remove(bin);
+        net_hfree(back);
+        net_hfree(h);
+    }
+    net_free(net);
+    end();
+}
+
+/* Run net_export_c into a temporary file and hand back its text. */
+static char *export_text(const network_t *net, const char *name)
+{
+    FILE *f = tmpfile();
+    char *text = NULL;
+    long n;
+    if (!f) return NULL;
+    if (net_export_c(f, net, name) == 0 && (n = ftell(f)) > 0 &&
+        (text = malloc((size_t)n + 1)) != NULL) {
+        rewind(f);
+        text[fread(text, 1, (size_t)n, f)] = '\0';
+    }
+    fclose(f);
+    return text;
+}
+
+static void test_export_c(void)
+{
+    enum { IN = 40, H1 = 16, H2 = 8, OUT = 3 };
+    network_t *net;
+    char *text, *p, *stop;
+    const char *q;
+    int u, j, uses = 0, exact = 1;
+
+    begin("net_export_c writes exact weights and unrolls");
+    nerve_seed(19);
+    net = net_allocate(4, IN, H1, H2, OUT);
+    net_set_activation(net, NERVENET_ACTIVATION_RELU);
+    net_set_classification(net);
+    net_initialize_he(net);
+    net_set_weight(net, 2, 0, 0, 0.0f);     /* a pruned weight is dropped */
+    text = export_text(net, "brain");
+    CHECK(text != NULL, "net_export_c failed");
+    if (!text) { net_free(net); end(); return; }
+
+    CHECK(strstr(text, "void brain(const float *input, float *output)") != NULL,
+          "entry point missing");
+    CHECK(strstr(text, "static const float brain_w1[16][40]") != NULL,
+          "the 640-weight layer should be a table");
+    CHECK(strstr(text, "brain_w2") == NULL && strstr(text, "brain_w3") == NULL,
+          "the small layers should be unrolled");
+
+    /* The table round-trips every weight bit for bit. */
+    p = strstr(text, "brain_w1[16][40] = {");
+    if (p) p = strchr(p, '{');
+    for (u = 0; p && u < H1; u++)
+        for (j = 0; j < IN; j++) {
+            p += strcspn(p, "-0123456789.");
+            if (strtof(p, &stop) != net->layer[1].weight[u * (IN + 1) + j])
+                exact = 0;
+            p = stop + 1;
+        }
+    CHECK(p && exact, "exported weights do not round-trip");
+
+    for (q = text; (q = strstr(q, " * a[0]")) != NULL; q++) uses++;
+    CHECK(uses == H2 - 1, "a[0] feeds %d rows, expected %d", uses, H2 - 1);
+    free(text);
+
+    CHECK(export_text(net, "2fast") == NULL && export_text(net, "a-b") == NULL,
+          "invalid C identifiers were accepted");
+    net_free(net);
+    end();
+}
+
+static int inside(const void *p, const char *lo, size_t n)
+{
+    return (const char *)p >= lo && (const char *)p < lo + n;
+}
+
+static void test_arena_matches_heap(void)
+{
+    int sizes[4] = { 5, 9, 7, 3 }, i, l, ok;
+    float x[5] = { 0.3f, -0.1f, 0.7f, 0.2f, -0.5f };
+    float t[3] = { 0.0f, 1.0f, 0.0f };
+    float a[3], b[3];
+    size_t need;
+    char *buf;
+    network_t *heap, *arena;
+
+    begin("net_allocate_in carves everything from the buffer");
+    need = net_size_required(4, sizes, NERVENET_ARENA_ADAM);
+    buf  = (char *)malloc(need + 3);
+    CHECK(net_allocate_in(buf + 3, need - 1, 4, sizes,
+                          NERVENET_ARENA_ADAM) == NULL,
+          "a short buffer was accepted");
+    nerve_seed(31);
+    arena = net_allocate_in(buf + 3, need, 4, sizes, NERVENET_ARENA_ADAM);
+    CHECK(arena != NULL, "net_allocate_in returned NULL");
+    if (!arena) { free(buf); end(); return; }
+    net_set_optimizer(arena, NERVENET_OPTIMIZER_ADAM);
+    ok = inside(arena, buf, need + 3) && inside(arena->layer, buf, need + 3) &&
+         inside(arena->weight_block, buf, need + 3) &&
+         inside(arena->adam_v, buf, need + 3) &&
+         (size_t)arena->weight_block % 64 == 0;
+    for (l = 0; l < 4; l++)
+        ok = ok && inside(arena->layer[l].neuron, buf, need + 3);
+#if defined(NERVENET_PROFILE)
+    ok = ok && inside(arena->stats, buf, need + 3) &&
+         arena->stats->no_of_layers == 4;
+#endif
+    CHECK(ok, "a part of the network lies outside the buffer");
+    end();
+
+    begin("an arena network trains like a heap network");
+    nerve_seed(31);
+    heap = net_allocate_l(4, sizes);
+    net_set_optimizer(heap, NERVENET_OPTIMIZER_ADAM);
+    for (i = 0; i < 20; i++) {
+        net_compute(heap, x, a);  net_compute_output_error(heap, t);  net_train(heap);
+        net_compute(arena, x, b); net_compute_output_error(arena, t); net_train(arena);
+    }
+    net_compute(heap, x, a);
+    net_compute(arena, x, b);
+    CHECK(memcmp(a, b, sizeof(a)) == 0,
+          "arena (%f,%f,%f) vs heap (%f,%f,%f)", (double)b[0], (double)b[1],
+          (double)b[2], (double)a[0], (double)a[1], (double)a[2]);
+    end();
+
+    begin("an arena network refuses resizes and overwrites");
+    CHECK(net_add_neurons(arena, 1, -1, 2, 0.1f) == NERVENET_ERROR_INVALID_PARAM &&
+          net_remove_neurons(arena, 2, 0, 1) == NERVENET_ERROR_INVALID_PARAM,
+          "a resize of an arena network was not refused");
+    CHECK(net_overwrite(arena, heap) == NERVENET_ERROR_INVALID_PARAM,
+          "an overwrite of an arena network was not refused");
+    CHECK(arena->layer[1].no_of_neurons == 9 && arena->layer[2].no_of_neurons == 7 &&
+          inside(arena->weight_block, buf, need + 3),
+          "a refused resize changed the arena network");
+    net_compute(arena, x, a);
+    CHECK(memcmp(a, b, sizeof(a)) == 0, "a refused resize changed the outputs");
+    CHECK(net_add_neurons(heap, 1, -1, 2, 0.1f) == NERVENET_SUCCESS &&
+          net_remove_neurons(heap, 2, 0, 1) == NERVENET_SUCCESS &&
+          heap->layer[1].no_of_neurons == 11 && heap->layer[2].no_of_neurons == 6,
+          "a heap network did not resize");
+    CHECK(net_overwrite(heap, arena) == NERVENET_SUCCESS &&
+          heap->layer[1].no_of_neurons == 9 && !heap->arena_bytes,
+          "a heap network did not take an arena network's copy");
+    net_compute(heap, x, a);
+    CHECK(memcmp(a, b, sizeof(a)) == 0, "the overwritten heap network differs");
+    net_free(arena);                     /* a no-op: the buffer is ours */
+    net_free(heap);
+    free(buf);
+    end();
+}
+
 static void test_copy_is_independent(void)
 {
     network_t *net, *dup;
@@ -637,6 +2360,44 @@ static void test_copy_is_independent(void)
     end();
 }
 
+static void test_layer_storage_is_contiguous(void)
+{
+    network_t *net;
+    int l, nu, stride, bad_align = 0, bad_view = 0;
+
+    begin("layer weights live in aligned row-major blocks");
+    nerve_seed(41);
+    net = net_allocate(4, 7, 13, 5, 3);
+    net_set_optimizer(net, NERVENET_OPTIMIZER_ADAM);
+    for (l = 1; l < net->no_of_layers; l++) {
+        stride = net->layer[l - 1].no_of_neurons + 1;
+        if (((size_t)net->layer[l].weight & 63u) != 0 ||
+            ((size_t)net->layer[l].delta  & 63u) != 0 ||
+            ((size_t)net->layer[l].adam_m & 63u) != 0) bad_align++;
+        for (nu = 0; nu < net->layer[l].no_of_neurons; nu++)
+            if (net->layer[l].neuron[nu].weight !=
+                    net->layer[l].weight + nu * stride ||
+                net->layer[l].neuron[nu].delta !=
+                    net->layer[l].delta + nu * stride) bad_view++;
+    }
+    CHECK(bad_align == 0, "%d layer blocks are not 64-byte aligned", bad_align);
+    CHECK(bad_view == 0, "%d neuron rows do not view their layer block",
+          bad_view);
+
+    net_set_weight(net, 2, 4, 1, 3.25f);
+    CHECK(net->layer[2].weight[1 * 14 + 4] == 3.25f,
+          "net_set_weight did not land at row-major (1, 4)");
+    CHECK(net_get_weight(net, 2, 4, 1) == 3.25f,
+          "net_get_weight did not read row-major (1, 4)");
+    net_set_bias(net, 3, 2, -1.5f);
+    CHECK(net_get_weight(net, 3, 5, 2) == -1.5f,
+          "net_set_bias did not land in the output layer's bias column");
+    CHECK(net_get_bias(net, 3, 2) == -1.5f,
+          "net_get_bias did not read the output layer's bias");
+    net_free(net);
+    end();
+}
+
 static void test_validate_accepts_a_fresh_net(void)
 {
     network_t *net;
@@ -665,6 +2426,8 @@ int main(void)
     test_rng_golden_vector();
     test_rand_below_respects_its_bound();
     test_rand_below_is_unbiased();
+    test_rng_streams_and_jumps();
+    test_explicit_streams_leave_global_alone();
 
     printf("\n  initialisation\n");
     test_init_is_reproducible();
@@ -676,10 +2439,33 @@ int main(void)
     printf("\n  learning\n");
     test_xor_converges();
     test_softmax_is_a_distribution();
+    test_activations_within_bounds();
+    test_batch_matches_single();
+    test_sparse_matches_dense();
+    test_context_matches_compute();
+    test_simd_kernels_match_reference();
+    test_batched_sgd_matches_accumulation();
+    test_batched_adam_matches_reference();
+    test_sharded_training_is_deterministic();
+    test_dropout_is_inverted();
+    test_dropout_mask_is_per_tile();
+    test_profile_counts_the_work();
+    test_population_matches_networks();
 
     printf("\n  persistence and structure\n");
     test_save_load_roundtrip();
+    test_text_v2_roundtrip();
+    test_binary_v2_and_map();
+    test_checkpoint_resumes_exactly();
+    test_dataset_streams_samples();
+    test_raw_input_matches_float();
+    test_quantized_tracks_float();
+    test_pruned_sparse_matches_dense();
+    test_half_tracks_float();
+    test_export_c();
     test_copy_is_independent();
+    test_arena_matches_heap();
+    test_layer_storage_is_contiguous();
     test_validate_accepts_a_fresh_net();
 
     printf("\n  %d checks, %d failed\n\n", g_checks, g_failed);